@@ -11,27 +11,16 @@
 #include <span>
 #include <string>
 
-#include "detours.h"
-
+#include "hookregistry.h"
 #include "utils.h"
 
 namespace {
 
-uint64_t Fnv1aHash(std::wstring_view input) {
-  uint64_t hash = 14695981039346656037ULL;
-  auto bytes = std::as_bytes(std::span{input});
-  for (auto b : bytes) {
-    hash ^= static_cast<uint64_t>(b);
-    hash *= 1099511628211ULL;
-  }
-  return hash;
-}
-
 constexpr std::wstring_view APPID_PREFIX = L"ChromePlusNext.";
 const std::wstring& GetCustomAppUserModelID() {
   static const std::wstring custom_appid = [] {
     constexpr wchar_t hex[] = L"0123456789ABCDEF";
-    auto hash = Fnv1aHash(GetAppDir());
+    auto hash = Fnv1aHash(std::as_bytes(std::span{GetAppDir()}));
     std::wstring result{APPID_PREFIX};
     result.reserve(APPID_PREFIX.size() + 16);
     for (int i = 60; i >= 0; i -= 4) {
@@ -171,15 +160,12 @@ HRESULT WINAPI MySHGetPropertyStoreForWindow(HWND hwnd,
 }  // namespace
 
 void SetAppId() {
-  DetourTransactionBegin();
-  DetourUpdateThread(GetCurrentThread());
-  DetourAttach(
-      reinterpret_cast<LPVOID*>(&RawSetCurrentProcessExplicitAppUserModelID),
-      reinterpret_cast<void*>(MySetCurrentProcessExplicitAppUserModelID));
-  DetourAttach(reinterpret_cast<LPVOID*>(&RawSHGetPropertyStoreForWindow),
-               reinterpret_cast<void*>(MySHGetPropertyStoreForWindow));
-  auto status = DetourTransactionCommit();
-  if (status != NO_ERROR) {
-    DebugLog(L"SetAppId failed {}", status);
-  }
+  HookRegistry::Instance().Register(
+      L"SetAppId",
+      {{L"SetCurrentProcessExplicitAppUserModelID",
+        reinterpret_cast<void**>(&RawSetCurrentProcessExplicitAppUserModelID),
+        reinterpret_cast<void*>(MySetCurrentProcessExplicitAppUserModelID)},
+       {L"SHGetPropertyStoreForWindow",
+        reinterpret_cast<void**>(&RawSHGetPropertyStoreForWindow),
+        reinterpret_cast<void*>(MySHGetPropertyStoreForWindow)}});
 }
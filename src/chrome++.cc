@@ -3,12 +3,15 @@
 #include <psapi.h>
 #include <stdio.h>
 
+#include <string_view>
+
 #include "detours.h"
 
 #include "appid.h"
 #include "config.h"
 #include "green.h"
 #include "hijack.h"
+#include "hookregistry.h"
 #include "hotkey.h"
 #include "inputhook.h"
 #include "keymapping.h"
@@ -49,8 +52,15 @@ void ChromePlus() {
   // Suppress Chrome's false "out of date" upgrade notification.
   SuppressFalseUpgradeNotification();
 
+  // Attach every detour registered above at once.
+  HookRegistry::Instance().Commit();
+  HookRegistry::Instance().LogStatus();
+
   // Process the hotkey.
   GetHotkey();
+
+  // Reload the tab and key settings when chrome++.ini changes, if enabled.
+  config.WatchForChanges();
 }
 
 void ChromePlusCommand(LPWSTR param) {
@@ -63,6 +73,17 @@ void ChromePlusCommand(LPWSTR param) {
   }
 }
 
+// The `--type=` switch value, or "browser" for the process without one.
+static std::wstring_view GetProcessType(std::wstring_view command_line) {
+  constexpr std::wstring_view kTypeSwitch = L"--type=";
+  const size_t start = command_line.find(kTypeSwitch);
+  if (start == std::wstring_view::npos) {
+    return L"browser";
+  }
+  command_line.remove_prefix(start + kTypeSwitch.size());
+  return command_line.substr(0, command_line.find_first_of(L" \t\""));
+}
+
 int Loader() {
   // Only main interface.
   LPWSTR param = GetCommandLineW();
@@ -81,8 +102,22 @@ int Loader() {
     // renderer CHECK that config (content/renderer/render_frame_impl.cc) and
     // crash (#263). Other sub-process types never serve WebUI, so skip them.
     PakPatch();
+    HookRegistry::Instance().Commit();
   }
 
+  // Settings load on first use; child processes other than renderers should
+  // report none here.
+  DebugLog(L"Config: {} INI reads by startup in the {} process",
+           GetIniReadCount(), GetProcessType(param));
+  const ForwardStats& forward_stats = GetForwardStats();
+  LARGE_INTEGER frequency;
+  QueryPerformanceFrequency(&frequency);
+  DebugLog(L"Hijack: forwarded {} version.dll exports in {} transaction(s) "
+           L"({} retried): {} us",
+           forward_stats.forwarded, forward_stats.transactions,
+           forward_stats.retries,
+           forward_stats.ticks * 1000000 / frequency.QuadPart);
+
   // Return to the main function.
   return ExeMain();
 }
@@ -5,8 +5,10 @@
 
 class ComInitializer {
  public:
-  ComInitializer() {
-    const HRESULT hr = CoInitialize(nullptr);
+  // Single-threaded apartment by default; pass `COINIT_MULTITHREADED` for a
+  // worker thread in the MTA.
+  explicit ComInitializer(DWORD apartment = COINIT_APARTMENTTHREADED) {
+    const HRESULT hr = CoInitializeEx(nullptr, apartment);
     initialized_ = SUCCEEDED(hr) || hr == RPC_E_CHANGED_MODE;
     should_uninitialize_ = (hr == S_OK || hr == S_FALSE);
   }
@@ -2,11 +2,21 @@
 
 #include <windows.h>
 
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include "configsnapshot.h"
+#include "inifile.h"
+#include "livesettings.h"
 #include "utils.h"
 
 Config& Config::Instance() {
@@ -14,91 +24,217 @@ Config& Config::Instance() {
   return instance;
 }
 
-Config::Config() {
-  LoadConfig();
+Config::Config() = default;
+
+void Config::Load(Section section) const {
+  // The singleton is never const, and each section is written exactly once
+  // under its flag before any reader sees it.
+  auto* self = const_cast<Config*>(this);
+  std::call_once(loaded_[static_cast<size_t>(section)], [self, section] {
+    switch (section) {
+      case Section::kGeneral:
+        self->LoadGeneral();
+        break;
+      case Section::kLive:
+        self->PublishLive();
+        break;
+      case Section::kPakPatch:
+        self->LoadPakPatch();
+        break;
+      case Section::kCount:
+        break;
+    }
+  });
 }
 
-void Config::LoadConfig() {
-  // general
+void Config::LoadGeneral() {
   command_line_ = GetIniString(L"general", L"command_line", L"");
   launch_on_startup_ = GetIniString(L"general", L"launch_on_startup", L"");
   launch_on_exit_ = GetIniString(L"general", L"launch_on_exit", L"");
   user_data_dir_ = LoadDirPath(L"data");
   disk_cache_dir_ = LoadDirPath(L"cache");
   boss_key_ = GetIniString(L"general", L"boss_key", L"");
-  translate_key_ = GetIniString(L"general", L"translate_key", L"");
-  show_password_ = ::GetPrivateProfileIntW(L"general", L"show_password", 1,
-                                           GetIniPath().c_str()) != 0;
-  win32k_ = ::GetPrivateProfileIntW(L"general", L"win32k", 0,
-                                    GetIniPath().c_str()) != 0;
-  ignore_policies_ = ::GetPrivateProfileIntW(L"general", L"ignore_policies", 0,
-                                             GetIniPath().c_str()) != 0;
+  show_password_ = GetIniInt(L"general", L"show_password", 1) != 0;
+  win32k_ = GetIniInt(L"general", L"win32k", 0) != 0;
+  ignore_policies_ = GetIniInt(L"general", L"ignore_policies", 0) != 0;
   suppress_false_upgrade_notification_ =
-      ::GetPrivateProfileIntW(L"general",
-                              L"suppress_false_upgrade_notification", 0,
-                              GetIniPath().c_str()) != 0;
-
-  // tabs
-  keep_last_tab_ = ::GetPrivateProfileIntW(L"tabs", L"keep_last_tab", 1,
-                                           GetIniPath().c_str()) != 0;
-  double_click_close_ = ::GetPrivateProfileIntW(L"tabs", L"double_click_close",
-                                                1, GetIniPath().c_str()) != 0;
-  right_click_close_ = ::GetPrivateProfileIntW(L"tabs", L"right_click_close", 0,
-                                               GetIniPath().c_str()) != 0;
-  wheel_tab_ = ::GetPrivateProfileIntW(L"tabs", L"wheel_tab", 1,
-                                       GetIniPath().c_str()) != 0;
-  wheel_tab_when_press_rbutton_ =
-      ::GetPrivateProfileIntW(L"tabs", L"wheel_tab_when_press_rbutton", 1,
-                              GetIniPath().c_str()) != 0;
-  hover_tab_ = ::GetPrivateProfileIntW(L"tabs", L"hover_tab", 0,
-                                       GetIniPath().c_str()) != 0;
-  hover_tab_delay_ = LoadHoverTabDelay();
-  open_url_new_tab_ = LoadOpenUrlNewTabMode();
-  bookmark_new_tab_ = LoadBookmarkNewTabMode();
-  new_tab_disable_ = ::GetPrivateProfileIntW(L"tabs", L"new_tab_disable", 1,
-                                             GetIniPath().c_str()) != 0;
-  disable_tab_name_ = GetIniString(L"tabs", L"new_tab_disable_name", L"");
-  disable_tab_names_ = StringSplit(disable_tab_name_, L',', L"\"");
-
-  // keymapping
-  LoadKeyMappings();
+      GetIniInt(L"general", L"suppress_false_upgrade_notification", 0) != 0;
+  hot_reload_ = GetIniInt(L"general", L"hot_reload", 0) != 0;
+}
+
+void Config::LoadPakPatch() {
+  // A child takes the browser's rules from its snapshot and skips the INI.
+  const ConfigSnapshot* snapshot = Inherited();
+  if (!snapshot) {
+    pak_patch_rules_ = GetIniSection(L"pakpatch");
+    return;
+  }
+  static_assert(sizeof(wchar_t) == sizeof(char16_t));
+  auto to_wstring = [](std::u16string_view text) {
+    return std::wstring(reinterpret_cast<const wchar_t*>(text.data()),
+                        text.size());
+  };
+  pak_patch_rules_.reserve(snapshot->pak_patch_rule_count());
+  for (size_t i = 0; i < snapshot->pak_patch_rule_count(); ++i) {
+    const auto [key, value] = snapshot->pak_patch_rule(i);
+    pak_patch_rules_.emplace_back(to_wstring(key), to_wstring(value));
+  }
 }
 
-void Config::LoadKeyMappings() {
-  std::vector<wchar_t> buffer(4096);
-  const DWORD chars_read = ::GetPrivateProfileSectionW(
-      L"keymapping", buffer.data(), static_cast<DWORD>(buffer.size()),
-      GetIniPath().c_str());
+void Config::PublishLive() {
+  auto live = std::make_unique<LiveSettings>();
+  ReadIniFile([&](const IniFile& ini) { *live = ReadLiveSettings(ini); });
+  live_.Publish(std::move(live));
+}
 
-  if (chars_read == 0) {
+void Config::Reload() {
+  // The first snapshot goes through `Load` so that a reader racing with this
+  // reload cannot publish a second initial one afterwards.
+  Load(Section::kLive);
+  if (!ReloadIniFile()) {
+    DebugLog(L"Config: cannot reread chrome++.ini, keeping the old settings");
     return;
   }
+  PublishLive();
+  DebugLog(L"Config: reloaded chrome++.ini");
 
-  const wchar_t* current = buffer.data();
-  while (*current != L'\0') {
-    const std::wstring_view line(current);
-    current += line.length() + 1;
+  std::vector<ReloadObserver> observers;
+  {
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    observers = reload_observers_;
+  }
+  for (const ReloadObserver observer : observers) {
+    observer();
+  }
+}
 
-    const auto eq_pos = line.find(L'=');
-    if (eq_pos == std::wstring_view::npos || eq_pos == 0) {
-      continue;
-    }
+void Config::AddReloadObserver(ReloadObserver observer) const {
+  std::lock_guard<std::mutex> lock(reload_mutex_);
+  reload_observers_.push_back(observer);
+}
 
-    std::wstring_view key = line.substr(0, eq_pos);
-    std::wstring_view value = line.substr(eq_pos + 1);
+void Config::WatchForChanges() const {
+  if (!IsHotReload()) {
+    return;
+  }
 
-    while (!key.empty() && (key.back() == L' ' || key.back() == L'\t')) {
-      key.remove_suffix(1);
-    }
-    while (!value.empty() &&
-           (value.front() == L' ' || value.front() == L'\t')) {
-      value.remove_prefix(1);
+  std::thread([] {
+    // Editors save in several writes, some by replacing the file; wait for
+    // them to settle and reload only when the INI's write time moved.
+    constexpr DWORD kSettleDelayMs = 200;
+    HANDLE change = ::FindFirstChangeNotificationW(
+        GetAppDir().c_str(), FALSE,
+        FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+    if (change == INVALID_HANDLE_VALUE) {
+      DebugLog(L"Config: cannot watch {}: {}", GetAppDir(), ::GetLastError());
+      return;
     }
 
-    if (!key.empty() && !value.empty()) {
-      key_mappings_.emplace_back(std::wstring(key), std::wstring(value));
+    auto last_write_time = [] {
+      WIN32_FILE_ATTRIBUTE_DATA data = {};
+      ::GetFileAttributesExW(GetIniPath().c_str(), GetFileExInfoStandard,
+                             &data);
+      return data.ftLastWriteTime;
+    };
+    FILETIME loaded = last_write_time();
+    while (::WaitForSingleObject(change, INFINITE) == WAIT_OBJECT_0) {
+      ::Sleep(kSettleDelayMs);
+      if (!::FindNextChangeNotification(change)) {
+        break;
+      }
+      const FILETIME written = last_write_time();
+      if (::CompareFileTime(&written, &loaded) != 0) {
+        loaded = written;
+        Instance().Reload();
+      }
     }
+    ::FindCloseChangeNotification(change);
+  }).detach();
+}
+
+void Config::PublishSnapshot(std::span<const uint16_t> pak_target_ids,
+                             std::wstring_view pak_blob_name) const {
+  // After an in-app restart the new browser inherits the old browser's
+  // snapshot name, which dies with that process; drop it and republish under
+  // this pid.
+  ::SetEnvironmentVariableW(kConfigSnapshotEnv, nullptr);
+
+  static_assert(sizeof(wchar_t) == sizeof(char16_t));
+  auto to_u16string = [](std::wstring_view text) {
+    return std::u16string(reinterpret_cast<const char16_t*>(text.data()),
+                          text.size());
+  };
+  ConfigSnapshotData data;
+  data.pak_target_ids.assign(pak_target_ids.begin(), pak_target_ids.end());
+  data.pak_blob_name = to_u16string(pak_blob_name);
+  for (const auto& [key, value] : GetPakPatchRules()) {
+    data.pak_patch_rules.emplace_back(to_u16string(key), to_u16string(value));
+  }
+  const std::vector<uint8_t> bytes = SerializeConfigSnapshot(data);
+
+  const std::wstring name =
+      L"Local\\ChromePlusConfig_" + std::to_wstring(::GetCurrentProcessId());
+  const auto size = static_cast<DWORD>(bytes.size());
+  HANDLE section = CreatePublishedSection(name, size);
+  if (!section) {
+    DebugLog(L"Config: cannot publish the snapshot: {}", ::GetLastError());
+    return;
+  }
+  void* view = ::MapViewOfFile(section, FILE_MAP_WRITE, 0, 0, size);
+  if (!view) {
+    ::CloseHandle(section);
+    return;
+  }
+  memcpy(view, bytes.data(), bytes.size());
+  ::UnmapViewOfFile(view);
+
+  // Kept open for the browser's lifetime so children can open it by name.
+  static HANDLE published_section = nullptr;
+  if (published_section) {
+    ::CloseHandle(published_section);
   }
+  published_section = section;
+  ::SetEnvironmentVariableW(kConfigSnapshotEnv, name.c_str());
+  DebugLog(L"Config: published a {} byte snapshot as {}", bytes.size(), name);
+}
+
+const ConfigSnapshot* Config::Inherited() {
+  // The mapping stays for the process's lifetime; the snapshot points into it.
+  static const std::optional<ConfigSnapshot> snapshot =
+      []() -> std::optional<ConfigSnapshot> {
+    if (IsBrowserProcess()) {
+      return std::nullopt;
+    }
+    wchar_t name[64];
+    const DWORD len =
+        ::GetEnvironmentVariableW(kConfigSnapshotEnv, name, ARRAYSIZE(name));
+    if (len == 0 || len >= ARRAYSIZE(name)) {
+      return std::nullopt;
+    }
+    HANDLE section = ::OpenFileMappingW(FILE_MAP_READ, FALSE, name);
+    if (!section) {
+      return std::nullopt;
+    }
+    const void* view = ::MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0);
+    ::CloseHandle(section);
+    if (!view) {
+      return std::nullopt;
+    }
+    // The view spans whole pages; `Parse` trusts only the header's size.
+    MEMORY_BASIC_INFORMATION info = {};
+    if (!::VirtualQuery(view, &info, sizeof(info))) {
+      ::UnmapViewOfFile(view);
+      return std::nullopt;
+    }
+    auto parsed = ConfigSnapshot::Parse(
+        {static_cast<const uint8_t*>(view), info.RegionSize});
+    if (!parsed) {
+      DebugLog(L"Config: ignoring a malformed snapshot in {}", name);
+      ::UnmapViewOfFile(view);
+    }
+    return parsed;
+  }();
+  return snapshot ? &*snapshot : nullptr;
 }
 
 std::optional<std::wstring> Config::LoadDirPath(const std::wstring& dir_type) {
@@ -119,24 +255,5 @@ std::optional<std::wstring> Config::LoadDirPath(const std::wstring& dir_type) {
   return GetAbsolutePath(expanded_path);
 }
 
-int Config::LoadHoverTabDelay() {
-  constexpr int kDefaultDelayMs = 400;
-  constexpr int kMaxDelayMs = 5000;
-  const int delay = ::GetPrivateProfileIntW(
-      L"tabs", L"hover_tab_delay", kDefaultDelayMs, GetIniPath().c_str());
-  if (delay < 0 || delay > kMaxDelayMs) {
-    return kDefaultDelayMs;
-  }
-  return delay;
-}
-
-int Config::LoadOpenUrlNewTabMode() {
-  return ::GetPrivateProfileIntW(L"tabs", L"open_url_new_tab", 0,
-                                 GetIniPath().c_str());
-}
-int Config::LoadBookmarkNewTabMode() {
-  return ::GetPrivateProfileIntW(L"tabs", L"open_bookmark_new_tab", 0,
-                                 GetIniPath().c_str());
-}
-
+// Only constructs the empty singleton; no section is read until asked for.
 const Config& config = Config::Instance();
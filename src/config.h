@@ -1,55 +1,113 @@
 #ifndef CHROME_PLUS_SRC_CONFIG_H_
 #define CHROME_PLUS_SRC_CONFIG_H_
 
+#include <cstdint>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include "configsnapshot.h"
+#include "livesettings.h"
+#include "snapshotpublisher.h"
+
+// Names the browser's config snapshot section for its child processes.
+constexpr wchar_t kConfigSnapshotEnv[] = L"CHROME_PLUS_CONFIG";
+
+// chrome++.ini settings. Each section is read on first use, once per
+// process: most child processes never touch `config` and so never open the
+// INI, and a renderer reads only what its pak patch needs.
 class Config {
  public:
   static Config& Instance();
 
+  // The current live settings. Load them once per input event and read
+  // every field from the returned snapshot, so that a reload in the middle of
+  // a handler cannot mix old and new values. The reference stays valid for
+  // as long as `SnapshotPublisher` retains the snapshot, well past one
+  // event.
+  const LiveSettings& Live() const {
+    if (const LiveSettings* live = live_.Current()) {
+      return *live;
+    }
+    Load(Section::kLive);
+    return *live_.Current();
+  }
+
+  // Called on the watcher thread after each reload has been published.
+  using ReloadObserver = void (*)();
+
+  // With `hot_reload` on, starts a thread that reloads the live settings
+  // whenever chrome++.ini changes; otherwise does nothing.
+  void WatchForChanges() const;
+  void AddReloadObserver(ReloadObserver observer) const;
+
+  // Browser only: publishes the settings child processes need, together with
+  // what the browser derived from them, as one read-only `ConfigSnapshot`
+  // section named in `kConfigSnapshotEnv`, which every child inherits.
+  void PublishSnapshot(std::span<const uint16_t> pak_target_ids,
+                       std::wstring_view pak_blob_name) const;
+
+  // In a child process, the snapshot its browser published, mapped once and
+  // read in place; nullptr in the browser or when none could be opened, in
+  // which case settings come from chrome++.ini as usual.
+  static const ConfigSnapshot* Inherited();
+
   // general
-  const std::wstring& GetCommandLine() const { return command_line_; }
-  const std::wstring& GetLaunchOnStartup() const { return launch_on_startup_; }
-  const std::wstring& GetLaunchOnExit() const { return launch_on_exit_; }
+  const std::wstring& GetCommandLine() const {
+    Load(Section::kGeneral);
+    return command_line_;
+  }
+  const std::wstring& GetLaunchOnStartup() const {
+    Load(Section::kGeneral);
+    return launch_on_startup_;
+  }
+  const std::wstring& GetLaunchOnExit() const {
+    Load(Section::kGeneral);
+    return launch_on_exit_;
+  }
   const std::optional<std::wstring>& GetUserDataDir() const {
+    Load(Section::kGeneral);
     return user_data_dir_;
   }
   const std::optional<std::wstring>& GetDiskCacheDir() const {
+    Load(Section::kGeneral);
     return disk_cache_dir_;
   }
-  const std::wstring& GetBossKey() const { return boss_key_; }
-  const std::wstring& GetTranslateKey() const { return translate_key_; }
-  bool IsShowPassword() const { return show_password_; }
-  bool IsWin32K() const { return win32k_; }
-  bool IsIgnorePolicies() const { return ignore_policies_; }
+  const std::wstring& GetBossKey() const {
+    Load(Section::kGeneral);
+    return boss_key_;
+  }
+  bool IsShowPassword() const {
+    Load(Section::kGeneral);
+    return show_password_;
+  }
+  bool IsWin32K() const {
+    Load(Section::kGeneral);
+    return win32k_;
+  }
+  bool IsIgnorePolicies() const {
+    Load(Section::kGeneral);
+    return ignore_policies_;
+  }
   bool IsSuppressFalseUpgradeNotification() const {
+    Load(Section::kGeneral);
     return suppress_false_upgrade_notification_;
   }
-
-  // tabs
-  bool IsKeepLastTab() const { return keep_last_tab_; }
-  bool IsDoubleClickClose() const { return double_click_close_; }
-  bool IsRightClickClose() const { return right_click_close_; }
-  bool IsWheelTab() const { return wheel_tab_; }
-  bool IsWheelTabWhenPressRightButton() const {
-    return wheel_tab_when_press_rbutton_;
-  }
-  bool IsHoverTab() const { return hover_tab_; }
-  int GetHoverTabDelay() const { return hover_tab_delay_; }
-  int GetOpenUrlNewTabMode() const { return open_url_new_tab_; }
-  int GetBookmarkNewTabMode() const { return bookmark_new_tab_; }
-  bool IsNewTabDisable() const { return new_tab_disable_; }
-  const std::wstring& GetDisableTabName() const { return disable_tab_name_; }
-  const std::vector<std::wstring>& GetDisableTabNames() const {
-    return disable_tab_names_;
+  bool IsHotReload() const {
+    Load(Section::kGeneral);
+    return hot_reload_;
   }
 
-  // keymapping
-  using KeyMappingPair = std::pair<std::wstring, std::wstring>;
-  const auto& GetKeyMappings() const { return key_mappings_; }
+  // pakpatch: raw `key=value` rule lines, parsed in pakrules.cc.
+  using PakPatchRulePair = std::pair<std::wstring, std::wstring>;
+  const auto& GetPakPatchRules() const {
+    Load(Section::kPakPatch);
+    return pak_patch_rules_;
+  }
 
  private:
   Config();
@@ -57,13 +115,21 @@ class Config {
   Config(const Config&) = delete;
   Config& operator=(const Config&) = delete;
 
-  void LoadConfig();
-  void LoadKeyMappings();
+  enum class Section { kGeneral, kLive, kPakPatch, kCount };
+
+  // Reads `section` from the INI the first time it is asked for; later calls
+  // and concurrent callers wait for that one read.
+  void Load(Section section) const;
+
+  void LoadGeneral();
+  void LoadPakPatch();
+  // Reads the live settings from the INI as it is now and publishes them.
+  void PublishLive();
+  // Rereads chrome++.ini, publishes new live settings and notifies the
+  // observers.
+  void Reload();
 
   std::optional<std::wstring> LoadDirPath(const std::wstring& dir_type);
-  int LoadHoverTabDelay();
-  int LoadOpenUrlNewTabMode();
-  int LoadBookmarkNewTabMode();
 
  private:
   // general
@@ -73,28 +139,20 @@ class Config {
   std::optional<std::wstring> user_data_dir_;
   std::optional<std::wstring> disk_cache_dir_;
   std::wstring boss_key_;
-  std::wstring translate_key_;
   bool show_password_;
   bool win32k_;
   bool ignore_policies_;
   bool suppress_false_upgrade_notification_;
+  bool hot_reload_;
+
+  SnapshotPublisher<LiveSettings> live_;
+  mutable std::vector<ReloadObserver> reload_observers_;
+  mutable std::mutex reload_mutex_;
+
+  // pakpatch
+  std::vector<PakPatchRulePair> pak_patch_rules_;
 
-  // tabs
-  bool keep_last_tab_;
-  bool double_click_close_;
-  bool right_click_close_;
-  bool wheel_tab_;
-  bool wheel_tab_when_press_rbutton_;
-  bool hover_tab_;
-  int hover_tab_delay_;
-  int open_url_new_tab_;
-  int bookmark_new_tab_;
-  bool new_tab_disable_;
-  std::wstring disable_tab_name_;
-  std::vector<std::wstring> disable_tab_names_;
-
-  // keymapping
-  std::vector<KeyMappingPair> key_mappings_;
+  mutable std::once_flag loaded_[static_cast<size_t>(Section::kCount)];
 };
 
 extern const Config& config;
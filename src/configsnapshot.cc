@@ -0,0 +1,208 @@
+#include "configsnapshot.h"
+
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kSnapshotMagic = 0x53435043;  // 'CPCS'
+constexpr uint32_t kSnapshotVersion = 1;
+constexpr size_t kRecordAlignment = 8;
+
+// Followed by `record_count` `SnapshotRecord`s, then the payloads.
+struct SnapshotHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size;
+  uint32_t record_count;
+};
+
+struct SnapshotRecord {
+  uint32_t tag;
+  uint32_t offset;
+  uint32_t size;
+  uint32_t reserved;
+};
+
+enum RecordTag : uint32_t {
+  // uint16_t resource ids.
+  kPakTargetIds = 1,
+  // UTF-16 section name.
+  kPakBlobName = 2,
+  // uint32_t count and padding to 8, `count` `RuleRef`s, then the UTF-16
+  // text they point into.
+  kPakPatchRules = 3,
+};
+
+// Appends records to a snapshot being built; `Finish` writes the header and
+// table in front.
+class SnapshotBuilder {
+ public:
+  void Add(RecordTag tag, std::span<const uint8_t> payload) {
+    payloads_.resize((payloads_.size() + kRecordAlignment - 1) &
+                     ~(kRecordAlignment - 1));
+    records_.push_back({tag, static_cast<uint32_t>(payloads_.size()),
+                        static_cast<uint32_t>(payload.size()), 0});
+    payloads_.insert(payloads_.end(), payload.begin(), payload.end());
+  }
+
+  std::vector<uint8_t> Finish() {
+    const size_t table_end =
+        sizeof(SnapshotHeader) + records_.size() * sizeof(SnapshotRecord);
+    const size_t payload_start = (table_end + kRecordAlignment - 1) &
+                                 ~(kRecordAlignment - 1);
+    std::vector<uint8_t> bytes(payload_start + payloads_.size());
+    const SnapshotHeader header{kSnapshotMagic, kSnapshotVersion,
+                                static_cast<uint32_t>(bytes.size()),
+                                static_cast<uint32_t>(records_.size())};
+    memcpy(bytes.data(), &header, sizeof(header));
+    for (size_t i = 0; i < records_.size(); ++i) {
+      SnapshotRecord record = records_[i];
+      record.offset += static_cast<uint32_t>(payload_start);
+      memcpy(bytes.data() + sizeof(header) + i * sizeof(record), &record,
+             sizeof(record));
+    }
+    if (!payloads_.empty()) {
+      memcpy(bytes.data() + payload_start, payloads_.data(), payloads_.size());
+    }
+    return bytes;
+  }
+
+ private:
+  std::vector<SnapshotRecord> records_;
+  std::vector<uint8_t> payloads_;
+};
+
+template <typename T>
+std::span<const uint8_t> AsBytes(std::span<const T> values) {
+  return {reinterpret_cast<const uint8_t*>(values.data()),
+          values.size_bytes()};
+}
+
+// The payload as an array of `T`, if it holds a whole number of them.
+template <typename T>
+std::optional<std::span<const T>> ArrayOf(std::span<const uint8_t> payload) {
+  if (payload.size() % sizeof(T) != 0) {
+    return std::nullopt;
+  }
+  return std::span(reinterpret_cast<const T*>(payload.data()),
+                   payload.size() / sizeof(T));
+}
+
+}  // namespace
+
+std::vector<uint8_t> SerializeConfigSnapshot(const ConfigSnapshotData& data) {
+  SnapshotBuilder builder;
+  builder.Add(kPakTargetIds,
+              AsBytes(std::span<const uint16_t>(data.pak_target_ids)));
+  builder.Add(kPakBlobName,
+              AsBytes(std::span<const char16_t>(data.pak_blob_name)));
+
+  constexpr size_t kRulesPrefix = kRecordAlignment;
+  std::vector<uint8_t> rules(kRulesPrefix);
+  const auto count = static_cast<uint32_t>(data.pak_patch_rules.size());
+  memcpy(rules.data(), &count, sizeof(count));
+  std::u16string text;
+  for (const auto& [key, value] : data.pak_patch_rules) {
+    const uint32_t ref[] = {
+        static_cast<uint32_t>(text.size()), static_cast<uint32_t>(key.size()),
+        static_cast<uint32_t>(text.size() + key.size()),
+        static_cast<uint32_t>(value.size())};
+    const auto ref_bytes = AsBytes(std::span<const uint32_t>(ref));
+    rules.insert(rules.end(), ref_bytes.begin(), ref_bytes.end());
+    text += key;
+    text += value;
+  }
+  const auto text_bytes = AsBytes(std::span<const char16_t>(text));
+  rules.insert(rules.end(), text_bytes.begin(), text_bytes.end());
+  builder.Add(kPakPatchRules, rules);
+  return builder.Finish();
+}
+
+std::optional<ConfigSnapshot> ConfigSnapshot::Parse(
+    std::span<const uint8_t> bytes) {
+  if (bytes.size() < sizeof(SnapshotHeader) ||
+      reinterpret_cast<uintptr_t>(bytes.data()) % kRecordAlignment != 0) {
+    return std::nullopt;
+  }
+  const auto* header = reinterpret_cast<const SnapshotHeader*>(bytes.data());
+  if (header->magic != kSnapshotMagic || header->version != kSnapshotVersion ||
+      header->size > bytes.size() ||
+      header->record_count >
+          (header->size - sizeof(SnapshotHeader)) / sizeof(SnapshotRecord)) {
+    return std::nullopt;
+  }
+  bytes = bytes.first(header->size);
+  const std::span records(
+      reinterpret_cast<const SnapshotRecord*>(bytes.data() + sizeof(*header)),
+      header->record_count);
+
+  ConfigSnapshot snapshot;
+  for (const auto& record : records) {
+    if (record.offset % kRecordAlignment != 0 || record.offset > bytes.size() ||
+        record.size > bytes.size() - record.offset) {
+      return std::nullopt;
+    }
+    const auto payload = bytes.subspan(record.offset, record.size);
+    switch (record.tag) {
+      case kPakTargetIds: {
+        const auto ids = ArrayOf<uint16_t>(payload);
+        if (!ids) {
+          return std::nullopt;
+        }
+        snapshot.pak_target_ids_ = *ids;
+        break;
+      }
+      case kPakBlobName: {
+        const auto name = ArrayOf<char16_t>(payload);
+        if (!name) {
+          return std::nullopt;
+        }
+        snapshot.pak_blob_name_ = {name->data(), name->size()};
+        break;
+      }
+      case kPakPatchRules: {
+        if (payload.size() < kRecordAlignment) {
+          return std::nullopt;
+        }
+        uint32_t count = 0;
+        memcpy(&count, payload.data(), sizeof(count));
+        const auto body = payload.subspan(kRecordAlignment);
+        if (count > body.size() / sizeof(RuleRef)) {
+          return std::nullopt;
+        }
+        const std::span refs(reinterpret_cast<const RuleRef*>(body.data()),
+                             count);
+        const auto text = ArrayOf<char16_t>(body.subspan(refs.size_bytes()));
+        if (!text) {
+          return std::nullopt;
+        }
+        for (const auto& ref : refs) {
+          if (ref.key_offset > text->size() ||
+              ref.key_length > text->size() - ref.key_offset ||
+              ref.value_offset > text->size() ||
+              ref.value_length > text->size() - ref.value_offset) {
+            return std::nullopt;
+          }
+        }
+        snapshot.pak_patch_rules_ = refs;
+        snapshot.pak_patch_text_ = {text->data(), text->size()};
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  return snapshot;
+}
+
+std::pair<std::u16string_view, std::u16string_view>
+ConfigSnapshot::pak_patch_rule(size_t index) const {
+  const RuleRef& ref = pak_patch_rules_[index];
+  return {pak_patch_text_.substr(ref.key_offset, ref.key_length),
+          pak_patch_text_.substr(ref.value_offset, ref.value_length)};
+}
@@ -0,0 +1,63 @@
+#ifndef CHROME_PLUS_SRC_CONFIGSNAPSHOT_H_
+#define CHROME_PLUS_SRC_CONFIGSNAPSHOT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// What the browser hands its child processes: the settings and derived state
+// a child would otherwise read from chrome++.ini or recompute.
+struct ConfigSnapshotData {
+  // Pak resource ids the browser patched.
+  std::vector<uint16_t> pak_target_ids;
+  // Name of the section holding the browser's patched pak entries; empty
+  // when none was published.
+  std::u16string pak_blob_name;
+  // The raw `[pakpatch]` lines, as `Config::GetPakPatchRules` returns them.
+  std::vector<std::pair<std::u16string, std::u16string>> pak_patch_rules;
+};
+
+// Lays `data` out as a snapshot for `ConfigSnapshot::Parse`.
+std::vector<uint8_t> SerializeConfigSnapshot(const ConfigSnapshotData& data);
+
+// Read-only view of a serialized snapshot: a versioned header, a table of
+// tagged records and their payloads, every record 8-byte aligned. `Parse`
+// checks the whole layout once, so the accessors read straight out of the
+// bytes -- a shared section mapped by a child -- without copying, allocating
+// or further bounds checks. The bytes must outlive the view. Records with a
+// tag this build does not know are skipped, so a field can be added without
+// a version bump; a changed record layout needs one.
+class ConfigSnapshot {
+ public:
+  static std::optional<ConfigSnapshot> Parse(std::span<const uint8_t> bytes);
+
+  std::span<const uint16_t> pak_target_ids() const { return pak_target_ids_; }
+  std::u16string_view pak_blob_name() const { return pak_blob_name_; }
+
+  size_t pak_patch_rule_count() const { return pak_patch_rules_.size(); }
+  std::pair<std::u16string_view, std::u16string_view> pak_patch_rule(
+      size_t index) const;
+
+ private:
+  // Offsets and lengths in UTF-16 units into `pak_patch_text_`.
+  struct RuleRef {
+    uint32_t key_offset;
+    uint32_t key_length;
+    uint32_t value_offset;
+    uint32_t value_length;
+  };
+
+  ConfigSnapshot() = default;
+
+  std::span<const uint16_t> pak_target_ids_;
+  std::u16string_view pak_blob_name_;
+  std::span<const RuleRef> pak_patch_rules_;
+  std::u16string_view pak_patch_text_;
+};
+
+#endif  // CHROME_PLUS_SRC_CONFIGSNAPSHOT_H_
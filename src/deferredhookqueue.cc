@@ -0,0 +1,39 @@
+#include "deferredhookqueue.h"
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Module base names are ASCII; fold case without depending on the locale.
+bool EqualsIgnoreAsciiCase(std::wstring_view a, std::wstring_view b) {
+  const auto fold = [](wchar_t c) {
+    return c >= L'A' && c <= L'Z' ? static_cast<wchar_t>(c - L'A' + L'a') : c;
+  };
+  return std::ranges::equal(a, b, [&](wchar_t x, wchar_t y) {
+    return fold(x) == fold(y);
+  });
+}
+
+}  // namespace
+
+void DeferredHookQueue::Add(size_t hook, std::wstring_view module) {
+  waiting_.emplace_back(std::wstring(module), hook);
+}
+
+std::vector<size_t> DeferredHookQueue::Release(std::wstring_view module) {
+  std::vector<size_t> released;
+  std::vector<std::pair<std::wstring, size_t>> still_waiting;
+  for (auto& entry : waiting_) {
+    if (EqualsIgnoreAsciiCase(entry.first, module)) {
+      released.push_back(entry.second);
+    } else {
+      still_waiting.push_back(std::move(entry));
+    }
+  }
+  waiting_ = std::move(still_waiting);
+  return released;
+}
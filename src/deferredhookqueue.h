@@ -0,0 +1,27 @@
+#ifndef CHROME_PLUS_SRC_DEFERREDHOOKQUEUE_H_
+#define CHROME_PLUS_SRC_DEFERREDHOOKQUEUE_H_
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Bookkeeping for hooks deferred until their host DLL loads: which waiting
+// hooks a module-load event releases. Free of Windows calls so the decision
+// can be driven by a fake stream of module names.
+class DeferredHookQueue {
+ public:
+  void Add(size_t hook, std::wstring_view module);
+
+  // Removes and returns, in the order added, the hooks waiting for `module`,
+  // a base name such as "netapi32.dll" matched case-insensitively.
+  std::vector<size_t> Release(std::wstring_view module);
+
+  bool empty() const { return waiting_.empty(); }
+
+ private:
+  std::vector<std::pair<std::wstring, size_t>> waiting_;
+};
+
+#endif  // CHROME_PLUS_SRC_DEFERREDHOOKQUEUE_H_
@@ -0,0 +1,578 @@
+#include "fastinflate.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHROME_PLUS_INFLATE_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define CHROME_PLUS_INFLATE_NEON
+#endif
+
+namespace {
+
+// One slot of a decode table. `bits` is the number of input bits the code
+// occupies (for a subtable link: the primary-table bits to drop; for a
+// literal pair: both codes); `value` is a literal byte, two literal bytes
+// (first in the low byte), a length or distance base, or a subtable offset;
+// `extra` is the number of extra bits following a length or distance code,
+// the index width of a linked subtable, or the first code's length in a pair.
+struct HuffEntry {
+  uint16_t value;
+  uint8_t bits;
+  uint8_t kind : 3;
+  uint8_t extra : 5;
+};
+
+enum HuffKind : uint8_t {
+  kInvalid = 0,
+  kLiteral,
+  kEndOfBlock,
+  kBase,  // Length or distance base plus `extra` bits.
+  kSubtable,
+  kLiteralPair,  // Two literals decoded by one lookup.
+};
+
+// Codes up to the primary width resolve in one lookup; longer (rare) codes
+// take a second one through a subtable sized for the longest code sharing
+// that prefix.
+struct HuffTable {
+  std::vector<HuffEntry> entries;
+  unsigned primary_bits = 0;
+};
+
+constexpr unsigned kMaxCodeLength = 15;
+constexpr unsigned kLitLenPrimaryBits = 11;
+constexpr unsigned kDistPrimaryBits = 8;
+constexpr unsigned kCodeLengthPrimaryBits = 7;
+
+constexpr std::array<uint16_t, 29> kLengthBase = {
+    3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr std::array<uint8_t, 29> kLengthExtra = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+    2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr std::array<uint16_t, 30> kDistBase = {
+    1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+    33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145,  8193,  12289, 16385, 24577};
+constexpr std::array<uint8_t, 30> kDistExtra = {
+    0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+constexpr std::array<uint8_t, 19> kCodeLengthOrder = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+HuffEntry LitLenEntry(unsigned symbol) {
+  if (symbol < 256) {
+    return {static_cast<uint16_t>(symbol), 0, kLiteral, 0};
+  }
+  if (symbol == 256) {
+    return {0, 0, kEndOfBlock, 0};
+  }
+  if (symbol - 257 < kLengthBase.size()) {
+    return {kLengthBase[symbol - 257], 0, kBase, kLengthExtra[symbol - 257]};
+  }
+  return {0, 0, kInvalid, 0};
+}
+
+HuffEntry DistEntry(unsigned symbol) {
+  if (symbol < kDistBase.size()) {
+    return {kDistBase[symbol], 0, kBase, kDistExtra[symbol]};
+  }
+  return {0, 0, kInvalid, 0};
+}
+
+HuffEntry CodeLengthEntry(unsigned symbol) {
+  return {static_cast<uint16_t>(symbol), 0, kLiteral, 0};
+}
+
+unsigned ReverseBits(unsigned code, unsigned length) {
+  unsigned reversed = 0;
+  for (unsigned i = 0; i < length; ++i) {
+    reversed = (reversed << 1) | (code & 1);
+    code >>= 1;
+  }
+  return reversed;
+}
+
+// Builds a canonical Huffman decode table from code lengths. Deflate sends
+// codes most-significant bit first into an LSB-first bit stream, so tables
+// are indexed by the bit-reversed code. Over-subscribed code sets are
+// rejected; slots an incomplete set leaves empty decode as `kInvalid`.
+template <typename MakeEntry>
+bool BuildTable(std::span<const uint8_t> lengths,
+                unsigned primary_bits,
+                MakeEntry make_entry,
+                HuffTable& table) {
+  std::array<unsigned, kMaxCodeLength + 1> count{};
+  for (const uint8_t length : lengths) {
+    ++count[length];
+  }
+  count[0] = 0;
+  int left = 1;
+  for (unsigned length = 1; length <= kMaxCodeLength; ++length) {
+    left = (left << 1) - static_cast<int>(count[length]);
+    if (left < 0) {
+      return false;
+    }
+  }
+
+  std::array<unsigned, kMaxCodeLength + 2> next_code{};
+  for (unsigned length = 1; length <= kMaxCodeLength; ++length) {
+    next_code[length + 1] = (next_code[length] + count[length]) << 1;
+  }
+
+  // Size each subtable for the longest code under its primary prefix.
+  const unsigned primary_size = 1u << primary_bits;
+  const unsigned primary_mask = primary_size - 1;
+  std::array<unsigned, kMaxCodeLength + 2> code = next_code;
+  std::vector<uint8_t> sub_bits(primary_size, 0);
+  for (const uint8_t length : lengths) {
+    if (length > primary_bits) {
+      const unsigned prefix = ReverseBits(code[length], length) & primary_mask;
+      sub_bits[prefix] = std::max<uint8_t>(
+          sub_bits[prefix], static_cast<uint8_t>(length - primary_bits));
+    }
+    if (length != 0) {
+      ++code[length];
+    }
+  }
+
+  table.primary_bits = primary_bits;
+  table.entries.assign(primary_size, HuffEntry{0, 0, kInvalid, 0});
+  for (unsigned prefix = 0; prefix < primary_size; ++prefix) {
+    if (sub_bits[prefix] != 0) {
+      table.entries[prefix] = {static_cast<uint16_t>(table.entries.size()),
+                               static_cast<uint8_t>(primary_bits), kSubtable,
+                               sub_bits[prefix]};
+      table.entries.resize(table.entries.size() + (1u << sub_bits[prefix]),
+                           HuffEntry{0, 0, kInvalid, 0});
+    }
+  }
+
+  code = next_code;
+  for (unsigned symbol = 0; symbol < lengths.size(); ++symbol) {
+    const unsigned length = lengths[symbol];
+    if (length == 0) {
+      continue;
+    }
+    const unsigned reversed = ReverseBits(code[length]++, length);
+    HuffEntry entry = make_entry(symbol);
+    if (length <= primary_bits) {
+      entry.bits = static_cast<uint8_t>(length);
+      for (unsigned i = reversed; i < primary_size; i += 1u << length) {
+        table.entries[i] = entry;
+      }
+    } else {
+      const HuffEntry& link = table.entries[reversed & primary_mask];
+      const unsigned sub_length = length - primary_bits;
+      entry.bits = static_cast<uint8_t>(sub_length);
+      for (unsigned i = reversed >> primary_bits; i < (1u << link.extra);
+           i += 1u << sub_length) {
+        table.entries[link.value + i] = entry;
+      }
+    }
+  }
+  return true;
+}
+
+// Lets one primary lookup emit two literals: each primary slot holding a
+// literal whose code leaves room, within the primary width, for a whole
+// second literal code becomes a `kLiteralPair`. The second code is looked up
+// in the same table at the slot index shifted past the first; slots are
+// rewritten from the top down, so that lower slot still holds its single
+// entry when it is read. Literal codes in WebUI text are mostly 5 to 9 bits,
+// so most literals then take half the table lookups.
+void AddLiteralPairs(HuffTable& table) {
+  for (unsigned i = 1u << table.primary_bits; i-- > 0;) {
+    const HuffEntry first = table.entries[i];
+    if (first.kind != kLiteral) {
+      continue;
+    }
+    const HuffEntry second = table.entries[i >> first.bits];
+    if (second.kind != kLiteral ||
+        first.bits + second.bits > table.primary_bits) {
+      continue;
+    }
+    table.entries[i] = {static_cast<uint16_t>(first.value | second.value << 8),
+                        static_cast<uint8_t>(first.bits + second.bits),
+                        kLiteralPair, first.bits};
+  }
+}
+
+// The input side of the decoder: an LSB-first bit buffer over the stream.
+struct BitReader {
+  // Tops the buffer up to at least 48 bits, enough for the longest
+  // length/distance pair (15 + 5 + 15 + 13). With eight input bytes left it
+  // loads a whole word at once; bits above `count` may then hold the start
+  // of the next byte, which the next load ORs in again unchanged. Past the
+  // end of the input it shifts in zero bytes and counts them, so a truncated
+  // stream is caught by `Overran` instead of read out of bounds.
+  void Refill() {
+    if (end - in >= 8) {
+      uint64_t word;
+      memcpy(&word, in, sizeof(word));
+      buffer |= word << count;
+      in += (63 - count) >> 3;
+      count |= 56;
+      return;
+    }
+    while (count <= 48) {
+      if (in < end) {
+        buffer |= static_cast<uint64_t>(*in++) << count;
+      } else {
+        ++padding_bytes;
+      }
+      count += 8;
+    }
+  }
+
+  uint32_t Take(unsigned bits) {
+    const auto taken =
+        static_cast<uint32_t>(buffer & ((uint64_t{1} << bits) - 1));
+    buffer >>= bits;
+    count -= bits;
+    return taken;
+  }
+
+  // True once the decoder has consumed zero bytes shifted in past the end of
+  // the input, i.e. the stream was truncated.
+  bool Overran() const { return count < padding_bytes * 8; }
+
+  // Resolves a subtable link, if `entry` is one, and takes the code's bits.
+  HuffEntry Finish(const HuffTable& table, HuffEntry entry) {
+    if (entry.kind == kSubtable) {
+      Take(entry.bits);
+      const auto sub_index = buffer & ((1u << entry.extra) - 1);
+      entry = table.entries[entry.value + sub_index];
+    }
+    Take(entry.bits);
+    return entry;
+  }
+
+  HuffEntry Decode(const HuffTable& table) {
+    return Finish(table,
+                  table.entries[buffer & ((1u << table.primary_bits) - 1)]);
+  }
+
+  uint64_t buffer = 0;
+  unsigned count = 0;
+  size_t padding_bytes = 0;
+  const uint8_t* in;
+  const uint8_t* end;
+};
+
+void Copy16(uint8_t* dest, const uint8_t* src) {
+#if defined(CHROME_PLUS_INFLATE_SSE2)
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dest),
+                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+#elif defined(CHROME_PLUS_INFLATE_NEON)
+  vst1q_u8(dest, vld1q_u8(src));
+#else
+  memcpy(dest, src, 16);
+#endif
+}
+
+// Copies a `length`-byte match from `distance` back to `out`, returning the
+// new end of output; `room` is the space left from `out`. Whenever there is
+// room for the last move's overshoot, which later output overwrites, it
+// copies in 16-byte vector moves. Each move reads only bytes already written
+// once the source is at least 16 bytes behind; a closer source (a run or a
+// short repeat) is first widened by doubling: the pattern is copied after
+// itself until a period of 16 bytes or more is laid down, which repeats the
+// same sequence. Near the end of the buffer it copies bytes.
+uint8_t* CopyMatch(uint8_t* out, size_t room, size_t length, size_t distance) {
+  uint8_t* const end = out + length;
+  if (room < length + 16) {
+    const uint8_t* src = out - distance;
+    while (out < end) {
+      *out++ = *src++;
+    }
+    return end;
+  }
+  if (distance == 1) {
+    memset(out, out[-1], length);
+    return end;
+  }
+  while (distance < 16 && out < end) {
+    memcpy(out, out - distance, distance);
+    out += distance;
+    distance *= 2;
+  }
+  while (out < end) {
+    Copy16(out, out - distance);
+    out += 16;
+  }
+  return end;
+}
+
+class Inflater {
+ public:
+  Inflater(std::span<const uint8_t> input,
+           std::span<uint8_t> out,
+           const InflateObserver& observer)
+      : in_begin_(input.data()),
+        out_begin_(out.data()),
+        out_(out.data()),
+        out_end_(out.data() + out.size()),
+        observer_(observer) {
+    bits_.in = input.data();
+    bits_.end = input.data() + input.size();
+  }
+
+  std::optional<size_t> Run() {
+    bool final_block = false;
+    while (!final_block) {
+      if (observer_.on_block &&
+          !observer_.on_block({ConsumedBits(), OutputSize()})) {
+        return std::nullopt;
+      }
+      bits_.Refill();
+      final_block = bits_.Take(1) != 0;
+      bool ok = false;
+      switch (bits_.Take(2)) {
+        case 0:
+          ok = StoredBlock();
+          break;
+        case 1:
+          ok = FixedTables() && HuffmanBlock();
+          break;
+        case 2:
+          ok = DynamicTables() && HuffmanBlock();
+          break;
+        default:
+          break;
+      }
+      if (!ok || bits_.Overran()) {
+        return std::nullopt;
+      }
+    }
+    return OutputSize();
+  }
+
+ private:
+  size_t OutputSize() const { return static_cast<size_t>(out_ - out_begin_); }
+
+  // Input bits decoded so far; the buffer holds the bits loaded but not yet
+  // taken, including any zero padding bytes.
+  size_t ConsumedBits() const {
+    return static_cast<size_t>(bits_.in - in_begin_) * 8 +
+           bits_.padding_bytes * 8 - bits_.count;
+  }
+
+  bool StoredBlock() {
+    bits_.Take(bits_.count & 7);
+    const uint32_t length = bits_.Take(16);
+    const uint32_t inverse = bits_.Take(16);
+    if (length != (~inverse & 0xFFFF)) {
+      return false;
+    }
+    // Hand the whole bytes still buffered back to the input and copy the
+    // block straight from there.
+    const size_t buffered = bits_.count >> 3;
+    if (buffered < bits_.padding_bytes) {
+      return false;
+    }
+    bits_.in -= buffered - bits_.padding_bytes;
+    bits_.buffer = 0;
+    bits_.count = 0;
+    bits_.padding_bytes = 0;
+    if (static_cast<size_t>(bits_.end - bits_.in) < length ||
+        static_cast<size_t>(out_end_ - out_) < length) {
+      return false;
+    }
+    // An empty block may come with an empty, null output buffer.
+    if (length != 0) {
+      memcpy(out_, bits_.in, length);
+    }
+    bits_.in += length;
+    out_ += length;
+    return true;
+  }
+
+  bool FixedTables() {
+    if (!fixed_built_) {
+      std::array<uint8_t, 288> lit_len;
+      std::fill(lit_len.begin(), lit_len.begin() + 144, uint8_t{8});
+      std::fill(lit_len.begin() + 144, lit_len.begin() + 256, uint8_t{9});
+      std::fill(lit_len.begin() + 256, lit_len.begin() + 280, uint8_t{7});
+      std::fill(lit_len.begin() + 280, lit_len.end(), uint8_t{8});
+      std::array<uint8_t, 32> dist;
+      dist.fill(5);
+      if (!BuildTable(lit_len, kLitLenPrimaryBits, LitLenEntry,
+                      fixed_lit_len_) ||
+          !BuildTable(dist, kDistPrimaryBits, DistEntry, fixed_dist_)) {
+        return false;
+      }
+      AddLiteralPairs(fixed_lit_len_);
+      fixed_built_ = true;
+    }
+    lit_len_ = &fixed_lit_len_;
+    dist_ = &fixed_dist_;
+    return true;
+  }
+
+  bool DynamicTables() {
+    bits_.Refill();
+    const unsigned lit_len_count = bits_.Take(5) + 257;
+    const unsigned dist_count = bits_.Take(5) + 1;
+    const unsigned code_length_count = bits_.Take(4) + 4;
+
+    std::array<uint8_t, 19> code_length_lengths{};
+    for (unsigned i = 0; i < code_length_count; ++i) {
+      if (i % 12 == 0) {
+        bits_.Refill();
+      }
+      code_length_lengths[kCodeLengthOrder[i]] =
+          static_cast<uint8_t>(bits_.Take(3));
+    }
+    HuffTable code_length_table;
+    if (!BuildTable(code_length_lengths, kCodeLengthPrimaryBits,
+                    CodeLengthEntry, code_length_table)) {
+      return false;
+    }
+
+    std::array<uint8_t, 288 + 32> lengths{};
+    const unsigned total = lit_len_count + dist_count;
+    unsigned filled = 0;
+    while (filled < total) {
+      bits_.Refill();
+      const HuffEntry entry = bits_.Decode(code_length_table);
+      if (entry.kind != kLiteral) {
+        return false;
+      }
+      unsigned repeat = 1;
+      uint8_t length = 0;
+      switch (entry.value) {
+        case 16:
+          if (filled == 0) {
+            return false;
+          }
+          length = lengths[filled - 1];
+          repeat = 3 + bits_.Take(2);
+          break;
+        case 17:
+          repeat = 3 + bits_.Take(3);
+          break;
+        case 18:
+          repeat = 11 + bits_.Take(7);
+          break;
+        default:
+          length = static_cast<uint8_t>(entry.value);
+          break;
+      }
+      if (repeat > total - filled) {
+        return false;
+      }
+      std::fill_n(lengths.begin() + filled, repeat, length);
+      filled += repeat;
+    }
+    if (bits_.Overran() || lengths[256] == 0) {
+      return false;
+    }
+
+    if (!BuildTable(std::span(lengths.data(), lit_len_count),
+                    kLitLenPrimaryBits, LitLenEntry, dynamic_lit_len_) ||
+        !BuildTable(std::span(lengths.data() + lit_len_count, dist_count),
+                    kDistPrimaryBits, DistEntry, dynamic_dist_)) {
+      return false;
+    }
+    AddLiteralPairs(dynamic_lit_len_);
+    lit_len_ = &dynamic_lit_len_;
+    dist_ = &dynamic_dist_;
+    return true;
+  }
+
+  // The hot loop. It runs on local copies of the bit reader and the output
+  // position, written back on the way out: output goes through `uint8_t*`,
+  // which may alias any member, so state kept in members would be reloaded
+  // from memory after every byte stored.
+  bool HuffmanBlock() {
+    BitReader bits = bits_;
+    uint8_t* out = out_;
+    const auto leave = [&](bool ok) {
+      bits_ = bits;
+      out_ = out;
+      return ok;
+    };
+    const HuffTable& lit_len = *lit_len_;
+    const HuffTable& dist = *dist_;
+    const unsigned primary_mask = (1u << lit_len.primary_bits) - 1;
+    for (;;) {
+      bits.Refill();
+      HuffEntry entry = lit_len.entries[bits.buffer & primary_mask];
+      if (entry.kind == kLiteralPair) {
+        if (out_end_ - out >= 2) {
+          bits.Take(entry.bits);
+          out[0] = static_cast<uint8_t>(entry.value);
+          out[1] = static_cast<uint8_t>(entry.value >> 8);
+          out += 2;
+          continue;
+        }
+        // One byte of room at most: take the first literal alone.
+        entry = {static_cast<uint16_t>(entry.value & 0xFF), entry.extra,
+                 kLiteral, 0};
+      }
+      entry = bits.Finish(lit_len, entry);
+      if (entry.kind == kLiteral) {
+        if (out == out_end_) {
+          return leave(false);
+        }
+        *out++ = static_cast<uint8_t>(entry.value);
+        continue;
+      }
+      if (entry.kind == kEndOfBlock) {
+        return leave(true);
+      }
+      if (entry.kind != kBase) {
+        return leave(false);
+      }
+      const size_t length = entry.value + bits.Take(entry.extra);
+
+      entry = bits.Decode(dist);
+      if (entry.kind != kBase) {
+        return leave(false);
+      }
+      const size_t distance = entry.value + bits.Take(entry.extra);
+      const auto room = static_cast<size_t>(out_end_ - out);
+      if (distance > static_cast<size_t>(out - out_begin_) || length > room) {
+        return leave(false);
+      }
+      out = CopyMatch(out, room, length, distance);
+    }
+  }
+
+  BitReader bits_;
+  const uint8_t* in_begin_;
+  uint8_t* out_begin_;
+  uint8_t* out_;
+  uint8_t* out_end_;
+  const InflateObserver& observer_;
+
+  const HuffTable* lit_len_ = nullptr;
+  const HuffTable* dist_ = nullptr;
+  HuffTable fixed_lit_len_;
+  HuffTable fixed_dist_;
+  HuffTable dynamic_lit_len_;
+  HuffTable dynamic_dist_;
+  bool fixed_built_ = false;
+};
+
+}  // namespace
+
+std::optional<size_t> FastInflate(std::span<const uint8_t> input,
+                                  std::span<uint8_t> out) {
+  return FastInflate(input, out, InflateObserver{});
+}
+
+std::optional<size_t> FastInflate(std::span<const uint8_t> input,
+                                  std::span<uint8_t> out,
+                                  const InflateObserver& observer) {
+  return Inflater(input, out, observer).Run();
+}
@@ -0,0 +1,39 @@
+#ifndef CHROME_PLUS_SRC_FASTINFLATE_H_
+#define CHROME_PLUS_SRC_FASTINFLATE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+
+// Decodes a raw deflate stream (RFC 1951) into `out`, which must have room for
+// the whole output. Returns the number of bytes written, or std::nullopt when
+// the stream is malformed, truncated, or does not fit. A throughput-oriented
+// alternative to miniz's `tinfl` for inflating pak entries, which the
+// `CHROME_PLUS_FAST_INFLATE` CMake option selects for the whole-entry decode
+// and the content scan; the gzip write-back uses it in every build.
+std::optional<size_t> FastInflate(std::span<const uint8_t> input,
+                                  std::span<uint8_t> out);
+
+// Where one deflate block begins: the offset of its first header bit in the
+// input, and the number of bytes output before it.
+struct DeflateBlockStart {
+  size_t bit_offset;
+  size_t out_offset;
+};
+
+// Callbacks for following a `FastInflate` as it runs; either may be empty.
+// Returning false from one stops decoding there, and FastInflate then returns
+// std::nullopt.
+struct InflateObserver {
+  // Called before each block is decoded. Used to find where a stream can be
+  // spliced (pakfile.cc).
+  std::function<bool(const DeflateBlockStart&)> on_block = {};
+};
+
+std::optional<size_t> FastInflate(std::span<const uint8_t> input,
+                                  std::span<uint8_t> out,
+                                  const InflateObserver& observer);
+
+#endif  // CHROME_PLUS_SRC_FASTINFLATE_H_
@@ -6,21 +6,23 @@
 #include <processthreadsapi.h>
 #include <shlwapi.h>
 
-#include "detours.h"
-
 #include "config.h"
+#include "hookregistry.h"
 #include "utils.h"
 
 namespace {
 
 // Static function pointers for original functions
 static auto RawUpdateProcThreadAttribute = UpdateProcThreadAttribute;
-static auto RawCryptProtectData = CryptProtectData;
-static auto RawCryptUnprotectData = CryptUnprotectData;
-static auto RawLogonUserW = LogonUserW;
-static auto RawIsOS = IsOS;
-static auto RawNetUserGetInfo = NetUserGetInfo;
 static auto RawGetVolumeInformationW = GetVolumeInformationW;
+// Never called: the hook only needs a slot for Detours' trampoline.
+static auto RawGetComputerNameW = GetComputerNameW;
+// Resolved when their DLL loads, so naming them here does not import it.
+static decltype(&CryptProtectData) RawCryptProtectData = nullptr;
+static decltype(&CryptUnprotectData) RawCryptUnprotectData = nullptr;
+static decltype(&LogonUserW) RawLogonUserW = nullptr;
+static decltype(&IsOS) RawIsOS = nullptr;
+static decltype(&NetUserGetInfo) RawNetUserGetInfo = nullptr;
 
 // Enumeration for process creation mitigation policy
 enum ProcessCreationMitigationPolicy : DWORD64 {
@@ -163,42 +165,43 @@ NET_API_STATUS WINAPI MyNetUserGetInfo(LPCWSTR servername,
 }  // namespace
 
 void MakeGreen() {
-  auto RawGetComputerNameW = GetComputerNameW;
-
-  DetourTransactionBegin();
-  DetourUpdateThread(GetCurrentThread());
-
-  // kernel32.dll
-  DetourAttach(reinterpret_cast<LPVOID*>(&RawGetComputerNameW),
-               reinterpret_cast<void*>(FakeGetComputerName));
-  DetourAttach(reinterpret_cast<LPVOID*>(&RawGetVolumeInformationW),
-               reinterpret_cast<void*>(FakeGetVolumeInformation));
-  DetourAttach(reinterpret_cast<LPVOID*>(&RawUpdateProcThreadAttribute),
-               reinterpret_cast<void*>(MyUpdateProcThreadAttribute));
+  auto& registry = HookRegistry::Instance();
+  registry.Register(
+      L"MakeGreen",
+      {// kernel32.dll
+       {L"GetComputerNameW", reinterpret_cast<void**>(&RawGetComputerNameW),
+        reinterpret_cast<void*>(FakeGetComputerName)},
+       {L"GetVolumeInformationW",
+        reinterpret_cast<void**>(&RawGetVolumeInformationW),
+        reinterpret_cast<void*>(FakeGetVolumeInformation)},
+       {L"UpdateProcThreadAttribute",
+        reinterpret_cast<void**>(&RawUpdateProcThreadAttribute),
+        reinterpret_cast<void*>(MyUpdateProcThreadAttribute)}});
 
   // components/os_crypt/os_crypt_win.cc
-  // crypt32.dll
-  DetourAttach(reinterpret_cast<LPVOID*>(&RawCryptProtectData),
-               reinterpret_cast<void*>(MyCryptProtectData));
-  DetourAttach(reinterpret_cast<LPVOID*>(&RawCryptUnprotectData),
-               reinterpret_cast<void*>(MyCryptUnprotectData));
-
-  if (config.IsShowPassword()) {
-    // advapi32.dll
-    DetourAttach(reinterpret_cast<LPVOID*>(&RawLogonUserW),
-                 reinterpret_cast<void*>(MyLogonUserW));
-
-    // shlwapi.dll
-    DetourAttach(reinterpret_cast<LPVOID*>(&RawIsOS),
-                 reinterpret_cast<void*>(MyIsOS));
-
-    // netapi32.dll
-    DetourAttach(reinterpret_cast<LPVOID*>(&RawNetUserGetInfo),
-                 reinterpret_cast<void*>(MyNetUserGetInfo));
-  }
-
-  auto status = DetourTransactionCommit();
-  if (status != NO_ERROR) {
-    DebugLog(L"MakeGreen failed: {}", status);
-  }
+  registry.RegisterDeferred(
+      L"MakeGreen", L"crypt32.dll",
+      {{L"CryptProtectData", reinterpret_cast<void**>(&RawCryptProtectData),
+        reinterpret_cast<void*>(MyCryptProtectData)},
+       {L"CryptUnprotectData",
+        reinterpret_cast<void**>(&RawCryptUnprotectData),
+        reinterpret_cast<void*>(MyCryptUnprotectData)}});
+
+  constexpr HookPredicate kShowPassword = [] {
+    return config.IsShowPassword();
+  };
+  registry.RegisterDeferred(
+      L"MakeGreen", L"advapi32.dll",
+      {{L"LogonUserW", reinterpret_cast<void**>(&RawLogonUserW),
+        reinterpret_cast<void*>(MyLogonUserW)}},
+      kShowPassword);
+  registry.RegisterDeferred(L"MakeGreen", L"shlwapi.dll",
+                            {{L"IsOS", reinterpret_cast<void**>(&RawIsOS),
+                              reinterpret_cast<void*>(MyIsOS)}},
+                            kShowPassword);
+  registry.RegisterDeferred(
+      L"MakeGreen", L"netapi32.dll",
+      {{L"NetUserGetInfo", reinterpret_cast<void**>(&RawNetUserGetInfo),
+        reinterpret_cast<void*>(MyNetUserGetInfo)}},
+      kShowPassword);
 }
@@ -0,0 +1,66 @@
+#ifndef CHROME_PLUS_SRC_HANDLERTABLE_H_
+#define CHROME_PLUS_SRC_HANDLERTABLE_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Handlers registered against a set of event classes, then frozen into one
+// priority-ordered array per class, so dispatching an event reads only the
+// handlers subscribed to its class. The input hook keeps one per hook; free
+// of Windows calls so the ordering can be tested and the dispatch measured
+// on any platform.
+template <typename Handler, size_t kClassCount>
+class HandlerTable {
+ public:
+  static_assert(kClassCount <= 32, "classes are tracked in a 32-bit mask");
+
+  // Subscribes `handler` to the classes whose bits are set in `classes`; a
+  // lower `priority` runs first, and equal priorities run in the order added.
+  // Returns false, adding nothing, once the table is frozen.
+  bool Add(Handler handler, int priority, uint32_t classes) {
+    if (frozen_) {
+      return false;
+    }
+    entries_.push_back({handler, priority, classes});
+    return true;
+  }
+
+  // Sorts the handlers into the per-class arrays; `Add` is closed from here.
+  void Freeze() {
+    frozen_ = true;
+    std::ranges::stable_sort(entries_, {}, &Entry::priority);
+    for (const Entry& entry : entries_) {
+      for (size_t i = 0; i < kClassCount; ++i) {
+        if (entry.classes & (1u << i)) {
+          handlers_[i].push_back(entry.handler);
+        }
+      }
+    }
+    entries_ = {};
+  }
+
+  bool frozen() const { return frozen_; }
+
+  // The handlers of `event_class` in the order to call them; empty before
+  // `Freeze`.
+  std::span<const Handler> handlers(size_t event_class) const {
+    return handlers_[event_class];
+  }
+
+ private:
+  struct Entry {
+    Handler handler;
+    int priority;
+    uint32_t classes;
+  };
+
+  std::vector<Entry> entries_;
+  std::array<std::vector<Handler>, kClassCount> handlers_;
+  bool frozen_ = false;
+};
+
+#endif  // CHROME_PLUS_SRC_HANDLERTABLE_H_
@@ -0,0 +1,18 @@
+#ifndef CHROME_PLUS_SRC_HASH_H_
+#define CHROME_PLUS_SRC_HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// FNV-1a over raw bytes, for cheap non-cryptographic fingerprints.
+inline uint64_t Fnv1aHash(std::span<const std::byte> bytes) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (auto b : bytes) {
+    hash ^= static_cast<uint64_t>(b);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+#endif  // CHROME_PLUS_SRC_HASH_H_
@@ -5,6 +5,8 @@
 #include <intrin.h>
 #include <stdint.h>
 
+#include <vector>
+
 #include "detours.h"
 
 #define NOP_FUNC        \
@@ -91,58 +93,109 @@ EXPORT(VerQueryValueW)
 
 namespace {
 // Internal helper functions are kept in the anonymous namespace
-void InstallDetours(PBYTE pTarget, PBYTE pDetour) {
-  DetourTransactionBegin();
-  DetourUpdateThread(GetCurrentThread());
-  DetourAttach(&reinterpret_cast<PVOID&>(pTarget), pDetour);
-  DetourTransactionCommit();
-}
 
+ForwardStats forward_stats;
+
+// Points each `hijack::` stub at the matching export of the system
+// version.dll. This runs in `DllMain` of every Chrome process -- browser,
+// renderers, GPU and utility -- under the loader lock, so every export is
+// resolved first and all stubs are patched in one Detours transaction: one
+// thread update and one instruction-cache flush instead of one per export.
+// (Pointing the stubs at a lazily filled jump table would avoid patching
+// code at all, but needs hand-written thunks for each of x86, x64 and ARM64,
+// since MSVC has no inline assembly on the latter two.)
 void LoadVersion(HINSTANCE module_handle) {
+  LARGE_INTEGER start;
+  QueryPerformanceCounter(&start);
+
   auto image_base = reinterpret_cast<PBYTE>(module_handle);
   auto dos_header = reinterpret_cast<PIMAGE_DOS_HEADER>(image_base);
-  if (dos_header->e_magic == IMAGE_DOS_SIGNATURE) {
-    auto nt_headers =
-        reinterpret_cast<PIMAGE_NT_HEADERS>(image_base + dos_header->e_lfanew);
-    if (nt_headers->Signature == IMAGE_NT_SIGNATURE) {
-      auto export_directory = reinterpret_cast<PIMAGE_EXPORT_DIRECTORY>(
-          image_base +
-          nt_headers->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT]
-              .VirtualAddress);
-      auto name_table = reinterpret_cast<DWORD*>(
-          image_base + export_directory->AddressOfNames);
-      auto function_table = reinterpret_cast<DWORD*>(
-          image_base + export_directory->AddressOfFunctions);
-      auto ordinals_table = reinterpret_cast<WORD*>(
-          image_base + export_directory->AddressOfNameOrdinals);
-
-      wchar_t system_directory[MAX_PATH + 1];
-      GetSystemDirectory(system_directory, MAX_PATH);
-
-      wchar_t dll_path[MAX_PATH + 1];
-      lstrcpy(dll_path, system_directory);
-      lstrcat(dll_path, TEXT("\\version.dll"));
-
-      HINSTANCE original_dll_handle = LoadLibrary(dll_path);
-      if (!original_dll_handle) {
-        return;
-      }
+  if (dos_header->e_magic != IMAGE_DOS_SIGNATURE) {
+    return;
+  }
+  auto nt_headers =
+      reinterpret_cast<PIMAGE_NT_HEADERS>(image_base + dos_header->e_lfanew);
+  if (nt_headers->Signature != IMAGE_NT_SIGNATURE) {
+    return;
+  }
+  auto export_directory = reinterpret_cast<PIMAGE_EXPORT_DIRECTORY>(
+      image_base +
+      nt_headers->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT]
+          .VirtualAddress);
+  auto name_table =
+      reinterpret_cast<DWORD*>(image_base + export_directory->AddressOfNames);
+  auto function_table = reinterpret_cast<DWORD*>(
+      image_base + export_directory->AddressOfFunctions);
+  auto ordinals_table = reinterpret_cast<WORD*>(
+      image_base + export_directory->AddressOfNameOrdinals);
+
+  wchar_t system_directory[MAX_PATH + 1];
+  GetSystemDirectory(system_directory, MAX_PATH);
 
-      for (size_t i = 0; i < export_directory->NumberOfNames; ++i) {
-        auto function_name =
-            reinterpret_cast<char*>(image_base + name_table[i]);
-        auto original_function = reinterpret_cast<PBYTE>(
-            GetProcAddress(original_dll_handle, function_name));
-        if (original_function) {
-          InstallDetours(image_base + function_table[ordinals_table[i]],
-                         original_function);
-        }
+  wchar_t dll_path[MAX_PATH + 1];
+  lstrcpy(dll_path, system_directory);
+  lstrcat(dll_path, TEXT("\\version.dll"));
+
+  HINSTANCE original_dll_handle = LoadLibrary(dll_path);
+  if (!original_dll_handle) {
+    return;
+  }
+
+  // `DetourAttach` keeps the address of each target pointer until the
+  // commit, so every stub needs its own slot; reserving up front keeps the
+  // slots from moving.
+  struct Forward {
+    PVOID target;
+    PVOID detour;
+  };
+  std::vector<Forward> forwards;
+  forwards.reserve(export_directory->NumberOfNames);
+  for (size_t i = 0; i < export_directory->NumberOfNames; ++i) {
+    auto function_name = reinterpret_cast<char*>(image_base + name_table[i]);
+    auto original_function = reinterpret_cast<PVOID>(
+        GetProcAddress(original_dll_handle, function_name));
+    if (original_function) {
+      forwards.push_back({image_base + function_table[ordinals_table[i]],
+                          original_function});
+    }
+  }
+
+  // Detours refuses to commit once any operation of the transaction failed,
+  // so a rejected export is dropped and the rest retried, as
+  // `HookRegistry::RunTransaction` does. Nothing is logged: this runs under
+  // the loader lock, so the counts go to `forward_stats` instead.
+  while (!forwards.empty()) {
+    ++forward_stats.transactions;
+    DetourTransactionBegin();
+    DetourUpdateThread(GetCurrentThread());
+    auto rejected = forwards.end();
+    for (auto it = forwards.begin(); it != forwards.end(); ++it) {
+      if (DetourAttach(&it->target, it->detour) != NO_ERROR) {
+        rejected = it;
+        break;
       }
     }
+    if (rejected == forwards.end()) {
+      if (DetourTransactionCommit() == NO_ERROR) {
+        forward_stats.forwarded = forwards.size();
+      }
+      break;
+    }
+    DetourTransactionAbort();
+    forwards.erase(rejected);
+    ++forward_stats.retries;
   }
+
+  LARGE_INTEGER end;
+  QueryPerformanceCounter(&end);
+  forward_stats.ticks = end.QuadPart - start.QuadPart;
 }
 }  // namespace
 
 void LoadSysDll(HINSTANCE hModule) {
   LoadVersion(hModule);
+}
+
+const ForwardStats& GetForwardStats() {
+  return forward_stats;
 }
\ No newline at end of file
@@ -5,4 +5,18 @@
 
 void LoadSysDll(HINSTANCE hModule);
 
+// What forwarding the version.dll exports cost. `LoadSysDll` runs in
+// `DllMain`, where nothing may be logged, so it only fills this in; the
+// loader logs it once the process is past the loader lock.
+struct ForwardStats {
+  // QueryPerformanceCounter ticks, 0 if the exports were never reached.
+  LONGLONG ticks = 0;
+  size_t forwarded = 0;
+  // Detours transactions begun, and how many of them were aborted on a
+  // rejected export and retried without it.
+  unsigned transactions = 0;
+  unsigned retries = 0;
+};
+const ForwardStats& GetForwardStats();
+
 #endif  // CHROME_PLUS_SRC_HIJACK_H_
@@ -0,0 +1,360 @@
+#include "hookregistry.h"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <initializer_list>
+#include <mutex>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "detours.h"
+
+#include "utils.h"
+
+namespace {
+
+// The loader's module-load notification (ntdll `LdrRegisterDllNotification`),
+// which has no SDK header; the layout is the documented one.
+constexpr ULONG kLdrDllNotificationReasonLoaded = 1;
+
+struct LdrUnicodeString {
+  USHORT Length;
+  USHORT MaximumLength;
+  PWSTR Buffer;
+};
+
+struct LdrDllLoadedNotificationData {
+  ULONG Flags;
+  const LdrUnicodeString* FullDllName;
+  const LdrUnicodeString* BaseDllName;
+  void* DllBase;
+  ULONG SizeOfImage;
+};
+
+using LdrDllNotificationFunction = void(CALLBACK*)(ULONG reason,
+                                                   const void* data,
+                                                   void* context);
+using LdrRegisterDllNotificationFunction =
+    LONG(NTAPI*)(ULONG flags,
+                 LdrDllNotificationFunction callback,
+                 void* context,
+                 void** cookie);
+using LdrUnregisterDllNotificationFunction = LONG(NTAPI*)(void* cookie);
+
+}  // namespace
+
+HookRegistry& HookRegistry::Instance() {
+  static HookRegistry instance;
+  return instance;
+}
+
+void HookRegistry::Register(const wchar_t* owner,
+                            std::initializer_list<HookSpec> hooks,
+                            HookPredicate enabled) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& spec : hooks) {
+    hooks_.push_back({owner, spec, enabled, nullptr, HookState::kPending,
+                      NO_ERROR, nullptr});
+  }
+}
+
+void HookRegistry::RegisterDeferred(const wchar_t* owner,
+                                    const wchar_t* module,
+                                    std::initializer_list<HookSpec> hooks,
+                                    HookPredicate enabled) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& spec : hooks) {
+    hooks_.push_back({owner, spec, enabled, module, HookState::kPending,
+                      NO_ERROR, nullptr});
+  }
+}
+
+void HookRegistry::Commit() {
+  // Predicates run first and without the lock: one may read the config or
+  // load a module, and a module load takes the lock in `OnDllNotification`.
+  std::vector<std::pair<size_t, HookPredicate>> predicates;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < hooks_.size(); ++i) {
+      if (hooks_[i].state == HookState::kPending && hooks_[i].enabled) {
+        predicates.emplace_back(i, hooks_[i].enabled);
+      }
+    }
+  }
+  std::vector<size_t> disabled;
+  for (const auto& [index, enabled] : predicates) {
+    if (!enabled()) {
+      disabled.push_back(index);
+    }
+  }
+
+  bool has_deferred = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const size_t index : disabled) {
+      hooks_[index].state = HookState::kDisabled;
+    }
+    has_deferred = HasDeferredHooks();
+  }
+  // Watch before looking modules up, so a module loading on another thread
+  // in between is caught by the callback, which waits for the lock. Without
+  // the notification, fall back to loading the modules now.
+  const bool watching = has_deferred && WatchModuleLoads();
+
+  size_t transactions = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Hook*> pending;
+    for (size_t i = 0; i < hooks_.size(); ++i) {
+      Hook& hook = hooks_[i];
+      if (hook.state != HookState::kPending) {
+        continue;
+      }
+      if (hook.module) {
+        HMODULE module = watching ? GetModuleHandleW(hook.module)
+                                  : LoadLibraryW(hook.module);
+        if (!module) {
+          hook.state = HookState::kWaiting;
+          deferred_.Add(i, hook.module);
+          continue;
+        }
+        if (!ResolveDeferred(hook, module)) {
+          continue;
+        }
+      }
+      hook.function = *hook.spec.target;
+      pending.push_back(&hook);
+    }
+    transactions = RunBatches(std::move(pending), true);
+  }
+  if (transactions != 0) {
+    DebugLog(L"HookRegistry: committed in {} transaction(s)", transactions);
+  }
+  // Every deferred module may have been loaded already.
+  UnwatchIfIdle();
+}
+
+void HookRegistry::Detach(void** target) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& hook : hooks_) {
+    if (hook.spec.target == target && hook.state == HookState::kAttached) {
+      RunBatches({&hook}, false);
+      if (hook.state != HookState::kDetached) {
+        DebugLog(L"HookRegistry: detaching {} failed: {}", hook.spec.name,
+                 hook.error);
+      }
+      return;
+    }
+  }
+}
+
+void HookRegistry::DetachAll() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<Hook*> attached;
+  for (auto& hook : hooks_ | std::views::reverse) {
+    if (hook.state == HookState::kAttached) {
+      attached.push_back(&hook);
+    }
+  }
+  RunBatches(std::move(attached), false);
+}
+
+void HookRegistry::LogStatus() {
+  static constexpr const wchar_t* kStateNames[] = {
+      L"pending", L"disabled", L"waiting", L"attached", L"failed", L"detached"};
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& hook : hooks_) {
+    DebugLog(L"HookRegistry: {} {} {} ({})", hook.owner, hook.spec.name,
+             kStateNames[static_cast<size_t>(hook.state)], hook.error);
+  }
+}
+
+// Runs under the loader lock, so it only resolves exports and patches code;
+// logging and unregistering are left to `ReportDeferred` on the thread pool.
+// It takes the registry lock too; no holder of that lock loads a module
+// while the notification is registered.
+void CALLBACK HookRegistry::OnDllNotification(ULONG reason,
+                                              const void* data,
+                                              void* context) {
+  if (reason != kLdrDllNotificationReasonLoaded) {
+    return;
+  }
+  const auto* loaded = static_cast<const LdrDllLoadedNotificationData*>(data);
+  auto& registry = *static_cast<HookRegistry*>(context);
+  std::lock_guard<std::mutex> lock(registry.mutex_);
+  if (registry.deferred_.empty()) {
+    return;
+  }
+
+  const std::wstring_view name(
+      loaded->BaseDllName->Buffer,
+      loaded->BaseDllName->Length / sizeof(wchar_t));
+  const std::vector<size_t> released = registry.deferred_.Release(name);
+  if (released.empty()) {
+    return;
+  }
+  std::vector<Hook*> ready;
+  for (const size_t index : released) {
+    Hook& hook = registry.hooks_[index];
+    if (registry.ResolveDeferred(hook, static_cast<HMODULE>(loaded->DllBase))) {
+      hook.function = *hook.spec.target;
+      ready.push_back(&hook);
+    }
+  }
+  registry.RunBatches(std::move(ready), true);
+
+  const auto attached = static_cast<size_t>(
+      std::ranges::count_if(released, [&](size_t index) {
+        return registry.hooks_[index].state == HookState::kAttached;
+      }));
+  registry.deferred_loads_.push_back(
+      {std::wstring(name), released.size(), attached});
+  if (!registry.report_queued_) {
+    registry.report_queued_ =
+        TrySubmitThreadpoolCallback(&ReportDeferred, &registry, nullptr) !=
+        FALSE;
+  }
+}
+
+void CALLBACK HookRegistry::ReportDeferred(PTP_CALLBACK_INSTANCE instance,
+                                           void* context) {
+  auto& registry = *static_cast<HookRegistry*>(context);
+  std::vector<DeferredLoad> loads;
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex_);
+    loads.swap(registry.deferred_loads_);
+    registry.report_queued_ = false;
+  }
+  for (const auto& load : loads) {
+    DebugLog(L"HookRegistry: {} loaded, attached {} of {} deferred hook(s)",
+             load.module, load.attached, load.released);
+  }
+  registry.UnwatchIfIdle();
+}
+
+bool HookRegistry::HasDeferredHooks() const {
+  return !deferred_.empty() ||
+         std::ranges::any_of(hooks_, [](const Hook& hook) {
+           return hook.module && hook.state == HookState::kPending;
+         });
+}
+
+bool HookRegistry::ResolveDeferred(Hook& hook, HMODULE module) {
+  const std::string export_name = WideToUtf8(hook.spec.name);
+  *hook.spec.target =
+      reinterpret_cast<void*>(GetProcAddress(module, export_name.c_str()));
+  if (!*hook.spec.target) {
+    hook.state = HookState::kFailed;
+    hook.error = ERROR_PROC_NOT_FOUND;
+    return false;
+  }
+  return true;
+}
+
+bool HookRegistry::WatchModuleLoads() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dll_notification_cookie_) {
+      return true;
+    }
+  }
+  auto register_notification =
+      reinterpret_cast<LdrRegisterDllNotificationFunction>(GetProcAddress(
+          GetModuleHandleW(L"ntdll.dll"), "LdrRegisterDllNotification"));
+  void* cookie = nullptr;
+  if (!register_notification ||
+      register_notification(0, &OnDllNotification, this, &cookie) < 0) {
+    DebugLog(L"HookRegistry: LdrRegisterDllNotification unavailable");
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  dll_notification_cookie_ = cookie;
+  return true;
+}
+
+void HookRegistry::UnwatchIfIdle() {
+  void* cookie = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (HasDeferredHooks()) {
+      return;
+    }
+    cookie = std::exchange(dll_notification_cookie_, nullptr);
+  }
+  if (!cookie) {
+    return;
+  }
+  auto unregister_notification =
+      reinterpret_cast<LdrUnregisterDllNotificationFunction>(GetProcAddress(
+          GetModuleHandleW(L"ntdll.dll"), "LdrUnregisterDllNotification"));
+  if (unregister_notification) {
+    unregister_notification(cookie);
+  }
+}
+
+size_t HookRegistry::RunBatches(std::vector<Hook*> hooks, bool attach) {
+  size_t transactions = 0;
+  while (!hooks.empty()) {
+    // One hook per function per transaction; the rest wait for the next.
+    std::vector<Hook*> batch;
+    std::vector<Hook*> rest;
+    std::vector<void*> functions;
+    for (Hook* hook : hooks) {
+      if (std::ranges::contains(functions, hook->function)) {
+        rest.push_back(hook);
+      } else {
+        functions.push_back(hook->function);
+        batch.push_back(hook);
+      }
+    }
+    for (;;) {
+      ++transactions;
+      if (RunTransaction(batch, attach)) {
+        break;
+      }
+      std::erase_if(batch, [](const Hook* hook) {
+        return hook->state == HookState::kFailed;
+      });
+      if (batch.empty()) {
+        break;
+      }
+    }
+    hooks = std::move(rest);
+  }
+  return transactions;
+}
+
+bool HookRegistry::RunTransaction(const std::vector<Hook*>& batch,
+                                  bool attach) {
+  DetourTransactionBegin();
+  DetourUpdateThread(GetCurrentThread());
+  for (Hook* hook : batch) {
+    const LONG error = attach ? DetourAttach(hook->spec.target,
+                                             hook->spec.detour)
+                              : DetourDetach(hook->spec.target,
+                                             hook->spec.detour);
+    if (error != NO_ERROR) {
+      // Detours refuses to commit once any operation failed; drop the
+      // rejected hook and let the caller retry the others.
+      DetourTransactionAbort();
+      hook->state = HookState::kFailed;
+      hook->error = error;
+      return false;
+    }
+  }
+
+  const LONG error = DetourTransactionCommit();
+  for (Hook* hook : batch) {
+    hook->error = error;
+    if (error != NO_ERROR) {
+      hook->state = HookState::kFailed;
+    } else {
+      hook->state = attach ? HookState::kAttached : HookState::kDetached;
+    }
+  }
+  return true;
+}
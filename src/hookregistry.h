@@ -0,0 +1,151 @@
+#ifndef CHROME_PLUS_SRC_HOOKREGISTRY_H_
+#define CHROME_PLUS_SRC_HOOKREGISTRY_H_
+
+#include <windows.h>
+
+#include <cstddef>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "deferredhookqueue.h"
+
+// One detour a module declares: `target` is the address of the module's
+// `Raw...` function pointer, which Detours swaps for the trampoline once the
+// hook is attached, and `detour` the replacement.
+struct HookSpec {
+  const wchar_t* name;
+  void** target;
+  void* detour;
+};
+
+// Evaluated when the hooks are committed; nullptr means always enabled.
+using HookPredicate = bool (*)();
+
+// Every startup detour goes through here: modules `Register` their hooks
+// and the caller attaches everything pending with one `Commit`, so the
+// browser pays one thread suspend and instruction-cache flush rather than
+// one per module. Each hook keeps its state and Detours error for
+// `LogStatus`.
+class HookRegistry {
+ public:
+  static HookRegistry& Instance();
+
+  HookRegistry(const HookRegistry&) = delete;
+  HookRegistry& operator=(const HookRegistry&) = delete;
+
+  void Register(const wchar_t* owner,
+                std::initializer_list<HookSpec> hooks,
+                HookPredicate enabled = nullptr);
+
+  // Hooks on exports of `module` that should not force it to load. Each
+  // `target` starts out null; the hook's `name` is the export resolved into
+  // it. `Commit` attaches them right away when `module` is already loaded and
+  // otherwise when the loader reports it, through `LdrRegisterDllNotification`
+  // -- a module that never loads is never touched. The notification is
+  // dropped once no deferred hook is left waiting. Only where the loader
+  // offers no notification does `Commit` load `module` itself.
+  void RegisterDeferred(const wchar_t* owner,
+                        const wchar_t* module,
+                        std::initializer_list<HookSpec> hooks,
+                        HookPredicate enabled = nullptr);
+
+  // Attaches every pending hook whose predicate holds. The predicates run
+  // first, outside the registry lock and before this commit registers any
+  // module notification, so they may load modules. A hook Detours rejects
+  // is marked failed and left out, and the rest still attach.
+  // Normally that takes one transaction. Two hooks on the same function go
+  // into consecutive transactions, because in one transaction the second
+  // would overwrite the first instead of chaining onto it.
+  void Commit();
+
+  // Detaches the attached hook whose `Raw...` pointer is `target`, for
+  // modules that unhook themselves once they are done.
+  void Detach(void** target);
+
+  // Detaches every attached hook, newest first.
+  void DetachAll();
+
+  // Writes each hook's owner, name, state and error to the debug log.
+  void LogStatus();
+
+ private:
+  enum class HookState {
+    kPending,
+    kDisabled,
+    kWaiting,
+    kAttached,
+    kFailed,
+    kDetached
+  };
+
+  struct Hook {
+    const wchar_t* owner;
+    HookSpec spec;
+    HookPredicate enabled;
+    // Host DLL of a deferred hook, nullptr otherwise.
+    const wchar_t* module;
+    HookState state;
+    LONG error;
+    // The hooked function's address, before `target` became the trampoline.
+    void* function;
+  };
+
+  HookRegistry() = default;
+  ~HookRegistry() = default;
+
+  // A module that released deferred hooks, for `ReportDeferred`.
+  struct DeferredLoad {
+    std::wstring module;
+    size_t released;
+    size_t attached;
+  };
+
+  static void CALLBACK OnDllNotification(ULONG reason,
+                                         const void* data,
+                                         void* context);
+
+  // Thread-pool callback queued by `OnDllNotification`, which runs under the
+  // loader lock: logs the deferred hooks attached since the last report and
+  // drops the notification when none is left waiting.
+  static void CALLBACK ReportDeferred(PTP_CALLBACK_INSTANCE instance,
+                                      void* context);
+
+  // Whether a deferred hook waits for its module or for `Commit`; requires
+  // the lock.
+  bool HasDeferredHooks() const;
+
+  // Points a deferred hook's `target` at its export in `module`; marks the
+  // hook failed when the export is missing.
+  bool ResolveDeferred(Hook& hook, HMODULE module);
+
+  // Registers `OnDllNotification` with the loader unless it already is;
+  // false when the loader offers no notification. Called without the
+  // registry lock, which the callback takes while the loader holds its own.
+  bool WatchModuleLoads();
+
+  // Unregisters `OnDllNotification` once no deferred hook is waiting. Called
+  // without the registry lock, for the same reason.
+  void UnwatchIfIdle();
+
+  // Attaches or detaches `hooks` in order, splitting them into as few
+  // transactions as the one-hook-per-function rule allows. Returns the number
+  // of transactions run.
+  size_t RunBatches(std::vector<Hook*> hooks, bool attach);
+
+  // Runs one transaction over `batch`. When Detours rejects a hook, marks it
+  // failed, aborts and returns false so the caller can retry the rest.
+  // Logs nothing, since it also runs under the loader lock; `LogStatus`
+  // reports the errors.
+  bool RunTransaction(const std::vector<Hook*>& batch, bool attach);
+
+  std::mutex mutex_;
+  std::vector<Hook> hooks_;
+  DeferredHookQueue deferred_;
+  std::vector<DeferredLoad> deferred_loads_;
+  bool report_queued_ = false;
+  void* dll_notification_cookie_ = nullptr;
+};
+
+#endif  // CHROME_PLUS_SRC_HOOKREGISTRY_H_
@@ -0,0 +1,210 @@
+#include "htmlrewriter.h"
+
+#include <cstring>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace {
+
+// The characters `std::isspace` accepts in the "C" locale.
+constexpr bool IsHtmlSpace(uint8_t c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+}  // namespace
+
+HtmlRewriter::HtmlRewriter(std::span<const Replacement> replacements,
+                           std::span<const uint8_t> groups)
+    : replacements_(replacements.begin(), replacements.end()),
+      group_bits_(replacements_.size(), 1),
+      same_find_(replacements_.size(), kNoMatch) {
+  if (!groups.empty()) {
+    for (size_t i = 0; i < replacements_.size(); ++i) {
+      group_bits_[i] = 1u << groups[i];
+    }
+  }
+
+  // Build the trie of find strings; 0 marks a missing edge, since no edge
+  // leads back to the root. Replacements sharing a find string are chained
+  // in order from the state it ends at.
+  next_.assign(kAlphabetSize, 0);
+  match_.assign(1, kNoMatch);
+  std::vector<int32_t> last_match(1, kNoMatch);
+  for (size_t i = 0; i < replacements_.size(); ++i) {
+    const std::string_view find = replacements_[i].first;
+    if (find.empty()) {
+      continue;
+    }
+    uint32_t state = 0;
+    for (const char c : find) {
+      // Growing `next_` below invalidates references into it.
+      const size_t edge = state * kAlphabetSize + static_cast<uint8_t>(c);
+      if (next_[edge] == 0) {
+        next_[edge] = static_cast<uint32_t>(match_.size());
+        next_.resize(next_.size() + kAlphabetSize, 0);
+        match_.push_back(kNoMatch);
+        last_match.push_back(kNoMatch);
+      }
+      state = next_[edge];
+    }
+    if (match_[state] == kNoMatch) {
+      match_[state] = static_cast<int32_t>(i);
+    } else {
+      same_find_[last_match[state]] = static_cast<int32_t>(i);
+    }
+    last_match[state] = static_cast<int32_t>(i);
+  }
+
+  // Breadth-first, fold each state's failure link into its missing edges, so
+  // a scan takes exactly one table lookup per byte. Each state also links to
+  // the nearest state on its failure chain where a find string ends, the
+  // longest find string that is a proper suffix of its path, and collects the
+  // groups of all of them, so a byte that ends no applied find string is
+  // ruled out with one mask test.
+  const size_t state_count = match_.size();
+  std::vector<uint32_t> fail(state_count, 0);
+  output_link_.assign(state_count, 0);
+  suffix_groups_.assign(state_count, 0);
+  std::vector<uint32_t> queue;
+  queue.reserve(state_count);
+  for (size_t c = 0; c < kAlphabetSize; ++c) {
+    if (const uint32_t child = next_[c]) {
+      queue.push_back(child);
+    }
+  }
+  for (size_t head = 0; head < queue.size(); ++head) {
+    const uint32_t state = queue[head];
+    const uint32_t fallback_state = fail[state];
+    output_link_[state] = match_[fallback_state] != kNoMatch
+                              ? fallback_state
+                              : output_link_[fallback_state];
+    suffix_groups_[state] = suffix_groups_[fallback_state];
+    for (int32_t i = match_[state]; i != kNoMatch; i = same_find_[i]) {
+      suffix_groups_[state] |= group_bits_[i];
+    }
+    for (size_t c = 0; c < kAlphabetSize; ++c) {
+      uint32_t& edge = next_[state * kAlphabetSize + c];
+      const uint32_t fallback = next_[fallback_state * kAlphabetSize + c];
+      if (edge != 0) {
+        fail[edge] = fallback;
+        queue.push_back(edge);
+      } else {
+        edge = fallback;
+      }
+    }
+  }
+}
+
+std::optional<size_t> HtmlRewriter::Rewrite(std::span<uint8_t> document,
+                                            bool trim_lines,
+                                            uint32_t group_mask) const {
+  // The output is written over the input from the front. It falls behind
+  // wherever trimming or a replacement shrinks the text; where it would
+  // catch up with the input still to be read, those input bytes are first
+  // moved aside to `spill`, which is read before the rest of the document.
+  uint8_t* const data = document.data();
+  const size_t size = document.size();
+  size_t written = 0;
+  size_t unread = 0;
+  std::vector<uint8_t> spill;
+  size_t spill_head = 0;
+  auto make_room = [&](size_t end) {
+    if (end > unread) {
+      spill.insert(spill.end(), data + unread, data + end);
+      unread = end;
+    }
+  };
+  auto read = [&](uint8_t& c) {
+    if (spill_head != spill.size()) {
+      c = spill[spill_head++];
+      if (spill_head == spill.size()) {
+        spill.clear();
+        spill_head = 0;
+      }
+      return true;
+    }
+    if (unread == size) {
+      return false;
+    }
+    c = data[unread++];
+    return true;
+  };
+
+  // A match always covers the last bytes written -- the automaton restarts
+  // at the root after each replacement -- so it is replaced by stepping back
+  // over it.
+  uint32_t state = 0;
+  auto emit = [&](uint8_t c) {
+    if (written == size) {
+      return false;
+    }
+    make_room(written + 1);
+    data[written++] = c;
+    state = next_[state * kAlphabetSize + c];
+    if (!(suffix_groups_[state] & group_mask)) {
+      return true;
+    }
+    // Longest find string first, then replacement order; the mask test
+    // above guarantees one applies.
+    int32_t match = kNoMatch;
+    for (uint32_t s = state; match == kNoMatch; s = output_link_[s]) {
+      for (int32_t i = match_[s]; i != kNoMatch; i = same_find_[i]) {
+        if (group_bits_[i] & group_mask) {
+          match = i;
+          break;
+        }
+      }
+    }
+    const auto& [find, replace] = replacements_[match];
+    written -= find.size();
+    if (replace.size() > size - written) {
+      return false;
+    }
+    make_room(written + replace.size());
+    memcpy(data + written, replace.data(), replace.size());
+    written += replace.size();
+    state = 0;
+    return true;
+  };
+
+  if (!trim_lines) {
+    for (uint8_t c; read(c);) {
+      if (!emit(c)) {
+        return std::nullopt;
+      }
+    }
+    return written;
+  }
+
+  // Whitespace inside a line is held back until the line goes on, and
+  // dropped at its end.
+  std::vector<uint8_t> blanks;
+  bool line_start = true;
+  if (!emit('\n')) {
+    return std::nullopt;
+  }
+  for (uint8_t c; read(c);) {
+    if (c == '\n') {
+      blanks.clear();
+      line_start = true;
+    } else if (IsHtmlSpace(c)) {
+      if (!line_start) {
+        blanks.push_back(c);
+      }
+      continue;
+    } else {
+      for (const uint8_t blank : blanks) {
+        if (!emit(blank)) {
+          return std::nullopt;
+        }
+      }
+      blanks.clear();
+      line_start = false;
+    }
+    if (!emit(c)) {
+      return std::nullopt;
+    }
+  }
+  return written;
+}
@@ -0,0 +1,65 @@
+#ifndef CHROME_PLUS_SRC_HTMLREWRITER_H_
+#define CHROME_PLUS_SRC_HTMLREWRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Rewrites a document in place in one pass: optionally minifies it line by
+// line (each line is emitted as "\n" plus the line without its surrounding
+// whitespace), and replaces every occurrence of each find string with its
+// replacement, matching all find strings at once with an Aho-Corasick
+// automaton run over the trimmed output as it is written.
+// Matches do not overlap and replaced text is not searched again, as with
+// repeated `ReplaceStringInPlace`; where two find strings overlap, the match
+// that ends first wins, and of several ending at the same byte the longest.
+//
+// Each replacement belongs to a group, and a pass applies only the groups it
+// is asked for, so one automaton serves every subset of a fixed rule set.
+class HtmlRewriter {
+ public:
+  using Replacement = std::pair<std::string_view, std::string_view>;
+
+  static constexpr size_t kMaxGroups = 32;
+
+  // The strings are referenced, not copied, and must outlive the rewriter.
+  // `groups[i]`, below `kMaxGroups`, is the group of `replacements[i]`; all
+  // replacements are in group 0 when `groups` is empty. Empty find strings
+  // are ignored, and of replacements with the same find string the first
+  // one applied wins.
+  explicit HtmlRewriter(std::span<const Replacement> replacements,
+                        std::span<const uint8_t> groups = {});
+
+  // Rewrites `document` in place with the replacements of the groups in
+  // `group_mask`, and returns the rewritten length. Returns std::nullopt when
+  // the result outgrows `document` at any point of the pass, leaving it
+  // partly rewritten.
+  std::optional<size_t> Rewrite(std::span<uint8_t> document,
+                                bool trim_lines,
+                                uint32_t group_mask = UINT32_MAX) const;
+
+ private:
+  static constexpr size_t kAlphabetSize = 256;
+  static constexpr int32_t kNoMatch = -1;
+
+  std::vector<Replacement> replacements_;
+  // Per replacement, its group's bit and the next replacement with the same
+  // find string, or `kNoMatch`.
+  std::vector<uint32_t> group_bits_;
+  std::vector<int32_t> same_find_;
+  // Dense transition table, `kAlphabetSize` entries per state, failure links
+  // folded in; state 0 is the root.
+  std::vector<uint32_t> next_;
+  // Per state, the first replacement whose find string ends exactly there,
+  // or `kNoMatch`; the nearest state on its failure chain that has one, or 0;
+  // and the group bits of every find string that is a suffix of its path.
+  std::vector<int32_t> match_;
+  std::vector<uint32_t> output_link_;
+  std::vector<uint32_t> suffix_groups_;
+};
+
+#endif  // CHROME_PLUS_SRC_HTMLREWRITER_H_
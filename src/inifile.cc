@@ -0,0 +1,305 @@
+#include "inifile.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ull;
+constexpr uint64_t kFnvPrime = 0x100000001b3ull;
+constexpr wchar_t kReplacementCharacter = 0xFFFD;
+
+constexpr wchar_t FoldAsciiCase(wchar_t c) {
+  return c >= L'A' && c <= L'Z' ? static_cast<wchar_t>(c - L'A' + L'a') : c;
+}
+
+bool EqualsIgnoreAsciiCase(std::wstring_view a, std::wstring_view b) {
+  return std::ranges::equal(a, b, [](wchar_t x, wchar_t y) {
+    return FoldAsciiCase(x) == FoldAsciiCase(y);
+  });
+}
+
+uint64_t HashName(uint64_t hash, std::wstring_view name) {
+  for (const wchar_t c : name) {
+    hash = (hash ^ static_cast<uint64_t>(FoldAsciiCase(c))) * kFnvPrime;
+  }
+  return hash;
+}
+
+// The key's hash continues the section's across a separator no name holds.
+uint64_t HashEntry(std::wstring_view section, std::wstring_view key) {
+  const uint64_t hash = HashName(kFnvOffsetBasis, section) * kFnvPrime;
+  return HashName(hash, key);
+}
+
+constexpr bool IsIniSpace(wchar_t c) {
+  return c == L' ' || c == L'\t';
+}
+
+std::wstring_view TrimLeft(std::wstring_view text) {
+  while (!text.empty() && IsIniSpace(text.front())) {
+    text.remove_prefix(1);
+  }
+  return text;
+}
+
+std::wstring_view Trim(std::wstring_view text) {
+  text = TrimLeft(text);
+  while (!text.empty() && IsIniSpace(text.back())) {
+    text.remove_suffix(1);
+  }
+  return text;
+}
+
+void AppendCodePoint(std::vector<wchar_t>& text, uint32_t code_point) {
+  if constexpr (sizeof(wchar_t) == 2) {
+    if (code_point >= 0x10000) {
+      code_point -= 0x10000;
+      text.push_back(static_cast<wchar_t>(0xD800 + (code_point >> 10)));
+      text.push_back(static_cast<wchar_t>(0xDC00 + (code_point & 0x3FF)));
+      return;
+    }
+  }
+  text.push_back(static_cast<wchar_t>(code_point));
+}
+
+// Strict UTF-8: overlong forms, surrogates and truncated sequences decode to
+// U+FFFD, one per offending byte.
+void DecodeUtf8(std::span<const uint8_t> bytes, std::vector<wchar_t>& text) {
+  text.reserve(bytes.size());
+  size_t pos = 0;
+  while (pos < bytes.size()) {
+    const uint8_t lead = bytes[pos];
+    if (lead < 0x80) {
+      text.push_back(static_cast<wchar_t>(lead));
+      ++pos;
+      continue;
+    }
+    size_t length = 0;
+    uint32_t code_point = 0;
+    uint32_t min_code_point = 0;
+    if ((lead & 0xE0) == 0xC0) {
+      length = 2;
+      code_point = lead & 0x1F;
+      min_code_point = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+      length = 3;
+      code_point = lead & 0x0F;
+      min_code_point = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+      length = 4;
+      code_point = lead & 0x07;
+      min_code_point = 0x10000;
+    }
+    bool valid = length != 0 && length <= bytes.size() - pos;
+    for (size_t i = 1; valid && i < length; ++i) {
+      const uint8_t trail = bytes[pos + i];
+      valid = (trail & 0xC0) == 0x80;
+      code_point = (code_point << 6) | (trail & 0x3F);
+    }
+    valid = valid && code_point >= min_code_point && code_point <= 0x10FFFF &&
+            (code_point < 0xD800 || code_point > 0xDFFF);
+    if (valid) {
+      AppendCodePoint(text, code_point);
+      pos += length;
+    } else {
+      text.push_back(kReplacementCharacter);
+      ++pos;
+    }
+  }
+}
+
+std::vector<wchar_t> Decode(std::span<const uint8_t> bytes) {
+  std::vector<wchar_t> text;
+  if (bytes.size() >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE) {
+    // UTF-16LE; a trailing odd byte is dropped.
+    text.resize((bytes.size() - 2) / 2);
+    for (size_t i = 0; i < text.size(); ++i) {
+      text[i] = static_cast<wchar_t>(bytes[2 + 2 * i] |
+                                     (bytes[3 + 2 * i] << 8));
+    }
+    return text;
+  }
+  if (bytes.size() >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB &&
+      bytes[2] == 0xBF) {
+    bytes = bytes.subspan(3);
+  }
+  DecodeUtf8(bytes, text);
+  return text;
+}
+
+// `RtlUnicodeStringToInteger` with base 0, which `GetPrivateProfileIntW`
+// uses; the value wraps modulo 2^32 like the original.
+int ParseInt(std::wstring_view text) {
+  text = TrimLeft(text);
+  bool negative = false;
+  if (!text.empty() && (text.front() == L'-' || text.front() == L'+')) {
+    negative = text.front() == L'-';
+    text.remove_prefix(1);
+  }
+  uint32_t base = 10;
+  if (text.size() >= 2 && text[0] == L'0') {
+    switch (FoldAsciiCase(text[1])) {
+      case L'x':
+        base = 16;
+        break;
+      case L'o':
+        base = 8;
+        break;
+      case L'b':
+        base = 2;
+        break;
+      default:
+        break;
+    }
+    if (base != 10) {
+      text.remove_prefix(2);
+    }
+  }
+  uint32_t value = 0;
+  for (const wchar_t c : text) {
+    const wchar_t folded = FoldAsciiCase(c);
+    uint32_t digit = base;
+    if (folded >= L'0' && folded <= L'9') {
+      digit = folded - L'0';
+    } else if (folded >= L'a' && folded <= L'f') {
+      digit = folded - L'a' + 10;
+    }
+    if (digit >= base) {
+      break;
+    }
+    value = value * base + digit;
+  }
+  return static_cast<int>(negative ? 0u - value : value);
+}
+
+}  // namespace
+
+IniFile IniFile::Parse(std::span<const uint8_t> bytes) {
+  IniFile ini;
+  ini.text_ = Decode(bytes);
+  const std::wstring_view text(ini.text_.data(), ini.text_.size());
+
+  // Lines of a duplicate section are dropped, as lookups only ever see the
+  // first section of a name.
+  bool in_section = false;
+  size_t pos = 0;
+  while (pos < text.size()) {
+    size_t end = text.find_first_of(L"\r\n", pos);
+    if (end == std::wstring_view::npos) {
+      end = text.size();
+    }
+    const std::wstring_view line = Trim(text.substr(pos, end - pos));
+    pos = end + 1;
+
+    if (line.empty() || line.front() == L';') {
+      continue;
+    }
+    if (line.front() == L'[') {
+      const std::wstring_view name =
+          Trim(line.substr(1, line.find(L']') - 1));
+      in_section = std::ranges::none_of(
+          ini.sections_, [name](const Section& section) {
+            return EqualsIgnoreAsciiCase(section.name, name);
+          });
+      if (in_section) {
+        ini.sections_.push_back(
+            {name, static_cast<uint32_t>(ini.entries_.size()), 0});
+      }
+      continue;
+    }
+    const size_t eq_pos = line.find(L'=');
+    if (!in_section || eq_pos == std::wstring_view::npos) {
+      continue;
+    }
+    const std::wstring_view key = Trim(line.substr(0, eq_pos));
+    if (key.empty()) {
+      continue;
+    }
+    ini.entries_.push_back({key, TrimLeft(line.substr(eq_pos + 1))});
+    ini.entry_sections_.push_back(
+        static_cast<uint32_t>(ini.sections_.size() - 1));
+    ++ini.sections_.back().entry_count;
+  }
+
+  if (ini.entries_.empty()) {
+    return ini;
+  }
+  const size_t mask = std::bit_ceil(ini.entries_.size() * 2) - 1;
+  ini.slots_.assign(mask + 1, 0);
+  for (size_t i = 0; i < ini.entries_.size(); ++i) {
+    const std::wstring_view section =
+        ini.sections_[ini.entry_sections_[i]].name;
+    const std::wstring_view key = ini.entries_[i].key;
+    // A key already present keeps its first value.
+    if (ini.Find(section, key)) {
+      continue;
+    }
+    size_t slot = HashEntry(section, key) & mask;
+    while (ini.slots_[slot] != 0) {
+      slot = (slot + 1) & mask;
+    }
+    ini.slots_[slot] = static_cast<uint32_t>(i + 1);
+  }
+  return ini;
+}
+
+std::optional<size_t> IniFile::Find(std::wstring_view section,
+                                    std::wstring_view key) const {
+  if (slots_.empty()) {
+    return std::nullopt;
+  }
+  const size_t mask = slots_.size() - 1;
+  for (size_t slot = HashEntry(section, key) & mask; slots_[slot] != 0;
+       slot = (slot + 1) & mask) {
+    const size_t index = slots_[slot] - 1;
+    if (EqualsIgnoreAsciiCase(entries_[index].key, key) &&
+        EqualsIgnoreAsciiCase(sections_[entry_sections_[index]].name,
+                              section)) {
+      return index;
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<std::wstring_view> IniFile::GetString(
+    std::wstring_view section,
+    std::wstring_view key) const {
+  const auto index = Find(section, key);
+  if (!index) {
+    return std::nullopt;
+  }
+  std::wstring_view value = entries_[*index].value;
+  if (value.size() >= 2 && (value.front() == L'"' || value.front() == L'\'') &&
+      value.back() == value.front()) {
+    value = value.substr(1, value.size() - 2);
+  }
+  return value;
+}
+
+std::optional<int> IniFile::GetInt(std::wstring_view section,
+                                   std::wstring_view key) const {
+  const auto value = GetString(section, key);
+  if (!value || value->empty()) {
+    return std::nullopt;
+  }
+  return ParseInt(*value);
+}
+
+std::span<const IniFile::Entry> IniFile::GetSection(
+    std::wstring_view section) const {
+  // Only a handful of sections; a scan beats hashing them.
+  for (const auto& candidate : sections_) {
+    if (EqualsIgnoreAsciiCase(candidate.name, section)) {
+      return std::span(entries_).subspan(candidate.first_entry,
+                                         candidate.entry_count);
+    }
+  }
+  return {};
+}
@@ -0,0 +1,72 @@
+#ifndef CHROME_PLUS_SRC_INIFILE_H_
+#define CHROME_PLUS_SRC_INIFILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// An INI document decoded and indexed in one pass, answering lookups the way
+// `GetPrivateProfile*` answers them for chrome++.ini: section and key names
+// match ASCII case-insensitively, the first of duplicate sections or keys
+// wins, and a value loses its surrounding whitespace and one pair of matching
+// quotes. Immutable once parsed. Free of Windows calls, so parsing can be
+// fuzzed and benchmarked on any platform.
+class IniFile {
+ public:
+  // One `key=value` line, both sides trimmed of whitespace; unlike
+  // `GetString`, the value keeps its quotes.
+  struct Entry {
+    std::wstring_view key;
+    std::wstring_view value;
+  };
+
+  // Decodes `bytes` by their BOM: UTF-16LE, or UTF-8 with or without one.
+  // Unlike Windows, which reads a BOM-less file in the ANSI code page, text
+  // without a BOM is taken as UTF-8; the two agree on ASCII.
+  static IniFile Parse(std::span<const uint8_t> bytes);
+
+  IniFile() = default;
+  IniFile(IniFile&&) = default;
+  IniFile& operator=(IniFile&&) = default;
+
+  // The trimmed, unquoted value of `key`, or std::nullopt when it is absent.
+  std::optional<std::wstring_view> GetString(std::wstring_view section,
+                                             std::wstring_view key) const;
+
+  // `key` read as `GetPrivateProfileIntW` reads it: an optional sign, then
+  // digits in base 10 or after a 0x, 0o or 0b prefix, up to the first other
+  // character. std::nullopt when the key is absent or its value empty.
+  std::optional<int> GetInt(std::wstring_view section,
+                            std::wstring_view key) const;
+
+  // Every `key=value` line of `section` in file order, skipping comments and
+  // lines without a key; empty when the section is missing.
+  std::span<const Entry> GetSection(std::wstring_view section) const;
+
+ private:
+  struct Section {
+    std::wstring_view name;
+    uint32_t first_entry;
+    uint32_t entry_count;
+  };
+
+  // Index of the entry for (`section`, `key`) in `entries_`, if any.
+  std::optional<size_t> Find(std::wstring_view section,
+                             std::wstring_view key) const;
+
+  // The decoded document; every view above points into it, and a move keeps
+  // the buffer in place.
+  std::vector<wchar_t> text_;
+  std::vector<Section> sections_;
+  std::vector<Entry> entries_;
+  // Per entry, its index in `sections_`.
+  std::vector<uint32_t> entry_sections_;
+  // Open-addressed hash of (section, key) to entry index plus one; 0 marks an
+  // empty slot. Sized to a power of two at most half full.
+  std::vector<uint32_t> slots_;
+};
+
+#endif  // CHROME_PLUS_SRC_INIFILE_H_
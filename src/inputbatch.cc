@@ -0,0 +1,47 @@
+#include "inputbatch.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+
+// The windows.h values, which this file does not include.
+constexpr uint32_t kModAlt = 0x0001;
+constexpr uint32_t kModControl = 0x0002;
+constexpr uint32_t kModShift = 0x0004;
+constexpr uint32_t kModWin = 0x0008;
+
+constexpr uint16_t kVkShift = 0x10;
+constexpr uint16_t kVkControl = 0x11;
+constexpr uint16_t kVkMenu = 0x12;
+constexpr uint16_t kVkLWin = 0x5B;
+
+}  // namespace
+
+void InputBatch::AddKey(uint16_t vk, bool key_up, bool extended) {
+  if (size_ == kCapacity) {
+    overflowed_ = true;
+    return;
+  }
+  events_[size_++] = {vk, key_up, extended};
+}
+
+void InputBatch::AddKeyStroke(uint16_t vk) {
+  AddKey(vk, false);
+  AddKey(vk, true);
+}
+
+void InputBatch::AddModifiers(uint32_t modifiers, bool key_up) {
+  if (modifiers & kModControl) {
+    AddKey(kVkControl, key_up, /*extended=*/false);
+  }
+  if (modifiers & kModShift) {
+    AddKey(kVkShift, key_up, /*extended=*/false);
+  }
+  if (modifiers & kModAlt) {
+    AddKey(kVkMenu, key_up, /*extended=*/false);
+  }
+  if (modifiers & kModWin) {
+    AddKey(kVkLWin, key_up, /*extended=*/false);
+  }
+}
@@ -0,0 +1,53 @@
+#ifndef CHROME_PLUS_SRC_INPUTBATCH_H_
+#define CHROME_PLUS_SRC_INPUTBATCH_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// One synthesized press or release. `vk` is a virtual-key code; the mouse
+// buttons `VK_LBUTTON`, `VK_RBUTTON` and `VK_MBUTTON` become mouse events when
+// the batch is sent. `extended` sets `KEYEVENTF_EXTENDEDKEY`.
+struct InputEvent {
+  uint16_t vk;
+  bool key_up;
+  bool extended;
+};
+
+// A whole synthesized input sequence -- modifier releases, presses, the key
+// itself and the restores -- composed on the stack and handed to
+// `SendInputBatch` (utils.h) as one `SendInput` call, so no real input can
+// interleave with it. Free of Windows calls so the composed sequence can be
+// inspected on any platform. A batch that ran out of room is marked
+// overflowed and must not be sent, as a partial sequence could leave a
+// modifier stuck down.
+class InputBatch {
+ public:
+  // Ample for the longest sequence built here, a remapped key with every
+  // modifier released, pressed and restored.
+  static constexpr size_t kCapacity = 32;
+
+  void AddKey(uint16_t vk, bool key_up, bool extended = true);
+
+  // A press then a release of `vk`.
+  void AddKeyStroke(uint16_t vk);
+
+  // Presses or releases each modifier in `modifiers`, a `RegisterHotKey`
+  // `MOD_*` mask, in the order Ctrl, Shift, Alt, Win, as plain (not extended)
+  // keys; Win is sent as the left Windows key.
+  void AddModifiers(uint32_t modifiers, bool key_up);
+
+  std::span<const InputEvent> events() const {
+    return std::span(events_).first(size_);
+  }
+  bool empty() const { return size_ == 0; }
+  bool overflowed() const { return overflowed_; }
+
+ private:
+  std::array<InputEvent, kCapacity> events_;
+  size_t size_ = 0;
+  bool overflowed_ = false;
+};
+
+#endif  // CHROME_PLUS_SRC_INPUTBATCH_H_
@@ -2,32 +2,67 @@
 
 #include <windows.h>
 
-#include <algorithm>
-#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
 
+#include "handlertable.h"
 #include "utils.h"
 
 namespace {
 
-template <typename Handler>
-struct HandlerEntry {
-  Handler handler;
-  int priority;
-};
+constexpr size_t kMouseEventCount = static_cast<size_t>(MouseEvent::kCount);
 
-std::vector<HandlerEntry<KeyboardHandler>> keyboard_handlers;
-std::vector<HandlerEntry<MouseHandler>> mouse_handlers;
+// Filled by the `Register...` calls, then frozen by `InstallInputHooks`;
+// the hooks only read them. Keyboard handlers all share one class.
+HandlerTable<KeyboardHandler, 1> keyboard_handlers;
+HandlerTable<MouseHandler, kMouseEventCount> mouse_handlers;
 
 HHOOK keyboard_hook = nullptr;
 HHOOK mouse_hook = nullptr;
 
+// Modifiers of the keyboard event being dispatched, once a handler asked.
+bool dispatching_key = false;
+std::optional<UINT> key_modifiers;
+
+UINT ReadKeyModifiers() {
+  UINT modifiers = 0;
+  if (IsKeyPressed(VK_MENU)) {
+    modifiers |= MOD_ALT;
+  }
+  if (IsKeyPressed(VK_CONTROL)) {
+    modifiers |= MOD_CONTROL;
+  }
+  if (IsKeyPressed(VK_SHIFT)) {
+    modifiers |= MOD_SHIFT;
+  }
+  if (IsKeyPressed(VK_LWIN) || IsKeyPressed(VK_RWIN)) {
+    modifiers |= MOD_WIN;
+  }
+  return modifiers;
+}
+
 LRESULT CALLBACK KeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
   if (nCode == HC_ACTION) {
-    for (const auto& entry : keyboard_handlers) {
-      if (entry.handler(wParam, lParam)) {
-        return 1;
+    // A handler that pumps messages can re-enter the hook; restore the outer
+    // event's state afterwards.
+    const bool outer_dispatching = dispatching_key;
+    const std::optional<UINT> outer_modifiers = key_modifiers;
+    dispatching_key = true;
+    key_modifiers.reset();
+    bool handled = false;
+    for (const KeyboardHandler handler : keyboard_handlers.handlers(0)) {
+      if (handler(wParam, lParam)) {
+        handled = true;
+        break;
       }
     }
+    dispatching_key = outer_dispatching;
+    key_modifiers = outer_modifiers;
+    if (handled) {
+      return 1;
+    }
   }
   return CallNextHookEx(keyboard_hook, nCode, wParam, lParam);
 }
@@ -37,7 +72,11 @@ LRESULT CALLBACK MouseProc(int nCode, WPARAM wParam, LPARAM lParam) {
     return CallNextHookEx(mouse_hook, nCode, wParam, lParam);
   }
 
-  if (wParam == WM_NCMOUSEMOVE) {
+  // Most messages, `WM_MOUSEMOVE` above all, end here when no handler
+  // subscribed to their class.
+  const MouseEvent event = GetMouseEvent(wParam);
+  if (event == MouseEvent::kCount ||
+      mouse_handlers.handlers(static_cast<size_t>(event)).empty()) {
     return CallNextHookEx(mouse_hook, nCode, wParam, lParam);
   }
 
@@ -47,8 +86,9 @@ LRESULT CALLBACK MouseProc(int nCode, WPARAM wParam, LPARAM lParam) {
     return CallNextHookEx(mouse_hook, nCode, wParam, lParam);
   }
 
-  for (const auto& entry : mouse_handlers) {
-    if (entry.handler(wParam, lParam)) {
+  for (const MouseHandler handler :
+       mouse_handlers.handlers(static_cast<size_t>(event))) {
+    if (handler(wParam, lParam)) {
       return 1;
     }
   }
@@ -60,24 +100,80 @@ LRESULT CALLBACK MouseProc(int nCode, WPARAM wParam, LPARAM lParam) {
 
 void RegisterKeyboardHandler(KeyboardHandler handler,
                              HandlerPriority priority) {
-  keyboard_handlers.emplace_back(std::move(handler), static_cast<int>(priority));
-  std::ranges::sort(keyboard_handlers, [](const auto& a, const auto& b) {
-    return a.priority < b.priority;
-  });
+  if (!keyboard_handlers.Add(handler, static_cast<int>(priority), 1)) {
+    DebugLog(L"InputHook: keyboard handler registered after install, ignored");
+  }
 }
 
-void RegisterMouseHandler(MouseHandler handler, HandlerPriority priority) {
-  mouse_handlers.emplace_back(std::move(handler), static_cast<int>(priority));
-  std::ranges::sort(mouse_handlers, [](const auto& a, const auto& b) {
-    return a.priority < b.priority;
-  });
+void RegisterMouseHandler(MouseHandler handler,
+                          std::initializer_list<MouseEvent> events,
+                          HandlerPriority priority) {
+  uint32_t mask = 0;
+  for (const MouseEvent event : events) {
+    if (event != MouseEvent::kCount) {
+      mask |= 1u << static_cast<size_t>(event);
+    }
+  }
+  if (!mouse_handlers.Add(handler, static_cast<int>(priority), mask)) {
+    DebugLog(L"InputHook: mouse handler registered after install, ignored");
+  }
+}
+
+MouseEvent GetMouseEvent(WPARAM message) {
+  switch (message) {
+    case WM_MOUSEMOVE:
+      return MouseEvent::kMove;
+    case WM_LBUTTONDOWN:
+    case WM_NCLBUTTONDOWN:
+      return MouseEvent::kLButtonDown;
+    case WM_LBUTTONUP:
+    case WM_NCLBUTTONUP:
+      return MouseEvent::kLButtonUp;
+    case WM_LBUTTONDBLCLK:
+    case WM_NCLBUTTONDBLCLK:
+      return MouseEvent::kLButtonDblClk;
+    case WM_MBUTTONDOWN:
+    case WM_NCMBUTTONDOWN:
+      return MouseEvent::kMButtonDown;
+    case WM_MBUTTONUP:
+    case WM_NCMBUTTONUP:
+      return MouseEvent::kMButtonUp;
+    case WM_MBUTTONDBLCLK:
+    case WM_NCMBUTTONDBLCLK:
+      return MouseEvent::kMButtonDblClk;
+    case WM_RBUTTONDOWN:
+    case WM_NCRBUTTONDOWN:
+      return MouseEvent::kRButtonDown;
+    case WM_RBUTTONUP:
+    case WM_NCRBUTTONUP:
+      return MouseEvent::kRButtonUp;
+    case WM_RBUTTONDBLCLK:
+    case WM_NCRBUTTONDBLCLK:
+      return MouseEvent::kRButtonDblClk;
+    case WM_MOUSEWHEEL:
+      return MouseEvent::kWheel;
+    default:
+      return MouseEvent::kCount;
+  }
 }
 
 bool IsKeyPressed(int vk) {
   return vk && (::GetKeyState(vk) & 0x8000) != 0;
 }
 
+UINT GetKeyModifiers() {
+  if (!dispatching_key) {
+    return ReadKeyModifiers();
+  }
+  if (!key_modifiers) {
+    key_modifiers = ReadKeyModifiers();
+  }
+  return *key_modifiers;
+}
+
 void InstallInputHooks() {
+  keyboard_handlers.Freeze();
+  mouse_handlers.Freeze();
   keyboard_hook = SetWindowsHookEx(WH_KEYBOARD, KeyboardProc, hInstance,
                                    GetCurrentThreadId());
   mouse_hook =
@@ -3,10 +3,12 @@
 
 #include <windows.h>
 
-#include <functional>
+#include <initializer_list>
 
-using KeyboardHandler = std::function<bool(WPARAM wParam, LPARAM lParam)>;
-using MouseHandler = std::function<bool(WPARAM wParam, LPARAM lParam)>;
+// Handlers are plain functions: the hooks call them on every input message,
+// and a direct call costs less than a type-erased one.
+using KeyboardHandler = bool (*)(WPARAM wParam, LPARAM lParam);
+using MouseHandler = bool (*)(WPARAM wParam, LPARAM lParam);
 
 enum class HandlerPriority {
   kHighest = 0,
@@ -16,15 +18,51 @@ enum class HandlerPriority {
   kLowest = 400,
 };
 
+// The classes of mouse messages a handler can subscribe to. A button class
+// covers the client and non-client message alike (`WM_LBUTTONDOWN` and
+// `WM_NCLBUTTONDOWN` are both `kLButtonDown`); the handler tells them apart by
+// `wParam`. `WM_NCMOUSEMOVE` and messages outside these classes reach no
+// handler.
+enum class MouseEvent {
+  kMove,
+  kLButtonDown,
+  kLButtonUp,
+  kLButtonDblClk,
+  kMButtonDown,
+  kMButtonUp,
+  kMButtonDblClk,
+  kRButtonDown,
+  kRButtonUp,
+  kRButtonDblClk,
+  kWheel,
+  kCount,
+};
+
+// Registration closes when `InstallInputHooks` runs; later calls are ignored.
+// Handlers of equal priority run in registration order.
 void RegisterKeyboardHandler(
     KeyboardHandler handler,
     HandlerPriority priority = HandlerPriority::kNormal);
 
+// `handler` is called only for messages in `events`.
 void RegisterMouseHandler(MouseHandler handler,
+                          std::initializer_list<MouseEvent> events,
                           HandlerPriority priority = HandlerPriority::kNormal);
 
+// The class of mouse message `message`, or `MouseEvent::kCount` for a message
+// no handler receives.
+MouseEvent GetMouseEvent(WPARAM message);
+
 bool IsKeyPressed(int vk);
 
+// The `MOD_ALT`, `MOD_CONTROL`, `MOD_SHIFT` and `MOD_WIN` keys held, as a
+// `RegisterHotKey`-style mask. During a keyboard event it is read once, on
+// first use, and shared by every handler of that event; outside one it is
+// read afresh.
+UINT GetKeyModifiers();
+
+// Freezes the registered handlers into per-class dispatch tables and installs
+// the hooks.
 void InstallInputHooks();
 
 #endif  // CHROME_PLUS_SRC_INPUTHOOK_H_
@@ -2,146 +2,46 @@
 
 #include <windows.h>
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
 
 #include "config.h"
+#include "inputbatch.h"
 #include "inputhook.h"
+#include "keytables.h"
+#include "snapshotpublisher.h"
 #include "utils.h"
 
 namespace {
 
-struct KeyMapping {
-  UINT source_vk;
-  UINT source_modifiers;
-  UINT target_vk;
-  UINT target_modifiers;
-  int target_command;
-};
-
-struct TranslateKey {
-  UINT vk = 0;
-  UINT modifiers = 0;
-};
-
-std::vector<KeyMapping> key_mappings;
-TranslateKey translate_key;
-
-bool CheckModifiers(UINT modifiers) {
-  const bool shift_ok = !(modifiers & MOD_SHIFT) || IsKeyPressed(VK_SHIFT);
-  const bool ctrl_ok = !(modifiers & MOD_CONTROL) || IsKeyPressed(VK_CONTROL);
-  const bool alt_ok = !(modifiers & MOD_ALT) || IsKeyPressed(VK_MENU);
-  const bool win_ok =
-      !(modifiers & MOD_WIN) || IsKeyPressed(VK_LWIN) || IsKeyPressed(VK_RWIN);
-
-  const bool no_extra_shift =
-      (modifiers & MOD_SHIFT) || !IsKeyPressed(VK_SHIFT);
-  const bool no_extra_ctrl =
-      (modifiers & MOD_CONTROL) || !IsKeyPressed(VK_CONTROL);
-  const bool no_extra_alt = (modifiers & MOD_ALT) || !IsKeyPressed(VK_MENU);
-  const bool no_extra_win = (modifiers & MOD_WIN) ||
-                            (!IsKeyPressed(VK_LWIN) && !IsKeyPressed(VK_RWIN));
-
-  return shift_ok && ctrl_ok && alt_ok && win_ok && no_extra_shift &&
-         no_extra_ctrl && no_extra_alt && no_extra_win;
-}
-
-void AddModifierInput(std::vector<INPUT>& inputs, WORD vk, bool key_up) {
-  INPUT input = {};
-  input.type = INPUT_KEYBOARD;
-  input.ki.wVk = vk;
-  input.ki.dwFlags = key_up ? KEYEVENTF_KEYUP : 0;
-  input.ki.dwExtraInfo = GetMagicCode();
-  inputs.emplace_back(input);
-}
-
-void SendModifiers(UINT modifiers, bool key_up) {
-  std::vector<INPUT> inputs;
-
-  if (modifiers & MOD_CONTROL) {
-    AddModifierInput(inputs, VK_CONTROL, key_up);
-  }
-  if (modifiers & MOD_SHIFT) {
-    AddModifierInput(inputs, VK_SHIFT, key_up);
-  }
-  if (modifiers & MOD_ALT) {
-    AddModifierInput(inputs, VK_MENU, key_up);
-  }
-  if (modifiers & MOD_WIN) {
-    AddModifierInput(inputs, VK_LWIN, key_up);
-  }
-
-  if (!inputs.empty()) {
-    SendInput(static_cast<UINT>(inputs.size()), inputs.data(), sizeof(INPUT));
-  }
-}
-
-void RestoreModifiersIfHeld(UINT modifiers) {
-  std::vector<INPUT> inputs;
-
-  if ((modifiers & MOD_CONTROL) && (GetAsyncKeyState(VK_CONTROL) & 0x8000)) {
-    AddModifierInput(inputs, VK_CONTROL, false);
-  }
-  if ((modifiers & MOD_SHIFT) && (GetAsyncKeyState(VK_SHIFT) & 0x8000)) {
-    AddModifierInput(inputs, VK_SHIFT, false);
-  }
-  if ((modifiers & MOD_ALT) && (GetAsyncKeyState(VK_MENU) & 0x8000)) {
-    AddModifierInput(inputs, VK_MENU, false);
-  }
-  if ((modifiers & MOD_WIN) && ((GetAsyncKeyState(VK_LWIN) & 0x8000) ||
-                                (GetAsyncKeyState(VK_RWIN) & 0x8000))) {
-    AddModifierInput(inputs, VK_LWIN, false);
-  }
-
-  if (!inputs.empty()) {
-    SendInput(static_cast<UINT>(inputs.size()), inputs.data(), sizeof(INPUT));
-  }
-}
-
-void SendMappedKey(const KeyMapping& mapping) {
-  // - to_release: source has but target doesn't (user is holding, need to
-  // release)
-  // - to_press: target has but source doesn't (need to press)
-  const UINT to_release = mapping.source_modifiers & ~mapping.target_modifiers;
-  const UINT to_press = mapping.target_modifiers & ~mapping.source_modifiers;
-
-  SendModifiers(to_release, true);
-  SendModifiers(to_press, false);
-
-  std::vector<INPUT> inputs;
-  {
-    INPUT input = {};
-    input.type = INPUT_KEYBOARD;
-    input.ki.wVk = static_cast<WORD>(mapping.target_vk);
-    input.ki.dwFlags = KEYEVENTF_EXTENDEDKEY;
-    input.ki.dwExtraInfo = GetMagicCode();
-    inputs.emplace_back(input);
-  }
-  {
-    INPUT input = {};
-    input.type = INPUT_KEYBOARD;
-    input.ki.wVk = static_cast<WORD>(mapping.target_vk);
-    input.ki.dwFlags = KEYEVENTF_EXTENDEDKEY | KEYEVENTF_KEYUP;
-    input.ki.dwExtraInfo = GetMagicCode();
-    inputs.emplace_back(input);
-  }
-  SendInput(static_cast<UINT>(inputs.size()), inputs.data(), sizeof(INPUT));
-
-  // Release modifiers we pressed
-  SendModifiers(to_press, true);
-
-  // Restore modifiers we released (if user still holding them)
-  RestoreModifiersIfHeld(to_release);
+// The keyboard handlers read the current tables lock-free; a config reload
+// builds and publishes new ones once rather than reparsing per key press.
+// The publisher keeps the last few alive, as a handler may still be reading
+// the previous ones.
+SnapshotPublisher<KeyTables> key_tables;
+
+// Sends the whole remap as one batch so no real input can land between its
+// events.
+void SendMappedKey(const KeyMappingEntry& mapping, UINT held) {
+  InputBatch batch;
+  AddMappedKey(mapping, held, batch);
+  SendInputBatch(batch);
 }
 
-void ExecuteMappedCommand(const KeyMapping& mapping) {
+void ExecuteMappedCommand(const KeyMappingEntry& mapping, UINT held) {
   // For commands, we need to release source modifiers temporarily
   const UINT to_release = mapping.source_modifiers;
 
-  SendModifiers(to_release, true);
+  InputBatch release;
+  release.AddModifiers(to_release, true);
+  SendInputBatch(release);
   ExecuteCommand(mapping.target_command);
-  RestoreModifiersIfHeld(to_release);
+  InputBatch restore;
+  restore.AddModifiers(to_release & held, false);
+  SendInputBatch(restore);
 }
 
 bool KeyMappingHandler(WPARAM wParam, LPARAM lParam) {
@@ -149,18 +49,22 @@ bool KeyMappingHandler(WPARAM wParam, LPARAM lParam) {
     return false;
   }
 
-  for (const auto& mapping : key_mappings) {
-    if (wParam == mapping.source_vk &&
-        CheckModifiers(mapping.source_modifiers)) {
-      if (mapping.target_command != 0) {
-        ExecuteMappedCommand(mapping);
-      } else {
-        SendMappedKey(mapping);
-      }
-      return true;
-    }
+  if (wParam >= KeyTables::kVkCount) {
+    return false;
   }
-  return false;
+  const KeyTables* tables = key_tables.Current();
+  const UINT held = GetKeyModifiers();
+  const KeyMappingEntry* mapping =
+      tables->Find(static_cast<uint32_t>(wParam), held);
+  if (!mapping) {
+    return false;
+  }
+  if (mapping->target_command != 0) {
+    ExecuteMappedCommand(*mapping, held);
+  } else {
+    SendMappedKey(*mapping, held);
+  }
+  return true;
 }
 
 bool TranslateKeyHandler(WPARAM wParam, LPARAM lParam) {
@@ -168,17 +72,16 @@ bool TranslateKeyHandler(WPARAM wParam, LPARAM lParam) {
     return false;
   }
 
-  if (translate_key.vk == 0) {
-    return false;
-  }
-
-  if (wParam != translate_key.vk || !CheckModifiers(translate_key.modifiers)) {
+  const KeyTables* tables = key_tables.Current();
+  if (!tables->IsTranslateKey(static_cast<uint32_t>(wParam),
+                              GetKeyModifiers())) {
     return false;
   }
 
   ExecuteCommand(IDC_SHOW_TRANSLATE);
-  keybd_event(VK_RIGHT, 0, 0, 0);
-  keybd_event(VK_RIGHT, 0, KEYEVENTF_KEYUP, 0);
+  InputBatch batch;
+  batch.AddKeyStroke(VK_RIGHT);
+  SendInputBatch(batch);
   return true;
 }
 
@@ -193,21 +96,23 @@ int ParseCommand(std::wstring_view str) {
   return result;
 }
 
-void InitKeyMapping() {
-  const auto& mappings = config.GetKeyMappings();
-
-  for (const auto& [source, target] : mappings) {
-    KeyMapping mapping = {};
+void ParseKeyMappings(const LiveSettings& live, KeyTables& tables) {
+  for (const auto& [source, target] : live.key_mappings) {
+    KeyMappingEntry mapping = {};
 
     // Pass false for no_repeat since we don't need MOD_NOREPEAT in key mappings
     UINT source_parsed = ParseHotkeys(source, /*no_repeat=*/false);
     mapping.source_modifiers = LOWORD(source_parsed);
     mapping.source_vk = HIWORD(source_parsed);
 
-    if (mapping.source_vk == 0) {
+    if (mapping.source_vk == 0 || mapping.source_vk >= KeyTables::kVkCount) {
       DebugLog(L"KeyMapping: Invalid source key '{}'", source);
       continue;
     }
+    if (tables.Find(mapping.source_vk, mapping.source_modifiers)) {
+      DebugLog(L"KeyMapping: Duplicate source key '{}'", source);
+      continue;
+    }
 
     if (target.starts_with(L"command:")) {
       std::wstring_view command_str = target;
@@ -228,38 +133,63 @@ void InitKeyMapping() {
       }
     }
 
-    key_mappings.emplace_back(mapping);
+    tables.Add(mapping);
     DebugLog(L"KeyMapping: Loaded {} -> {}", source, target);
   }
-
-  if (!key_mappings.empty()) {
-    RegisterKeyboardHandler(KeyMappingHandler, HandlerPriority::kHigh);
-    DebugLog(L"KeyMapping: Registered {} mappings", key_mappings.size());
-  }
 }
 
-void InitTranslateKey() {
-  const auto& translate_key_str = config.GetTranslateKey();
+TranslateKey ParseTranslateKey(const LiveSettings& live) {
+  const auto& translate_key_str = live.translate_key;
   if (translate_key_str.empty()) {
-    return;
+    return {};
   }
 
   UINT parsed = ParseHotkeys(translate_key_str, /*no_repeat=*/false);
+  TranslateKey translate_key;
   translate_key.modifiers = LOWORD(parsed);
   translate_key.vk = HIWORD(parsed);
 
   if (translate_key.vk == 0) {
     DebugLog(L"TranslateKey: Invalid key '{}'", translate_key_str);
-    return;
+    return {};
   }
+  return translate_key;
+}
 
-  RegisterKeyboardHandler(TranslateKeyHandler, HandlerPriority::kHigh);
-  DebugLog(L"TranslateKey: Registered '{}'", translate_key_str);
+// Builds the tables from one snapshot of the live settings and publishes
+// them.
+const KeyTables& PublishKeyTables(const LiveSettings& live) {
+  auto tables = std::make_unique<KeyTables>();
+  ParseKeyMappings(live, *tables);
+  tables->set_translate_key(ParseTranslateKey(live));
+  return key_tables.Publish(std::move(tables));
+}
+
+void OnConfigReload() {
+  const KeyTables& tables = PublishKeyTables(config.Live());
+  DebugLog(L"KeyMapping: Reloaded {} mappings", tables.mappings().size());
 }
 
 }  // namespace
 
 void KeyMapping() {
-  InitKeyMapping();
-  InitTranslateKey();
+  const LiveSettings& live = config.Live();
+  const KeyTables& tables = PublishKeyTables(live);
+
+  // With hot reload a mapping may appear later, so the handlers go in even
+  // while there is nothing to map yet; they must be registered before the
+  // input hooks are installed.
+  const bool hot_reload = config.IsHotReload();
+  if (hot_reload) {
+    config.AddReloadObserver(OnConfigReload);
+  }
+  if (hot_reload || !tables.mappings().empty()) {
+    RegisterKeyboardHandler(KeyMappingHandler, HandlerPriority::kHigh);
+    DebugLog(L"KeyMapping: Registered {} mappings",
+             tables.mappings().size());
+  }
+  if (hot_reload || tables.translate_key().vk != 0) {
+    RegisterKeyboardHandler(TranslateKeyHandler, HandlerPriority::kHigh);
+    DebugLog(L"TranslateKey: Registered '{}'", live.translate_key);
+  }
 }
\ No newline at end of file
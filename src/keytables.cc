@@ -0,0 +1,34 @@
+#include "keytables.h"
+
+#include <cstdint>
+
+#include "inputbatch.h"
+
+bool KeyTables::Add(const KeyMappingEntry& mapping) {
+  if (mapping.source_vk == 0 || mapping.source_vk >= kVkCount) {
+    return false;
+  }
+  uint16_t& slot =
+      lookup_[mapping.source_vk][mapping.source_modifiers & kModifierMask];
+  if (slot != 0) {
+    return false;
+  }
+  mappings_.push_back(mapping);
+  slot = static_cast<uint16_t>(mappings_.size());
+  return true;
+}
+
+void AddMappedKey(const KeyMappingEntry& mapping,
+                  uint32_t held,
+                  InputBatch& batch) {
+  const uint32_t to_release =
+      mapping.source_modifiers & ~mapping.target_modifiers;
+  const uint32_t to_press =
+      mapping.target_modifiers & ~mapping.source_modifiers;
+
+  batch.AddModifiers(to_release, true);
+  batch.AddModifiers(to_press, false);
+  batch.AddKeyStroke(static_cast<uint16_t>(mapping.target_vk));
+  batch.AddModifiers(to_press, true);
+  batch.AddModifiers(to_release & held, false);
+}
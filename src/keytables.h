@@ -0,0 +1,85 @@
+#ifndef CHROME_PLUS_SRC_KEYTABLES_H_
+#define CHROME_PLUS_SRC_KEYTABLES_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class InputBatch;
+
+// A `[keymapping]` entry: the source key with its exact modifier set maps to
+// either the target key and modifiers or, when `target_command` is non-zero,
+// a browser command. Modifiers are `MOD_ALT`, `MOD_CONTROL`, `MOD_SHIFT` and
+// `MOD_WIN` bits.
+struct KeyMappingEntry {
+  uint32_t source_vk;
+  uint32_t source_modifiers;
+  uint32_t target_vk;
+  uint32_t target_modifiers;
+  int target_command;
+};
+
+struct TranslateKey {
+  uint32_t vk = 0;
+  uint32_t modifiers = 0;
+};
+
+// The key mappings and translate key of one config snapshot, indexed so the
+// keyboard hook finds a key's mapping with one table load: a bucket per
+// virtual key and modifier set. Free of Windows calls so the lookup can be
+// tested and benchmarked on any platform.
+class KeyTables {
+ public:
+  static constexpr size_t kVkCount = 256;
+  // `MOD_ALT | MOD_CONTROL | MOD_SHIFT | MOD_WIN`; a modifier set indexes
+  // its bucket directly.
+  static constexpr uint32_t kModifierMask = 0xF;
+
+  // Adds `mapping` unless its source key is 0 or out of range, or the key
+  // and modifier set is already mapped -- only the first mapping, in file
+  // order, could ever match. Returns whether it was added.
+  bool Add(const KeyMappingEntry& mapping);
+
+  // The mapping of `vk` pressed with exactly `modifiers`, or nullptr.
+  const KeyMappingEntry* Find(uint32_t vk, uint32_t modifiers) const {
+    if (vk >= kVkCount) {
+      return nullptr;
+    }
+    const uint16_t slot = lookup_[vk][modifiers & kModifierMask];
+    return slot != 0 ? &mappings_[slot - 1] : nullptr;
+  }
+
+  std::span<const KeyMappingEntry> mappings() const { return mappings_; }
+
+  const TranslateKey& translate_key() const { return translate_key_; }
+  void set_translate_key(const TranslateKey& key) { translate_key_ = key; }
+
+  // Whether `vk` pressed with exactly `modifiers` is the translate key.
+  bool IsTranslateKey(uint32_t vk, uint32_t modifiers) const {
+    return translate_key_.vk != 0 && vk == translate_key_.vk &&
+           modifiers == (translate_key_.modifiers & kModifierMask);
+  }
+
+ private:
+  static constexpr size_t kModifierBuckets = kModifierMask + 1;
+  static_assert(kVkCount * kModifierBuckets < UINT16_MAX);
+
+  std::vector<KeyMappingEntry> mappings_;
+  // Per source vk and exact modifier set, the index of its mapping in
+  // `mappings_` plus one; 0 when unmapped. One mapping per bucket at most,
+  // so the index always fits.
+  std::array<std::array<uint16_t, kModifierBuckets>, kVkCount> lookup_ = {};
+  TranslateKey translate_key_;
+};
+
+// Appends the whole remap of `mapping` to `batch`: releases the source
+// modifiers the target lacks, presses the ones it adds, strokes the target key,
+// then undoes both. `held` are the modifiers down when the source key arrived;
+// only those are pressed again afterwards.
+void AddMappedKey(const KeyMappingEntry& mapping,
+                  uint32_t held,
+                  InputBatch& batch);
+
+#endif  // CHROME_PLUS_SRC_KEYTABLES_H_
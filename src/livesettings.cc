@@ -0,0 +1,85 @@
+#include "livesettings.h"
+
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "inifile.h"
+
+namespace {
+
+std::wstring GetString(const IniFile& ini,
+                       std::wstring_view section,
+                       std::wstring_view key) {
+  return std::wstring(ini.GetString(section, key).value_or(L""));
+}
+
+bool GetBool(const IniFile& ini,
+             std::wstring_view section,
+             std::wstring_view key,
+             bool default_value) {
+  return ini.GetInt(section, key).value_or(default_value ? 1 : 0) != 0;
+}
+
+int GetHoverTabDelay(const IniFile& ini) {
+  constexpr int kDefaultDelayMs = 400;
+  constexpr int kMaxDelayMs = 5000;
+  const int delay =
+      ini.GetInt(L"tabs", L"hover_tab_delay").value_or(kDefaultDelayMs);
+  if (delay < 0 || delay > kMaxDelayMs) {
+    return kDefaultDelayMs;
+  }
+  return delay;
+}
+
+// `new_tab_disable_name` is a comma-separated list whose names may each be
+// wrapped in double quotes, as `StringSplit` (utils.h) reads it.
+std::vector<std::wstring> SplitTabNames(std::wstring_view names) {
+  std::vector<std::wstring> result;
+  for (const auto& part : std::views::split(names, L',')) {
+    std::wstring_view name(part);
+    if (name.starts_with(L'"')) {
+      name.remove_prefix(1);
+    }
+    if (name.ends_with(L'"')) {
+      name.remove_suffix(1);
+    }
+    result.emplace_back(name);
+  }
+  return result;
+}
+
+}  // namespace
+
+LiveSettings ReadLiveSettings(const IniFile& ini) {
+  LiveSettings live;
+  live.translate_key = GetString(ini, L"general", L"translate_key");
+
+  // tabs
+  live.keep_last_tab = GetBool(ini, L"tabs", L"keep_last_tab", true);
+  live.double_click_close = GetBool(ini, L"tabs", L"double_click_close", true);
+  live.right_click_close = GetBool(ini, L"tabs", L"right_click_close", false);
+  live.wheel_tab = GetBool(ini, L"tabs", L"wheel_tab", true);
+  live.wheel_tab_when_press_rbutton =
+      GetBool(ini, L"tabs", L"wheel_tab_when_press_rbutton", true);
+  live.hover_tab = GetBool(ini, L"tabs", L"hover_tab", false);
+  live.hover_tab_delay = GetHoverTabDelay(ini);
+  live.open_url_new_tab =
+      ini.GetInt(L"tabs", L"open_url_new_tab").value_or(0);
+  live.bookmark_new_tab =
+      ini.GetInt(L"tabs", L"open_bookmark_new_tab").value_or(0);
+  live.new_tab_disable = GetBool(ini, L"tabs", L"new_tab_disable", true);
+  live.disable_tab_name = GetString(ini, L"tabs", L"new_tab_disable_name");
+  live.disable_tab_names = SplitTabNames(live.disable_tab_name);
+
+  // keymapping: lines with an empty value are skipped, as `GetIniSection`
+  // skips them.
+  for (const auto& [key, value] : ini.GetSection(L"keymapping")) {
+    if (!value.empty()) {
+      live.key_mappings.emplace_back(key, value);
+    }
+  }
+  return live;
+}
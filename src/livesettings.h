@@ -0,0 +1,42 @@
+#ifndef CHROME_PLUS_SRC_LIVESETTINGS_H_
+#define CHROME_PLUS_SRC_LIVESETTINGS_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+class IniFile;
+
+// The settings input hooks consult on every event. With `hot_reload` on,
+// each change to chrome++.ini publishes a new snapshot (see `Config::Live`),
+// so a handler loads it once per event and reads every field from that one
+// snapshot.
+struct LiveSettings {
+  using KeyMappingPair = std::pair<std::wstring, std::wstring>;
+
+  std::wstring translate_key;
+
+  // tabs
+  bool keep_last_tab;
+  bool double_click_close;
+  bool right_click_close;
+  bool wheel_tab;
+  bool wheel_tab_when_press_rbutton;
+  bool hover_tab;
+  int hover_tab_delay;
+  int open_url_new_tab;
+  int bookmark_new_tab;
+  bool new_tab_disable;
+  std::wstring disable_tab_name;
+  std::vector<std::wstring> disable_tab_names;
+
+  // keymapping
+  std::vector<KeyMappingPair> key_mappings;
+};
+
+// Reads the live settings from `ini`, with the defaults chrome++.ini
+// documents for absent keys. Free of Windows calls so it can be tested on
+// any platform.
+LiveSettings ReadLiveSettings(const IniFile& ini);
+
+#endif  // CHROME_PLUS_SRC_LIVESETTINGS_H_
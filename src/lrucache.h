@@ -0,0 +1,58 @@
+#ifndef CHROME_PLUS_SRC_LRUCACHE_H_
+#define CHROME_PLUS_SRC_LRUCACHE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// At most `kCapacity` values by key, most recently used first. Lookups scan
+// linearly, which for the handful of entries this is meant for beats any
+// hashing. Evicted and erased values are destroyed at once, so a value can
+// release what it holds in its destructor. Free of Windows calls so the
+// eviction order can be tested on any platform.
+template <typename Key, typename Value, size_t kCapacity>
+class LruCache {
+ public:
+  static_assert(kCapacity > 0);
+
+  // The value of `key`, made most recent, or nullptr.
+  Value* Find(const Key& key) {
+    const auto it = std::ranges::find(entries_, key, &Entry::key);
+    if (it == entries_.end()) {
+      return nullptr;
+    }
+    std::rotate(entries_.begin(), it, it + 1);
+    return &entries_.front().value;
+  }
+
+  // A default-constructed value for `key`, which must not be cached yet, as
+  // the most recent entry. When full, the least recently used one goes first.
+  Value& Insert(const Key& key) {
+    if (entries_.size() == kCapacity) {
+      entries_.pop_back();
+    }
+    entries_.insert(entries_.begin(), Entry{key, Value()});
+    return entries_.front().value;
+  }
+
+  // Drops every entry for which `pred(key, value)` holds.
+  template <typename Pred>
+  void EraseIf(Pred pred) {
+    std::erase_if(entries_, [&](const Entry& entry) {
+      return pred(std::as_const(entry.key), std::as_const(entry.value));
+    });
+  }
+
+  size_t size() const { return entries_.size(); }
+
+ private:
+  struct Entry {
+    Key key;
+    Value value;
+  };
+
+  std::vector<Entry> entries_;
+};
+
+#endif  // CHROME_PLUS_SRC_LRUCACHE_H_
@@ -1,30 +1,60 @@
 #include "pakfile.h"
 
-#include <windows.h>
-
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <ranges>
 #include <span>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include "hash.h"
+
+#include "fastinflate.h"
+
+#if defined(CHROME_PLUS_BROTLI)
+#include <brotli/decode.h>
+#include <brotli/encode.h>
+#endif
+
+#if defined(_MSC_VER)
 #pragma warning(disable : 4334)
 #pragma warning(disable : 4267)
 #pragma warning(disable : 4838)
+#endif
+
+// miniz's own header-only idiom: declarations of the streaming `tinfl` API
+// without a second copy of the implementation. Both files come from the
+// mini_gzip target's include directory.
+#define MINIZ_HEADER_FILE_ONLY
+#include "miniz.c"
 
 extern "C" {
-#include "..\mini_gzip\mini_gzip.h"
-void* gzip_compress(uint8_t* data, size_t len, size_t* out_len);
+#include "mini_gzip.h"
 int mini_gz_start(struct mini_gzip* gz_ptr, const void* mem, size_t mem_len);
 int mini_gz_unpack(struct mini_gzip* gz_ptr, void* mem_out, size_t mem_out_len);
 }
 
-namespace {
 #pragma pack(push)
 #pragma pack(1)
 
+struct PakIndex::Entry {
+  uint16_t resource_id;
+  uint32_t file_offset;
+};
+
+struct PakIndex::Alias {
+  uint16_t resource_id;
+  uint16_t entry_index;
+};
+
+namespace {
+
 constexpr int kPack4FileVersion = 4;
 constexpr int kPack5FileVersion = 5;
 
@@ -38,163 +68,903 @@ struct Pak5Header {
   uint16_t resource_count;
   uint16_t alias_count;
 };
+#pragma pack(pop)
 
-struct PakEntry {
-  uint16_t resource_id;
-  uint32_t file_offset;
-};
+// Entries below this size are never the patch target; skipping them keeps
+// the scan off the many small icons and strings in the pak.
+constexpr size_t kMinCandidateSize = 10 * 1024;
 
-struct PakAlias {
-  uint16_t resource_id;
-  uint16_t entry_index;
+// grit stores Brotli resources behind this magic and the decompressed size
+// as a 6-byte little-endian integer (`kBrotliConst`/`kBrotliHeaderSize` in
+// Chromium's ui/base/resource/resource_bundle.cc). `ResourceBundle` sniffs
+// gzip and Brotli per resource, so either format may be written back.
+constexpr uint8_t kBrotliMagic[] = {0x1E, 0x9B};
+constexpr size_t kBrotliHeaderSize = 8;
+
+enum class EntryCodec { kGzip, kBrotli };
+
+struct CompressedEntry {
+  std::span<uint8_t> data;
+  EntryCodec codec;
 };
-#pragma pack(pop)
 
-bool CheckHeader(uint8_t* buffer, PakEntry*& pak_entry, PakEntry*& end_entry) {
-  uint32_t version = *reinterpret_cast<uint32_t*>(buffer);
+bool IsBrotliEntry(std::span<const uint8_t> entry_data) {
+  return entry_data.size() > kBrotliHeaderSize &&
+         std::ranges::equal(entry_data.first(sizeof(kBrotliMagic)),
+                            kBrotliMagic);
+}
 
-  if (version != kPack4FileVersion && version != kPack5FileVersion)
-    return false;
+// Returns the entry when it is a compressed candidate worth decompressing.
+// Brotli entries count only in builds that can decode them
+// (`CHROME_PLUS_BROTLI`).
+std::optional<CompressedEntry> GetCandidate(const PakIndex& index,
+                                            size_t entry) {
+  std::span<uint8_t> entry_data = index.data(entry);
+  if (entry_data.size() < kMinCandidateSize) {
+    return std::nullopt;
+  }
 
-  if (version == kPack4FileVersion) {
-    auto* pak_header = reinterpret_cast<Pak4Header*>(buffer + sizeof(uint32_t));
-    if (pak_header->encoding != 1)
-      return false;
+  constexpr uint8_t kGzipMagic[] = {0x1F, 0x8B, 0x08};
+  if (std::ranges::equal(entry_data.subspan(0, sizeof(kGzipMagic)),
+                         kGzipMagic)) {
+    return CompressedEntry{entry_data, EntryCodec::kGzip};
+  }
+#if defined(CHROME_PLUS_BROTLI)
+  if (IsBrotliEntry(entry_data)) {
+    return CompressedEntry{entry_data, EntryCodec::kBrotli};
+  }
+#endif
+  return std::nullopt;
+}
 
-    pak_entry = reinterpret_cast<PakEntry*>(buffer + sizeof(uint32_t) +
-                                            sizeof(Pak4Header));
-    end_entry = pak_entry + pak_header->num_entries;
+// Decompressed size recorded in the entry: the gzip ISIZE trailer or the
+// Brotli header. 0 when it does not fit the patch callback's `uint32_t`.
+uint32_t GetDecompressedSize(const CompressedEntry& entry) {
+  if (entry.codec == EntryCodec::kGzip) {
+    // Entries start at any byte offset of the pak.
+    uint32_t size = 0;
+    memcpy(&size, entry.data.data() + entry.data.size() - sizeof(size),
+           sizeof(size));
+    return size;
   }
+  uint64_t size = 0;
+  for (size_t i = kBrotliHeaderSize; i > sizeof(kBrotliMagic); --i) {
+    size = (size << 8) | entry.data[i - 1];
+  }
+  return size <= UINT32_MAX ? static_cast<uint32_t>(size) : 0;
+}
 
-  if (version == kPack5FileVersion) {
-    auto* pak_header = reinterpret_cast<Pak5Header*>(buffer + sizeof(uint32_t));
-    if (pak_header->encoding != 1)
-      return false;
+// Returns the raw deflate stream of a gzip member (RFC 1952), without its
+// header fields and the CRC32/ISIZE trailer, or an empty span when the
+// header is malformed.
+std::span<const uint8_t> GetDeflateStream(std::span<const uint8_t> member) {
+  constexpr uint8_t kFlagHeaderCrc = 0x02;
+  constexpr uint8_t kFlagExtra = 0x04;
+  constexpr uint8_t kFlagName = 0x08;
+  constexpr uint8_t kFlagComment = 0x10;
+  constexpr size_t kHeaderSize = 10;
+  constexpr size_t kTrailerSize = 8;
+  if (member.size() < kHeaderSize + kTrailerSize) {
+    return {};
+  }
+
+  const uint8_t flags = member[3];
+  const size_t end = member.size() - kTrailerSize;
+  size_t pos = kHeaderSize;
+  if (flags & kFlagExtra) {
+    if (pos + 2 > end) {
+      return {};
+    }
+    pos += 2 + (member[pos] | (member[pos + 1] << 8));
+  }
+  for (const uint8_t flag : {kFlagName, kFlagComment}) {
+    if (flags & flag) {
+      while (pos < end && member[pos] != 0) {
+        ++pos;
+      }
+      ++pos;
+    }
+  }
+  if (flags & kFlagHeaderCrc) {
+    pos += 2;
+  }
+  if (pos >= end) {
+    return {};
+  }
+  return member.subspan(pos, end - pos);
+}
+
+// Decompresses a whole candidate into `out`, returning the number of bytes
+// produced. Gzip entries go through the word-at-a-time `FastInflate`
+// (fastinflate.cc) in builds with `CHROME_PLUS_FAST_INFLATE` and through
+// mini_gzip otherwise.
+size_t DecompressEntry(const CompressedEntry& entry, std::span<uint8_t> out) {
+#if defined(CHROME_PLUS_BROTLI)
+  if (entry.codec == EntryCodec::kBrotli) {
+    size_t decoded_size = out.size();
+    const auto stream = entry.data.subspan(kBrotliHeaderSize);
+    return BrotliDecoderDecompress(stream.size(), stream.data(),
+                                   &decoded_size, out.data()) ==
+                   BROTLI_DECODER_RESULT_SUCCESS
+               ? decoded_size
+               : 0;
+  }
+#endif
+  const std::span<const uint8_t> entry_data = entry.data;
+#if defined(CHROME_PLUS_FAST_INFLATE)
+  return FastInflate(GetDeflateStream(entry_data), out).value_or(0);
+#else
+  struct mini_gzip gz;
+  mini_gz_start(&gz, entry_data.data(), entry_data.size());
+  const int unpack_len = mini_gz_unpack(&gz, out.data(), out.size());
+  return unpack_len > 0 ? static_cast<size_t>(unpack_len) : 0;
+#endif
+}
 
-    pak_entry = reinterpret_cast<PakEntry*>(buffer + sizeof(uint32_t) +
-                                            sizeof(Pak5Header));
-    end_entry = pak_entry + pak_header->resource_count;
+// Deflate levels tried, in order, when a patched entry is written back. The
+// patch only shrinks the document, so a fast level nearly always fits the
+// entry's original slot; the maximum level -- formerly the only one, and the
+// most expensive step of the browser's patch -- is kept as the fallback.
+constexpr int kWriteBackLevels[] = {1, 6, 9};
+
+// Compresses `content` into a raw deflate stream at `level`. A non-empty
+// `history` is what the decoder will already have output right before it:
+// it is compressed first and its output, up to a sync flush, dropped, so the
+// stream can refer back into it the way the original stream did.
+std::vector<uint8_t> Deflate(std::span<const uint8_t> content,
+                             int level,
+                             std::span<const uint8_t> history = {}) {
+  struct Output {
+    std::vector<uint8_t> bytes;
+    bool keep = false;
+  } output;
+  auto put = [](const void* buffer, int length, void* user) -> mz_bool {
+    auto* output = static_cast<Output*>(user);
+    if (output->keep) {
+      const auto* bytes = static_cast<const uint8_t*>(buffer);
+      output->bytes.insert(output->bytes.end(), bytes, bytes + length);
+    }
+    return MZ_TRUE;
+  };
+  // `tdefl_compressor` is a few hundred KB, too large for the stack.
+  auto compressor = std::make_unique_for_overwrite<tdefl_compressor>();
+  if (tdefl_init(compressor.get(), put, &output,
+                 tdefl_create_comp_flags_from_zip_params(
+                     level, -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY)) !=
+      TDEFL_STATUS_OKAY) {
+    return {};
+  }
+  if (!history.empty() &&
+      tdefl_compress_buffer(compressor.get(), history.data(), history.size(),
+                            TDEFL_SYNC_FLUSH) != TDEFL_STATUS_OKAY) {
+    return {};
+  }
+  output.keep = true;
+  if (tdefl_compress_buffer(compressor.get(), content.data(), content.size(),
+                            TDEFL_FINISH) != TDEFL_STATUS_DONE) {
+    return {};
   }
+  return std::move(output.bytes);
+}
+
+// Finds the block of the original `stream` holding the first byte `content`
+// changed: everything before it can be kept as is. The stream is decoded only
+// up to the block after that one. Returns std::nullopt when the first block
+// already differs, so nothing would be kept, or the stream does not decode.
+std::optional<DeflateBlockStart> FindSplicePoint(
+    std::span<const uint8_t> stream,
+    std::span<const uint8_t> content,
+    uint32_t original_size) {
+  auto original = std::make_unique_for_overwrite<uint8_t[]>(original_size);
+  std::optional<DeflateBlockStart> current;
+  bool differs = false;
+  const auto decoded = FastInflate(
+      stream, std::span(original.get(), original_size),
+      {.on_block = [&](const DeflateBlockStart& block) {
+        // `current` is now fully decoded; compare it before moving on.
+        if (current) {
+          differs = block.out_offset > content.size() ||
+                    memcmp(original.get() + current->out_offset,
+                           content.data() + current->out_offset,
+                           block.out_offset - current->out_offset) != 0;
+          if (differs) {
+            return false;
+          }
+        }
+        current = block;
+        return true;
+      }});
+  if ((!decoded && !differs) || !current || current->out_offset == 0) {
+    return std::nullopt;
+  }
+  return current;
+}
+
+// Builds a stream decoding to `content` from the original `stream`'s blocks
+// before `splice` followed by `tail`, the deflate stream of the rest of
+// `content`. The kept blocks end mid-byte, so an empty stored block pads them
+// to a byte boundary first; `tail` then starts there unchanged.
+std::vector<uint8_t> SpliceDeflateStream(std::span<const uint8_t> stream,
+                                         const DeflateBlockStart& splice,
+                                         std::span<const uint8_t> tail) {
+  constexpr uint8_t kEmptyStoredBlock[] = {0x00, 0x00, 0xFF, 0xFF};  // LEN.
+  const size_t whole_bytes = splice.bit_offset / 8;
+  const size_t spare_bits = splice.bit_offset % 8;
+  // The stored block header (BFINAL = 0, BTYPE = 00) is three zero bits,
+  // padded with zeros to the next byte.
+  const size_t header_bytes = (spare_bits + 3 + 7) / 8;
+
+  std::vector<uint8_t> spliced;
+  spliced.reserve(whole_bytes + header_bytes + sizeof(kEmptyStoredBlock) +
+                  tail.size());
+  spliced.insert(spliced.end(), stream.begin(), stream.begin() + whole_bytes);
+  spliced.resize(whole_bytes + header_bytes, 0);
+  if (spare_bits != 0) {
+    spliced[whole_bytes] = stream[whole_bytes] & ((1u << spare_bits) - 1);
+  }
+  spliced.insert(spliced.end(), std::begin(kEmptyStoredBlock),
+                 std::end(kEmptyStoredBlock));
+  spliced.insert(spliced.end(), tail.begin(), tail.end());
+  return spliced;
+}
 
-  // In order to save the "next item" of the last item,
-  // the id of this special item must be 0
-  if (!end_entry || end_entry->resource_id != 0) {
+// Writes a gzip member holding `deflate`, the stream of `content`, over
+// `entry_data`, sized to fill the slot exactly: the room the stream leaves is
+// taken up by an FEXTRA field whose payload keeps the entry's original bytes
+// (it is opaque to gzip readers), so pages it covers are never written and
+// stay shared with the file cache instead of turning private. Returns false,
+// with the entry untouched, when the stream does not fit.
+bool FillGzipSlot(std::span<uint8_t> entry_data,
+                  std::span<const uint8_t> deflate,
+                  std::span<const uint8_t> content) {
+  constexpr size_t kHeaderSize = 12;  // Fixed fields plus XLEN.
+  constexpr size_t kTrailerSize = 8;
+  constexpr size_t kMaxExtraLength = 0xFFFF;
+  if (entry_data.size() < kHeaderSize + kTrailerSize) {
+    return false;
+  }
+  const size_t capacity = entry_data.size() - kHeaderSize - kTrailerSize;
+  if (deflate.empty() || deflate.size() > capacity ||
+      capacity - deflate.size() > kMaxExtraLength) {
     return false;
   }
 
+  const auto extra_length = static_cast<uint16_t>(capacity - deflate.size());
+  const uint8_t header[kHeaderSize] = {
+      0x1F, 0x8B, 0x08, 0x04,  // Magic, deflate, FEXTRA.
+      0,    0,    0,    0,     // MTIME.
+      0,    0xFF,              // XFL, OS (unknown).
+      static_cast<uint8_t>(extra_length),
+      static_cast<uint8_t>(extra_length >> 8)};
+  std::ranges::copy(header, entry_data.begin());
+  std::ranges::copy(deflate, entry_data.begin() + kHeaderSize + extra_length);
+
+  const uint32_t crc = static_cast<uint32_t>(
+      mz_crc32(MZ_CRC32_INIT, content.data(), content.size()));
+  const auto isize = static_cast<uint32_t>(content.size());
+  uint8_t* trailer = entry_data.data() + entry_data.size() - kTrailerSize;
+  for (int i = 0; i < 4; ++i) {
+    trailer[i] = static_cast<uint8_t>(crc >> (8 * i));
+    trailer[4 + i] = static_cast<uint8_t>(isize >> (8 * i));
+  }
   return true;
 }
 
-}  // namespace
+// Replaces the gzip member in `entry_data`, which decompressed to
+// `original_size` bytes, with one holding `content`. Patches usually touch a
+// single spot, so the original stream's blocks before the first changed byte
+// are kept and only the rest of `content` is compressed; the whole document
+// is recompressed only when that does not fit. Returns false, with the entry
+// untouched, when no level fits.
+bool WriteBackGzipEntry(std::span<uint8_t> entry_data,
+                        std::span<const uint8_t> content,
+                        uint32_t original_size) {
+  // The splice reads the original stream, so it is built in its own buffer
+  // before the slot is overwritten.
+  const std::span<const uint8_t> stream =
+      GetDeflateStream(std::span<const uint8_t>(entry_data));
+  if (const auto splice = FindSplicePoint(stream, content, original_size)) {
+    // Deflate's window: the tail may copy from the 32 KB before it.
+    constexpr size_t kWindowSize = 32 * 1024;
+    const size_t history_size = (std::min)(splice->out_offset, kWindowSize);
+    const auto history =
+        content.subspan(splice->out_offset - history_size, history_size);
+    for (const int level : kWriteBackLevels) {
+      const auto tail =
+          Deflate(content.subspan(splice->out_offset), level, history);
+      if (!tail.empty() &&
+          FillGzipSlot(entry_data, SpliceDeflateStream(stream, *splice, tail),
+                       content)) {
+        return true;
+      }
+    }
+  }
+  for (const int level : kWriteBackLevels) {
+    if (FillGzipSlot(entry_data, Deflate(content, level), content)) {
+      return true;
+    }
+  }
+  return false;
+}
 
-uint16_t TraversalGZIPFile(uint8_t* buffer,
-                           std::function<bool(uint8_t*, uint32_t, size_t&)>&& f,
-                           uint16_t target_resource_id) {
-  PakEntry* pak_entry = nullptr;
-  PakEntry* end_entry = nullptr;
+#if defined(CHROME_PLUS_BROTLI)
+// Brotli qualities tried, in order, when a patched Brotli entry is written
+// back; as with gzip, the cheap one usually fits and the maximum is the
+// fallback.
+constexpr int kBrotliWriteBackQualities[] = {5, 11};
+
+// Fills `padding` with metadata meta-blocks (RFC 7932 section 9.2), which
+// decoders skip. A block is a header of 1 + n bytes -- ISLAST = 0, MNIBBLES
+// coded as 3, a reserved zero bit, MSKIPBYTES = n, MSKIPLEN - 1 in n bytes,
+// zero bits up to the byte boundary -- followed by MSKIPLEN payload bytes,
+// which keep the entry's original bytes like the gzip FEXTRA padding. When no
+// single block fills the room exactly (n > 1 forbids a zero top byte), empty
+// one-byte blocks take up the difference.
+void WriteBrotliPadding(std::span<uint8_t> padding) {
+  constexpr uint8_t kEmptyMetadataBlock = 0x06;
+  size_t pos = 0;
+  while (pos < padding.size()) {
+    const size_t left = padding.size() - pos;
+    for (size_t n = 1; n <= 3; ++n) {
+      if (left < n + 2) {
+        break;
+      }
+      const uint64_t skip_minus_one = left - (n + 1) - 1;
+      if (skip_minus_one >> (8 * n) != 0 ||
+          (n > 1 && skip_minus_one >> (8 * (n - 1)) == 0)) {
+        continue;
+      }
+      const uint64_t header = 0x06 | (n << 4) | (skip_minus_one << 6);
+      for (size_t i = 0; i <= n; ++i) {
+        padding[pos + i] = static_cast<uint8_t>(header >> (8 * i));
+      }
+      return;
+    }
+    padding[pos++] = kEmptyMetadataBlock;
+  }
+}
 
-  if (!CheckHeader(buffer, pak_entry, end_entry)) {
-    return 0;
+// Brotli counterpart of `WriteBackGzipEntry`: the stream is flushed (byte
+// aligned, not yet final), the room left is filled by `WriteBrotliPadding`,
+// and a one-byte ISLAST/ISLASTEMPTY meta-block closes it in the slot's last
+// byte.
+bool WriteBackBrotliEntry(std::span<uint8_t> entry_data,
+                          std::span<const uint8_t> content) {
+  constexpr uint8_t kLastEmptyMetaBlock = 0x03;
+  if (entry_data.size() < kBrotliHeaderSize + 1) {
+    return false;
   }
+  const size_t capacity = entry_data.size() - kBrotliHeaderSize - 1;
 
-  do {
-    PakEntry* next_entry = pak_entry + 1;
-    if (target_resource_id != 0 &&
-        pak_entry->resource_id != target_resource_id) {
-      pak_entry = next_entry;
+  for (const int quality : kBrotliWriteBackQualities) {
+    std::unique_ptr<BrotliEncoderState, decltype(&BrotliEncoderDestroyInstance)>
+        encoder(BrotliEncoderCreateInstance(nullptr, nullptr, nullptr),
+                BrotliEncoderDestroyInstance);
+    if (!encoder) {
+      return false;
+    }
+    BrotliEncoderSetParameter(encoder.get(), BROTLI_PARAM_QUALITY, quality);
+    BrotliEncoderSetParameter(encoder.get(), BROTLI_PARAM_MODE,
+                              BROTLI_MODE_TEXT);
+    BrotliEncoderSetParameter(encoder.get(), BROTLI_PARAM_SIZE_HINT,
+                              static_cast<uint32_t>(content.size()));
+
+    auto encoded = std::make_unique_for_overwrite<uint8_t[]>(capacity);
+    const uint8_t* next_in = content.data();
+    size_t avail_in = content.size();
+    uint8_t* next_out = encoded.get();
+    size_t avail_out = capacity;
+    bool ok = true;
+    while (ok && (avail_in != 0 ||
+                  BrotliEncoderHasMoreOutput(encoder.get()))) {
+      ok = BrotliEncoderCompressStream(encoder.get(), BROTLI_OPERATION_FLUSH,
+                                       &avail_in, &next_in, &avail_out,
+                                       &next_out, nullptr) &&
+           (avail_out != 0 || !BrotliEncoderHasMoreOutput(encoder.get()));
+    }
+    if (!ok) {
       continue;
     }
 
-    size_t old_size = next_entry->file_offset - pak_entry->file_offset;
+    const size_t encoded_size = capacity - avail_out;
+    uint64_t size = content.size();
+    for (size_t i = 0; i < kBrotliHeaderSize; ++i) {
+      entry_data[i] = i < sizeof(kBrotliMagic)
+                          ? kBrotliMagic[i]
+                          : static_cast<uint8_t>(size >> (8 * (i - 2)));
+    }
+    std::ranges::copy(std::span(encoded.get(), encoded_size),
+                      entry_data.begin() + kBrotliHeaderSize);
+    WriteBrotliPadding(
+        entry_data.subspan(kBrotliHeaderSize + encoded_size,
+                           capacity - encoded_size));
+    entry_data.back() = kLastEmptyMetaBlock;
+    return true;
+  }
+  return false;
+}
+#endif
+
+bool WriteBackEntry(const CompressedEntry& entry,
+                    std::span<const uint8_t> content,
+                    uint32_t original_size) {
+#if defined(CHROME_PLUS_BROTLI)
+  if (entry.codec == EntryCodec::kBrotli) {
+    return WriteBackBrotliEntry(entry.data, content);
+  }
+#endif
+  return WriteBackGzipEntry(entry.data, content, original_size);
+}
 
-    if (old_size < 10 * 1024) {
-      pak_entry = next_entry;
-      continue;
+// Streaming content test for one entry: decodes it through one fixed 32 KB
+// window instead of an `original_size` allocation and searches each flushed
+// chunk for every needle still pending, carrying the last `longest needle - 1`
+// bytes across flushes so a match that straddles two chunks is still seen.
+// Decoding stops once every pending needle has been found; an entry without
+// them passes through the window once and is dropped. Between chunks
+// `cancelled`, given the needles found so far, says whether earlier entries
+// have already matched every needle this one could still supply: an entry
+// that has matched nothing by then is abandoned, one that has keeps what it
+// found. Only the window is ever live, so the caller decodes a matched entry
+// again, in full, to patch it.
+class StreamingMatcher {
+ public:
+  explicit StreamingMatcher(std::span<const std::span<const uint8_t>> needles) {
+    size_t longest = 0;
+    for (const auto& needle : needles) {
+      searchers_.emplace_back(needle.begin(), needle.end());
+      longest = (std::max)(longest, needle.size());
     }
+    overlap_ = longest - 1;
+    tail_.resize(overlap_);
+    stitch_.resize(2 * overlap_);
+  }
 
-    constexpr uint8_t kGzipMagic[] = {0x1F, 0x8B, 0x08};
-    std::span<uint8_t> entry_data(buffer + pak_entry->file_offset, old_size);
-    if (entry_data.size() < sizeof(kGzipMagic) ||
-        !std::ranges::equal(entry_data.subspan(0, sizeof(kGzipMagic)),
-                            kGzipMagic)) {
-      // Not a GZIP file, skipping
-      pak_entry = next_entry;
-      continue;
+  // Returns the mask of the needles in `pending` that occur in the entry.
+  template <typename Cancelled>
+  uint32_t EntryContains(const CompressedEntry& entry,
+                         uint32_t pending,
+                         Cancelled cancelled) {
+    pending_ = pending;
+    found_ = 0;
+    tail_size_ = 0;
+#if defined(CHROME_PLUS_BROTLI)
+    if (entry.codec == EntryCodec::kBrotli) {
+      BrotliContains(entry.data.subspan(kBrotliHeaderSize), cancelled);
+      return found_;
     }
+#endif
+    InflateContains(entry.data, cancelled);
+    return found_;
+  }
 
-    uint32_t original_size =
-        *reinterpret_cast<uint32_t*>(buffer + next_entry->file_offset - 4);
+ private:
+  using Searcher =
+      std::boyer_moore_horspool_searcher<std::span<const uint8_t>::iterator>;
+
+  // Without `TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF`, tinfl treats the
+  // output buffer as its LZ dictionary, which must be a power of two of at
+  // least 32 KB. `FastInflate` needs the whole output buffer, so the scan
+  // stays on tinfl in every build.
+  static constexpr size_t kWindowSize = TINFL_LZ_DICT_SIZE;
+
+  template <typename Cancelled>
+  void InflateContains(std::span<const uint8_t> member, Cancelled cancelled) {
+    const auto stream = GetDeflateStream(member);
+    if (stream.empty()) {
+      return;
+    }
 
-    auto unpack_buffer =
-        std::make_unique_for_overwrite<uint8_t[]>(original_size);
+    tinfl_init(&inflator_);
+    const uint8_t* next_in = stream.data();
+    size_t avail_in = stream.size();
+    size_t window_offset = 0;
+    for (;;) {
+      size_t in_bytes = avail_in;
+      size_t out_bytes = kWindowSize - window_offset;
+      const tinfl_status status =
+          tinfl_decompress(&inflator_, next_in, &in_bytes, window_,
+                           window_ + window_offset, &out_bytes, 0);
+      next_in += in_bytes;
+      avail_in -= in_bytes;
+      if (!Advance(std::span<const uint8_t>(window_ + window_offset, out_bytes),
+                   cancelled)) {
+        return;
+      }
+      window_offset = (window_offset + out_bytes) & (kWindowSize - 1);
+      if (status != TINFL_STATUS_HAS_MORE_OUTPUT) {
+        return;
+      }
+    }
+  }
 
-    if (!unpack_buffer) {
-      pak_entry = next_entry;
-      continue;
+#if defined(CHROME_PLUS_BROTLI)
+  // The Brotli decoder keeps its own ring buffer, so the window is only an
+  // output chunk here and is refilled from its start each round.
+  template <typename Cancelled>
+  void BrotliContains(std::span<const uint8_t> stream, Cancelled cancelled) {
+    std::unique_ptr<BrotliDecoderState, decltype(&BrotliDecoderDestroyInstance)>
+        decoder(BrotliDecoderCreateInstance(nullptr, nullptr, nullptr),
+                BrotliDecoderDestroyInstance);
+    if (!decoder) {
+      return;
     }
 
-    struct mini_gzip gz;
-    mini_gz_start(&gz, buffer + pak_entry->file_offset, old_size);
-    uint32_t unpack_len =
-        mini_gz_unpack(&gz, unpack_buffer.get(), original_size);
-
-    if (original_size == unpack_len) {
-      size_t new_len = old_size;
-      bool changed = f(unpack_buffer.get(), unpack_len, new_len);
-
-      if (changed) {
-        size_t compress_size = 0;
-        // `gzip_compress` is written in C style, so we free it using
-        // `std::free`
-        std::unique_ptr<void, decltype(&std::free)> compress_buffer_ptr(
-            gzip_compress(unpack_buffer.get(), new_len, &compress_size),
-            std::free);
-
-        auto* compress_buffer =
-            static_cast<uint8_t*>(compress_buffer_ptr.get());
-
-        if (compress_buffer && compress_size < old_size) {
-          std::span<uint8_t> src_span(compress_buffer, compress_size);
-          std::ranges::copy(src_span.subspan(0, 10), entry_data.begin());
-          entry_data[3] = 0x04;
-          uint16_t extra_length =
-              static_cast<uint16_t>(old_size - compress_size - 2);
-          auto extra_len_dest = reinterpret_cast<uint16_t*>(&entry_data[10]);
-          *extra_len_dest = extra_length;
-          std::ranges::fill(entry_data.subspan(12, extra_length), 0);
-          std::ranges::copy(src_span.subspan(10),
-                            entry_data.begin() + 12 + extra_length);
-        }
-        // Only one resource is the patch target; once the callback has handled
-        // it there is nothing left to find, so stop scanning the rest of the
-        // pak to avoid decompressing every remaining entry in each renderer
-        // process.
-        return pak_entry->resource_id;
+    const uint8_t* next_in = stream.data();
+    size_t avail_in = stream.size();
+    for (;;) {
+      uint8_t* next_out = window_;
+      size_t avail_out = kWindowSize;
+      const BrotliDecoderResult result = BrotliDecoderDecompressStream(
+          decoder.get(), &avail_in, &next_in, &avail_out, &next_out, nullptr);
+      if (!Advance(std::span<const uint8_t>(window_, kWindowSize - avail_out),
+                   cancelled)) {
+        return;
+      }
+      if (result != BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT) {
+        return;
       }
     }
-    pak_entry = next_entry;
-  } while (pak_entry->resource_id != 0);
+  }
+#endif
+
+  // Searches a freshly decoded `chunk`; false once there is nothing left to
+  // look for in this entry, either because every pending needle was found or
+  // because the entry is abandoned.
+  template <typename Cancelled>
+  bool Advance(std::span<const uint8_t> chunk, Cancelled cancelled) {
+    if (!chunk.empty() && Feed(chunk)) {
+      return false;
+    }
+    if (cancelled(found_)) {
+      // Keep what it matched; the rest is settled by earlier entries.
+      pending_ = found_;
+      return false;
+    }
+    return true;
+  }
 
-  return 0;
+  // Searches `bytes` for each pending needle not found yet; true once every
+  // pending needle has been found.
+  bool Search(std::span<const uint8_t> bytes) {
+    for (size_t i = 0; i < searchers_.size(); ++i) {
+      const uint32_t bit = 1u << i;
+      if ((pending_ & bit) && !(found_ & bit) &&
+          std::search(bytes.begin(), bytes.end(), searchers_[i]) !=
+              bytes.end()) {
+        found_ |= bit;
+      }
+    }
+    return found_ == pending_;
+  }
+
+  bool Feed(std::span<const uint8_t> chunk) {
+    if (tail_size_ != 0) {
+      const size_t head = (std::min)(overlap_, chunk.size());
+      std::ranges::copy(std::span(tail_).first(tail_size_), stitch_.begin());
+      std::ranges::copy(chunk.first(head), stitch_.begin() + tail_size_);
+      const auto stitch = std::span(stitch_).first(tail_size_ + head);
+      if (Search(stitch)) {
+        return true;
+      }
+      if (chunk.size() < overlap_) {
+        // The whole chunk fit in the stitch; keep its newest bytes.
+        const auto newest = stitch.last((std::min)(overlap_, stitch.size()));
+        std::ranges::copy(newest, tail_.begin());
+        tail_size_ = newest.size();
+        return false;
+      }
+    }
+    if (Search(chunk)) {
+      return true;
+    }
+    const auto newest = chunk.last((std::min)(overlap_, chunk.size()));
+    std::ranges::copy(newest, tail_.begin());
+    tail_size_ = newest.size();
+    return false;
+  }
+
+  std::vector<Searcher> searchers_;
+  uint32_t pending_ = 0;
+  uint32_t found_ = 0;
+  size_t overlap_ = 0;
+  std::vector<uint8_t> tail_;
+  size_t tail_size_ = 0;
+  std::vector<uint8_t> stitch_;
+  tinfl_decompressor inflator_;
+  uint8_t window_[kWindowSize];
+};
+
+// Runs `f` on the decompressed `content` of `candidate` and, when `f` changed
+// it, writes it back in place in the entry's own format. Returns whether the
+// patched content was written back: false both when `f` reported no change
+// and when the result no longer fits the entry, which is then left as is.
+bool PatchContent(const CompressedEntry& candidate,
+                  uint8_t* content,
+                  uint32_t size,
+                  const std::function<bool(uint8_t*, uint32_t, size_t&)>& f) {
+  size_t new_len = candidate.data.size();
+  return f(content, size, new_len) &&
+         WriteBackEntry(candidate, std::span(content, new_len), size);
+}
+
+// Decompresses one candidate and patches it with `PatchContent`.
+bool PatchCompressedEntry(
+    const PakIndex& index,
+    size_t entry,
+    const std::function<bool(uint8_t*, uint32_t, size_t&)>& f) {
+  const auto candidate = GetCandidate(index, entry);
+  if (!candidate) {
+    return false;
+  }
+  uint32_t original_size = GetDecompressedSize(*candidate);
+  if (original_size == 0) {
+    return false;
+  }
+
+  auto unpack_buffer = std::make_unique_for_overwrite<uint8_t[]>(original_size);
+
+  if (!unpack_buffer) {
+    return false;
+  }
+
+  const size_t unpack_len = DecompressEntry(
+      *candidate, std::span(unpack_buffer.get(), original_size));
+  if (original_size != unpack_len) {
+    return false;
+  }
+
+  return PatchContent(*candidate, unpack_buffer.get(), original_size, f);
 }
 
-std::optional<PakResourceSlot> FindResourceSlot(uint8_t* buffer,
-                                                uint16_t resource_id) {
-  PakEntry* pak_entry = nullptr;
-  PakEntry* end_entry = nullptr;
+}  // namespace
 
-  if (!CheckHeader(buffer, pak_entry, end_entry)) {
+PakIndex::PakIndex(std::span<uint8_t> pak,
+                   const Entry* entries,
+                   size_t entry_count,
+                   const Alias* aliases,
+                   size_t alias_count,
+                   size_t index_size)
+    : pak_(pak),
+      entries_(entries),
+      entry_count_(entry_count),
+      aliases_(aliases),
+      alias_count_(alias_count),
+      index_size_(index_size) {}
+
+std::optional<PakIndex> PakIndex::Parse(std::span<uint8_t> pak) {
+  uint32_t version = 0;
+  if (pak.size() < sizeof(version)) {
     return std::nullopt;
   }
+  memcpy(&version, pak.data(), sizeof(version));
 
-  do {
-    PakEntry* next_entry = pak_entry + 1;
-    if (pak_entry->resource_id == resource_id) {
-      return PakResourceSlot{pak_entry->file_offset,
-                             next_entry->file_offset - pak_entry->file_offset};
+  size_t offset = sizeof(version);
+  size_t entry_count = 0;
+  size_t alias_count = 0;
+  if (version == kPack4FileVersion) {
+    if (pak.size() - offset < sizeof(Pak4Header)) {
+      return std::nullopt;
     }
-    pak_entry = next_entry;
-  } while (pak_entry->resource_id != 0);
+    auto* pak_header = reinterpret_cast<Pak4Header*>(pak.data() + offset);
+    if (pak_header->encoding != 1) {
+      return std::nullopt;
+    }
+    entry_count = pak_header->num_entries;
+    offset += sizeof(Pak4Header);
+  } else if (version == kPack5FileVersion) {
+    if (pak.size() - offset < sizeof(Pak5Header)) {
+      return std::nullopt;
+    }
+    auto* pak_header = reinterpret_cast<Pak5Header*>(pak.data() + offset);
+    if (pak_header->encoding != 1) {
+      return std::nullopt;
+    }
+    entry_count = pak_header->resource_count;
+    alias_count = pak_header->alias_count;
+    offset += sizeof(Pak5Header);
+  } else {
+    return std::nullopt;
+  }
 
+  // The entry table holds one entry more than it counts: the sentinel, whose
+  // id must be 0 and whose offset ends the last resource. The alias table
+  // follows it.
+  const size_t available = pak.size() - offset;
+  if (entry_count >= available / sizeof(Entry)) {
+    return std::nullopt;
+  }
+  const size_t entries_size = (entry_count + 1) * sizeof(Entry);
+  if (alias_count > (available - entries_size) / sizeof(Alias)) {
+    return std::nullopt;
+  }
+  auto* entries = reinterpret_cast<const Entry*>(pak.data() + offset);
+  auto* aliases =
+      reinterpret_cast<const Alias*>(pak.data() + offset + entries_size);
+  if (entries[entry_count].resource_id != 0 ||
+      entries[entry_count].file_offset > pak.size()) {
+    return std::nullopt;
+  }
+  for (size_t i = 0; i < entry_count; ++i) {
+    if (entries[i].file_offset > entries[i + 1].file_offset ||
+        (i > 0 && entries[i].resource_id <= entries[i - 1].resource_id)) {
+      return std::nullopt;
+    }
+  }
+  for (size_t i = 1; i < alias_count; ++i) {
+    if (aliases[i].resource_id <= aliases[i - 1].resource_id) {
+      return std::nullopt;
+    }
+  }
+
+  return PakIndex(pak, entries, entry_count, aliases, alias_count,
+                  offset + entries_size + alias_count * sizeof(Alias));
+}
+
+uint16_t PakIndex::resource_id(size_t index) const {
+  return entries_[index].resource_id;
+}
+
+PakResourceSlot PakIndex::slot(size_t index) const {
+  return {entries_[index].file_offset,
+          entries_[index + 1].file_offset - entries_[index].file_offset};
+}
+
+std::span<uint8_t> PakIndex::data(size_t index) const {
+  const PakResourceSlot entry = slot(index);
+  return pak_.subspan(entry.offset, entry.length);
+}
+
+std::optional<size_t> PakIndex::Find(uint16_t resource_id) const {
+  const std::span entries(entries_, entry_count_);
+  // Projections return ids by value; the tables are packed.
+  const auto entry =
+      std::ranges::lower_bound(entries, resource_id, {}, [](const Entry& e) {
+        return uint16_t{e.resource_id};
+      });
+  if (entry != entries.end() && entry->resource_id == resource_id) {
+    return static_cast<size_t>(entry - entries.begin());
+  }
+
+  const std::span aliases(aliases_, alias_count_);
+  const auto alias =
+      std::ranges::lower_bound(aliases, resource_id, {}, [](const Alias& a) {
+        return uint16_t{a.resource_id};
+      });
+  if (alias != aliases.end() && alias->resource_id == resource_id &&
+      alias->entry_index < entry_count_) {
+    return alias->entry_index;
+  }
   return std::nullopt;
 }
+
+uint64_t PakIndex::Hash() const {
+  return Fnv1aHash(std::as_bytes(pak_.first(index_size_)));
+}
+
+uint16_t TraversalGZIPFile(const PakIndex& index,
+                           std::function<bool(uint8_t*, uint32_t, size_t&)>&& f,
+                           uint16_t target_resource_id) {
+  if (target_resource_id != 0) {
+    const auto entry = index.Find(target_resource_id);
+    return entry && PatchCompressedEntry(index, *entry, f) ? target_resource_id
+                                                           : 0;
+  }
+
+  for (size_t entry = 0; entry < index.size(); ++entry) {
+    // Only one resource is the patch target; once the callback has handled
+    // it there is nothing left to find, so stop scanning the rest of the
+    // pak to avoid decompressing every remaining entry in each renderer
+    // process.
+    if (PatchCompressedEntry(index, entry, f)) {
+      return index.resource_id(entry);
+    }
+  }
+  return 0;
+}
+
+std::vector<uint16_t> ScanGZIPFile(
+    const PakIndex& index,
+    std::span<const std::span<const uint8_t>> needles,
+    unsigned worker_count) {
+  std::vector<uint16_t> matches(needles.size());
+  // Needles are tracked in 32-bit masks.
+  const auto is_empty = [](std::span<const uint8_t> n) { return n.empty(); };
+  if (needles.empty() || needles.size() > 32 ||
+      std::ranges::any_of(needles, is_empty)) {
+    return matches;
+  }
+
+  std::vector<CompressedEntry> candidates;
+  std::vector<uint16_t> candidate_ids;
+  for (size_t entry = 0; entry < index.size(); ++entry) {
+    if (const auto candidate = GetCandidate(index, entry)) {
+      candidates.push_back(*candidate);
+      candidate_ids.push_back(index.resource_id(entry));
+    }
+  }
+  if (candidates.empty()) {
+    return matches;
+  }
+
+  // Candidates are handed out in index order, and a worker drops a needle
+  // from its entry once an earlier entry has matched it, abandoning the entry
+  // when no needle is left. So every entry before a needle's final match is
+  // searched for it in full: each needle resolves to its lowest-index match,
+  // the same one a sequential scan returns, whichever worker finds it first.
+  constexpr size_t kNoMatch = SIZE_MAX;
+  std::atomic<size_t> next_candidate = 0;
+  auto first_match =
+      std::make_unique<std::atomic<size_t>[]>(needles.size());
+  for (size_t i = 0; i < needles.size(); ++i) {
+    first_match[i] = kNoMatch;
+  }
+  // Needles that may still match at or after candidate `position`.
+  auto pending_at = [&](size_t position) {
+    uint32_t pending = 0;
+    for (size_t i = 0; i < needles.size(); ++i) {
+      if (first_match[i].load(std::memory_order_relaxed) > position) {
+        pending |= 1u << i;
+      }
+    }
+    return pending;
+  };
+  auto worker = [&] {
+    // Holds the window and tinfl state (~45 KB); one allocation serves every
+    // entry this worker examines.
+    auto matcher = std::make_unique<StreamingMatcher>(needles);
+    for (;;) {
+      const size_t next =
+          next_candidate.fetch_add(1, std::memory_order_relaxed);
+      // First matches only move down, so once nothing is pending here it
+      // never is again further on.
+      const uint32_t pending =
+          next < candidates.size() ? pending_at(next) : 0;
+      if (pending == 0) {
+        return;
+      }
+      const uint32_t found = matcher->EntryContains(
+          candidates[next], pending, [&](uint32_t found_so_far) {
+            return (pending_at(next) & ~found_so_far) == 0;
+          });
+      for (size_t i = 0; i < needles.size(); ++i) {
+        if (found & (1u << i)) {
+          size_t current = first_match[i].load(std::memory_order_relaxed);
+          while (next < current &&
+                 !first_match[i].compare_exchange_weak(current, next)) {
+          }
+        }
+      }
+    }
+  };
+
+  worker_count = static_cast<unsigned>(
+      std::clamp<size_t>(worker_count, 1, candidates.size()));
+  std::vector<std::thread> threads;
+  threads.reserve(worker_count - 1);
+  for (unsigned i = 1; i < worker_count; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (size_t i = 0; i < needles.size(); ++i) {
+    const size_t match = first_match[i].load();
+    matches[i] = match == kNoMatch ? 0 : candidate_ids[match];
+  }
+  return matches;
+}
+
+size_t CountUnsearchedEntries([[maybe_unused]] const PakIndex& index) {
+#if defined(CHROME_PLUS_BROTLI)
+  return 0;
+#else
+  size_t unsearched = 0;
+  for (size_t entry = 0; entry < index.size(); ++entry) {
+    unsearched += IsBrotliEntry(index.data(entry)) ? 1 : 0;
+  }
+  return unsearched;
+#endif
+}
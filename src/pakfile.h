@@ -1,9 +1,12 @@
 ﻿#ifndef CHROME_PLUS_SRC_PAKFILE_H_
 #define CHROME_PLUS_SRC_PAKFILE_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <optional>
+#include <span>
+#include <vector>
 
 // Byte range of one resource inside a mapped pak, from the pak index.
 struct PakResourceSlot {
@@ -11,18 +14,83 @@ struct PakResourceSlot {
   uint32_t length;
 };
 
-// Walks the pak's gzip entries, decompressing each candidate and running `f`
-// on it until `f` reports it patched its target; returns that entry's
-// resource id, or 0 when nothing was patched. A non-zero `target_resource_id`
-// skips every other entry without inflating it -- the per-renderer fast path,
-// where the browser has already located the target by content and handed its
-// id down (see pakpatch.cc).
-uint16_t TraversalGZIPFile(uint8_t* buffer,
+// Read-only view of a mapped pak's index (format v4 or v5): the entry table,
+// sorted by resource id and closed by a sentinel entry whose offset ends the
+// last resource, plus in v5 the alias table that maps further ids onto
+// existing entries. `Parse` checks the tables against the mapping once --
+// sizes, sort order, offsets -- so the lookups and accessors below need no
+// further bounds checks. Build it once per mapped pak and hand it to every
+// helper that reads the pak.
+class PakIndex {
+ public:
+  static std::optional<PakIndex> Parse(std::span<uint8_t> pak);
+
+  // Number of entries, not counting the sentinel.
+  size_t size() const { return entry_count_; }
+  uint16_t resource_id(size_t index) const;
+  PakResourceSlot slot(size_t index) const;
+  std::span<uint8_t> data(size_t index) const;
+
+  // Entry index holding `resource_id`, resolving v5 aliases; binary search
+  // over both tables.
+  std::optional<size_t> Find(uint16_t resource_id) const;
+
+  // Hash of the pak header and index (entry table with its end sentinel, plus
+  // the v5 alias table). Any rebuilt pak moves at least one offset, so this
+  // changes whenever Chrome ships new resources.
+  uint64_t Hash() const;
+
+ private:
+  struct Entry;
+  struct Alias;
+
+  PakIndex(std::span<uint8_t> pak,
+           const Entry* entries,
+           size_t entry_count,
+           const Alias* aliases,
+           size_t alias_count,
+           size_t index_size);
+
+  std::span<uint8_t> pak_;
+  const Entry* entries_;
+  size_t entry_count_;
+  const Alias* aliases_;
+  size_t alias_count_;
+  // Bytes from the start of the pak through the end of the alias table.
+  size_t index_size_;
+};
+
+// Walks the pak's compressed entries (gzip, plus Brotli in builds with
+// `CHROME_PLUS_BROTLI`), decompressing each candidate and running `f` on it
+// until `f` reports it patched its target, which is then written back in its
+// own format within its original slot; returns that entry's resource id, or
+// 0 when nothing was patched, including when the patched content no longer
+// fits the slot (the entry is then left unchanged). A non-zero
+// `target_resource_id` goes straight to that entry (or the entry it aliases)
+// without inflating any other -- the per-renderer fast path, where the
+// browser has already located the target by content and handed its id down
+// (see pakpatch.cc); the return value is then `target_resource_id` itself.
+uint16_t TraversalGZIPFile(const PakIndex& index,
                            std::function<bool(uint8_t*, uint32_t, size_t&)>&& f,
                            uint16_t target_resource_id = 0);
 
-// Locates `resource_id` from the pak index alone -- no decompression.
-std::optional<PakResourceSlot> FindResourceSlot(uint8_t* buffer,
-                                                uint16_t resource_id);
+// Content scan without materializing entries: streams each compressed
+// candidate through one 32 KB decompression window, searching for all
+// `needles` (at most 32) across window boundaries in the same pass, and
+// returns, per needle, the resource id of the first entry containing it, or
+// 0. An entry stops decoding as soon as it has matched every needle it could
+// still supply, and the scan stops once every needle has matched. Pair with a
+// targeted `TraversalGZIPFile` per distinct match to patch. `worker_count` > 1
+// spreads the candidates over that many threads (the caller's included); the
+// result is the same a single thread finds.
+std::vector<uint16_t> ScanGZIPFile(
+    const PakIndex& index,
+    std::span<const std::span<const uint8_t>> needles,
+    unsigned worker_count = 1);
+
+// Entries `ScanGZIPFile` skips because this build cannot decode them: the
+// Brotli ones in builds without `CHROME_PLUS_BROTLI`. Lets the caller explain
+// a needle that matched nothing.
+size_t CountUnsearchedEntries(const PakIndex& index);
 
 #endif  // CHROME_PLUS_SRC_PAKFILE_H_
@@ -2,31 +2,36 @@
 
 #include <windows.h>
 
-#include <sddl.h>
-
+#include <algorithm>
 #include <cstdint>
-#include <cwchar>
+#include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
 
-#include "detours.h"
-
+#include "config.h"
+#include "configsnapshot.h"
+#include "hookregistry.h"
 #include "pakfile.h"
+#include "pakrules.h"
 #include "utils.h"
-#include "version.h"
 
 namespace {
-#if defined(_M_ARM64)
-#define BUILD_ARCH " (ARM64)"
-#elif defined(_M_X64)
-#define BUILD_ARCH " (64-bit)"
-#else
-#define BUILD_ARCH " (32-bit)"
-#endif
 
 static HANDLE resources_pak_map = nullptr;
 
+// Identity of the mapped resources.pak, captured from the file handle in
+// `MyCreateFileMapping`; keys the on-disk patch cache below.
+struct PakFileStamp {
+  uint64_t size = 0;
+  uint64_t last_write_time = 0;
+};
+static PakFileStamp resources_pak_stamp;
+
 static auto RawCreateFileMapping = CreateFileMappingW;
 static auto RawMapViewOfFile = MapViewOfFile;
 
@@ -37,132 +42,449 @@ static auto RawMapViewOfFile = MapViewOfFile;
 // entry up to the target and re-deflated the patched one at level 9, on the
 // renderer main thread during `PreSandboxStartup` -- a freeze on every new
 // tab and cross-site navigation. Instead the browser scans once and hands the
-// result to its children through two inherited environment variables: the
-// target's pak resource id, so a renderer that has to decompress inflates
-// exactly one entry, and the name of a read-only section holding the
-// browser's already-patched entry, which a renderer applies with a single
-// memcpy and no decompression at all.
-constexpr wchar_t kPakTargetIdEnv[] = L"CHROME_PLUS_PAK_RES_ID";
-constexpr wchar_t kPakBlobEnv[] = L"CHROME_PLUS_PAK_BLOB";
-
+// result to its children in its config snapshot (`Config::PublishSnapshot`):
+// the pak resource ids it patched, so a renderer that has to decompress
+// inflates exactly those entries, and the name of a read-only section holding
+// the browser's already-patched entries, which a renderer applies with no
+// decompression at all.
+
+// The section holds the header, then for each patched entry a
+// `PakBlobEntry`, its `range_count` `PakBlobRange`s and the ranges' patched
+// bytes back to back, padded to `kPakBlobAlignment`. Only bytes that differ
+// from the pak on disk are published: a renderer writing an unchanged byte
+// into its copy-on-write view would still turn that whole page private, so
+// copying the full entry dirtied every page of it in every renderer.
 struct PakBlobHeader {
+  uint32_t entry_count;
+  uint32_t size;
+};
+
+struct PakBlobEntry {
   uint32_t resource_id;
   uint32_t length;
+  uint32_t range_count;
+  uint32_t data_size;
+};
+
+// A run of changed bytes, relative to the start of the entry.
+struct PakBlobRange {
+  uint32_t offset;
+  uint32_t length;
 };
 
+constexpr uint64_t kPakBlobAlignment = alignof(PakBlobEntry);
+
+// Size of one entry record, padded so the next record stays aligned.
+uint64_t PakBlobRecordSize(uint64_t range_count, uint64_t data_size) {
+  const uint64_t size =
+      sizeof(PakBlobEntry) + range_count * sizeof(PakBlobRange) + data_size;
+  return (size + kPakBlobAlignment - 1) & ~(kPakBlobAlignment - 1);
+}
+
+constexpr uint32_t kPageSize = 4096;
+
 // Keeps the published section alive for the browser's lifetime so child
 // processes can open it by name.
 static HANDLE published_blob_section = nullptr;
 
-// The loader calls `PakPatch()` only in the browser and in `--type=renderer`
-// children (chrome++.cc `Loader`), so no `-type=` switch means the browser.
-bool IsBrowserProcess() {
-  return !wcsstr(GetCommandLineW(), L"-type=");
+// The built-in settings-page rule followed by the `[pakpatch]` rules of
+// chrome++.ini, parsed once.
+const PakRuleSet& GetPakRules() {
+  static const PakRuleSet rules([] {
+    auto list = ParsePakRules(Config::Instance().GetPakPatchRules());
+    for (const auto& key : list.malformed) {
+      DebugLog(L"PakPatch: ignoring malformed rule {}", key);
+    }
+    if (list.ignored != 0) {
+      DebugLog(L"PakPatch: more than {} rules, ignoring the last {}",
+               kMaxPakRules, list.ignored);
+    }
+    return std::move(list.rules);
+  }());
+  return rules;
 }
 
-uint16_t GetPakTargetId() {
-  wchar_t value[8];
-  DWORD len = GetEnvironmentVariableW(kPakTargetIdEnv, value, ARRAYSIZE(value));
-  if (len == 0 || len >= ARRAYSIZE(value)) {
-    return 0;
+// The config snapshot above only lives as long as one browser process
+// tree, so every cold start used to redo the full content scan. The browser
+// therefore also keeps the patched entries in a file next to chrome++.ini, so
+// a later session costs one index lookup and one copy per entry. The key
+// covers the pak's size, mtime and index hash, so a Chrome update invalidates
+// it, and the patch rules, so a Chrome++ update or an edited `[pakpatch]`
+// section does too. The file lives beside version.dll itself and carries the
+// same trust.
+constexpr wchar_t kPakCacheFileName[] = L"\\chrome++.pakcache";
+constexpr uint32_t kPakCacheMagic = 0x4B505043;  // 'CPPK'
+constexpr uint32_t kPakCacheVersion = 2;
+
+struct PakCacheKey {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t file_size;
+  uint64_t last_write_time;
+  uint64_t index_hash;
+  uint64_t patch_hash;
+
+  bool operator==(const PakCacheKey&) const = default;
+};
+
+// Followed by `entry_count` records, each a `PakCacheEntry` and `length`
+// patched bytes.
+struct PakCacheHeader {
+  PakCacheKey key;
+  uint32_t entry_count;
+  uint32_t reserved;
+};
+
+struct PakCacheEntry {
+  uint32_t resource_id;
+  uint32_t length;
+};
+
+std::wstring GetPakCachePath() {
+  return GetAppDir() + kPakCacheFileName;
+}
+
+std::optional<PakCacheKey> MakePakCacheKey(const PakIndex& index) {
+  if (resources_pak_stamp.size == 0) {
+    return std::nullopt;
+  }
+  return PakCacheKey{
+      .magic = kPakCacheMagic,
+      .version = kPakCacheVersion,
+      .file_size = resources_pak_stamp.size,
+      .last_write_time = resources_pak_stamp.last_write_time,
+      .index_hash = index.Hash(),
+      .patch_hash = HashPakRules(GetPakRules().rules()),
+  };
+}
+
+// Returns the resource ids restored from the cache, empty on a miss. Each slot
+// is re-derived from this pak's own index and its length must match, as in
+// `ApplyPatchedEntries`; every record is read aside before the first is
+// copied, since a short read straight into a slot would leave a corrupt entry
+// behind.
+std::vector<uint16_t> LoadCachedPatches(const PakIndex& index) {
+  std::vector<uint16_t> resource_ids;
+  const auto key = MakePakCacheKey(index);
+  if (!key) {
+    return resource_ids;
+  }
+
+  HANDLE file = CreateFileW(GetPakCachePath().c_str(), GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return resource_ids;
+  }
+
+  std::vector<std::pair<std::span<uint8_t>, std::unique_ptr<uint8_t[]>>>
+      patches;
+  PakCacheHeader header;
+  DWORD read = 0;
+  bool ok = ReadFile(file, &header, sizeof(header), &read, nullptr) &&
+            read == sizeof(header) && header.key == *key &&
+            header.entry_count != 0 && header.entry_count <= kMaxPakRules;
+  for (uint32_t i = 0; ok && i < header.entry_count; ++i) {
+    PakCacheEntry record;
+    ok = ReadFile(file, &record, sizeof(record), &read, nullptr) &&
+         read == sizeof(record) && record.resource_id <= 0xFFFF;
+    const auto entry =
+        ok ? index.Find(static_cast<uint16_t>(record.resource_id))
+           : std::nullopt;
+    const auto slot = entry ? index.data(*entry) : std::span<uint8_t>();
+    ok = entry && slot.size() == record.length;
+    if (ok) {
+      auto patched = std::make_unique_for_overwrite<uint8_t[]>(slot.size());
+      ok = ReadFile(file, patched.get(), record.length, &read, nullptr) &&
+           read == record.length;
+      patches.emplace_back(slot, std::move(patched));
+      resource_ids.push_back(static_cast<uint16_t>(record.resource_id));
+    }
+  }
+  CloseHandle(file);
+
+  if (!ok) {
+    resource_ids.clear();
+    return resource_ids;
   }
-  wchar_t* end = nullptr;
-  unsigned long id = wcstoul(value, &end, 10);
-  if (end == value || id == 0 || id > 0xFFFF) {
-    return 0;
+  for (const auto& [slot, patched] : patches) {
+    memcpy(slot.data(), patched.get(), slot.size());
   }
-  return static_cast<uint16_t>(id);
+  DebugLog(L"PakPatch: restored {} resources from cache", resource_ids.size());
+  return resource_ids;
 }
 
-// Browser side: copy the patched slot into a named read-only section and
-// publish the name through the environment. Read-only is load-bearing: the
-// bytes feed the privileged settings WebUI in every renderer, so a writable
-// section would be an HTML injection vector into `chrome://settings`. The
-// DACL grants read to Everyone and to RestrictedCode (the renderer's
-// restricting SID), so a renderer's pre-lockdown token can open the section
-// at the same point it maps the pak.
-void PublishPatchedEntry(uint8_t* buffer, uint16_t resource_id) {
-  // After an in-app restart the new browser inherits the old browser's
-  // section name, which dies with that process; drop it and republish under
-  // this pid.
-  SetEnvironmentVariableW(kPakBlobEnv, nullptr);
-
-  const auto slot = FindResourceSlot(buffer, resource_id);
-  if (!slot) {
+// Writes through a per-process temporary file and renames it over the cache,
+// so a concurrent browser (another user data dir on the same install) never
+// reads a half-written file.
+void StoreCachedPatches(const PakIndex& index,
+                        std::span<const uint16_t> resource_ids) {
+  const auto key = MakePakCacheKey(index);
+  if (!key) {
+    return;
+  }
+  std::vector<std::pair<uint16_t, std::span<const uint8_t>>> patches;
+  for (const uint16_t resource_id : resource_ids) {
+    if (const auto entry = index.Find(resource_id)) {
+      patches.emplace_back(resource_id, index.data(*entry));
+    }
+  }
+  if (patches.empty()) {
     return;
   }
 
-  SECURITY_ATTRIBUTES sa{sizeof(sa), nullptr, FALSE};
-  if (!ConvertStringSecurityDescriptorToSecurityDescriptorW(
-          L"D:(A;;GR;;;WD)(A;;GR;;;RC)", SDDL_REVISION_1,
-          &sa.lpSecurityDescriptor, nullptr)) {
+  const std::wstring path = GetPakCachePath();
+  const std::wstring temp_path =
+      path + L"." + std::to_wstring(GetCurrentProcessId()) + L".tmp";
+  HANDLE file = CreateFileW(temp_path.c_str(), GENERIC_WRITE, 0, nullptr,
+                            CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
     return;
   }
 
+  const PakCacheHeader header{*key, static_cast<uint32_t>(patches.size()), 0};
+  DWORD written = 0;
+  bool ok = WriteFile(file, &header, sizeof(header), &written, nullptr) &&
+            written == sizeof(header);
+  for (const auto& [resource_id, slot] : patches) {
+    const PakCacheEntry record{resource_id,
+                               static_cast<uint32_t>(slot.size())};
+    ok = ok && WriteFile(file, &record, sizeof(record), &written, nullptr) &&
+         written == sizeof(record);
+    ok = ok &&
+         WriteFile(file, slot.data(), record.length, &written, nullptr) &&
+         written == record.length;
+  }
+  CloseHandle(file);
+
+  if (!ok || !MoveFileExW(temp_path.c_str(), path.c_str(),
+                          MOVEFILE_REPLACE_EXISTING)) {
+    DeleteFileW(temp_path.c_str());
+    return;
+  }
+  DebugLog(L"PakPatch: cached {} resources", patches.size());
+}
+
+// The ids the browser patched, from the inherited config snapshot.
+std::span<const uint16_t> GetPakTargetIds() {
+  const ConfigSnapshot* snapshot = Config::Inherited();
+  return snapshot ? snapshot->pak_target_ids() : std::span<const uint16_t>();
+}
+
+// Byte ranges where `patched` differs from `original`. Runs separated by fewer
+// identical bytes than a page are merged: such a gap lies within the pages the
+// two runs dirty anyway, so merging costs a few redundant bytes and saves a
+// range, never a page.
+std::vector<PakBlobRange> DiffPatchedEntry(std::span<const uint8_t> original,
+                                           std::span<const uint8_t> patched) {
+  constexpr uint32_t kMergeGap = 256;
+  static_assert(kMergeGap < kPageSize);
+
+  std::vector<PakBlobRange> ranges;
+  const auto size = static_cast<uint32_t>(patched.size());
+  uint32_t pos = 0;
+  while (pos < size) {
+    if (original[pos] == patched[pos]) {
+      ++pos;
+      continue;
+    }
+    uint32_t end = pos + 1;
+    while (end < size && original[end] != patched[end]) {
+      ++end;
+    }
+    if (!ranges.empty() &&
+        pos - (ranges.back().offset + ranges.back().length) < kMergeGap) {
+      ranges.back().length = end - ranges.back().offset;
+    } else {
+      ranges.push_back({pos, end - pos});
+    }
+    pos = end;
+  }
+  return ranges;
+}
+
+// Browser side: copy the patched slots into a named read-only section
+// (`CreatePublishedSection`) and return its name for the config snapshot, or
+// an empty name when nothing was published. A renderer opens the section at
+// the same point it maps the pak. `original` is a read-only view of the same
+// pak section, which still shows the file's bytes; without it each whole
+// entry is published as one range.
+std::wstring PublishPatchedEntries(const PakIndex& index,
+                                   const uint8_t* original,
+                                   std::span<const uint16_t> resource_ids) {
+  struct Record {
+    uint16_t resource_id;
+    std::span<const uint8_t> patched;
+    std::vector<PakBlobRange> ranges;
+    uint32_t data_size = 0;
+  };
+  std::vector<Record> records;
+  uint64_t blob_size = sizeof(PakBlobHeader);
+  for (const uint16_t resource_id : resource_ids) {
+    const auto entry = index.Find(resource_id);
+    if (!entry) {
+      continue;
+    }
+    const PakResourceSlot slot = index.slot(*entry);
+    Record& record = records.emplace_back(resource_id, index.data(*entry));
+    if (original) {
+      record.ranges = DiffPatchedEntry({original + slot.offset, slot.length},
+                                       record.patched);
+    } else {
+      record.ranges.push_back({0, slot.length});
+    }
+    for (const auto& range : record.ranges) {
+      record.data_size += range.length;
+    }
+    blob_size += PakBlobRecordSize(record.ranges.size(), record.data_size);
+  }
+  if (records.empty() || blob_size > UINT32_MAX) {
+    return {};
+  }
+
+  // On failure, including a squatted name, children fall back to
+  // decompressing.
   const std::wstring name =
       L"Local\\ChromePlusPakBlob_" + std::to_wstring(GetCurrentProcessId());
-  const DWORD size = static_cast<DWORD>(sizeof(PakBlobHeader) + slot->length);
-  HANDLE section = CreateFileMappingW(INVALID_HANDLE_VALUE, &sa, PAGE_READWRITE,
-                                      0, size, name.c_str());
-  const DWORD create_error = GetLastError();
-  LocalFree(sa.lpSecurityDescriptor);
+  const auto size = static_cast<DWORD>(blob_size);
+  HANDLE section = CreatePublishedSection(name, size);
   if (!section) {
-    return;
-  }
-  // A pre-existing name means another process squatted it; leave children on
-  // the decompress fallback rather than trust its contents.
-  if (create_error == ERROR_ALREADY_EXISTS) {
-    CloseHandle(section);
-    return;
+    return {};
   }
 
   auto* view =
       static_cast<uint8_t*>(MapViewOfFile(section, FILE_MAP_WRITE, 0, 0, size));
   if (!view) {
     CloseHandle(section);
-    return;
+    return {};
   }
   auto* header = reinterpret_cast<PakBlobHeader*>(view);
-  header->resource_id = resource_id;
-  header->length = slot->length;
-  memcpy(view + sizeof(PakBlobHeader), buffer + slot->offset, slot->length);
+  header->entry_count = static_cast<uint32_t>(records.size());
+  header->size = size;
+  uint8_t* next = view + sizeof(PakBlobHeader);
+  for (const auto& record : records) {
+    auto* entry = reinterpret_cast<PakBlobEntry*>(next);
+    entry->resource_id = record.resource_id;
+    entry->length = static_cast<uint32_t>(record.patched.size());
+    entry->range_count = static_cast<uint32_t>(record.ranges.size());
+    entry->data_size = record.data_size;
+    memcpy(next + sizeof(PakBlobEntry), record.ranges.data(),
+           record.ranges.size() * sizeof(PakBlobRange));
+    uint8_t* data = next + sizeof(PakBlobEntry) +
+                    record.ranges.size() * sizeof(PakBlobRange);
+    for (const auto& range : record.ranges) {
+      memcpy(data, record.patched.data() + range.offset, range.length);
+      data += range.length;
+    }
+    next += PakBlobRecordSize(record.ranges.size(), record.data_size);
+    DebugLog(L"PakPatch: publishing resource {} ({} of {} bytes in {} ranges)",
+             record.resource_id, record.data_size, record.patched.size(),
+             record.ranges.size());
+  }
   UnmapViewOfFile(view);
 
   published_blob_section = section;
-  SetEnvironmentVariableW(kPakBlobEnv, name.c_str());
-  DebugLog(L"PakPatch: published resource {} ({} bytes) as {}", resource_id,
-           slot->length, name);
+  DebugLog(L"PakPatch: published {} resources as {}", records.size(), name);
+  return name;
 }
 
-// Renderer fast path: overwrite this process's copy-on-write pak view with
-// the browser's already-patched bytes. The slot is re-derived from this
+// Renderer fast path: write the browser's changed byte ranges into this
+// process's copy-on-write pak view. Each slot is re-derived from this
 // process's own pak index and the lengths must match, so a section built from
-// a different pak is rejected and the copy cannot write outside the slot.
-bool ApplyPatchedEntry(uint8_t* buffer) {
+// a different pak is rejected; every record and range is checked against its
+// slot and the section before the first byte is written, so a malformed blob
+// is rejected whole rather than half applied.
+bool ApplyPatchedEntries(const PakIndex& index) {
+  const ConfigSnapshot* snapshot = Config::Inherited();
+  if (!snapshot) {
+    return false;
+  }
+  // The snapshot's name is not null-terminated.
   wchar_t name[64];
-  DWORD len = GetEnvironmentVariableW(kPakBlobEnv, name, ARRAYSIZE(name));
-  if (len == 0 || len >= ARRAYSIZE(name)) {
+  const std::u16string_view blob_name = snapshot->pak_blob_name();
+  if (blob_name.empty() || blob_name.size() >= ARRAYSIZE(name)) {
     return false;
   }
+  std::ranges::copy(blob_name, name);
+  name[blob_name.size()] = L'\0';
 
   HANDLE section = OpenFileMappingW(FILE_MAP_READ, FALSE, name);
   if (!section) {
     return false;
   }
 
+  struct Record {
+    std::span<uint8_t> slot;
+    std::span<const PakBlobRange> ranges;
+    const uint8_t* data;
+  };
   bool applied = false;
   if (const auto* view = static_cast<const uint8_t*>(
           MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0))) {
     const auto* header = reinterpret_cast<const PakBlobHeader*>(view);
-    std::optional<PakResourceSlot> slot;
-    if (header->resource_id <= 0xFFFF) {
-      slot =
-          FindResourceSlot(buffer, static_cast<uint16_t>(header->resource_id));
+    MEMORY_BASIC_INFORMATION info{};
+    bool valid = VirtualQuery(view, &info, sizeof(info)) &&
+                 header->size <= info.RegionSize &&
+                 header->entry_count <= kMaxPakRules;
+    std::vector<Record> records;
+    uint64_t pos = sizeof(PakBlobHeader);
+    for (uint32_t i = 0; valid && i < header->entry_count; ++i) {
+      if (pos + sizeof(PakBlobEntry) > header->size) {
+        valid = false;
+        break;
+      }
+      const auto* entry = reinterpret_cast<const PakBlobEntry*>(view + pos);
+      const uint64_t record_size =
+          PakBlobRecordSize(entry->range_count, entry->data_size);
+      std::optional<size_t> slot_index;
+      if (entry->resource_id <= 0xFFFF) {
+        slot_index = index.Find(static_cast<uint16_t>(entry->resource_id));
+      }
+      const auto slot =
+          slot_index ? index.data(*slot_index) : std::span<uint8_t>();
+      valid = pos + record_size <= header->size && slot_index &&
+              slot.size() == entry->length;
+      if (!valid) {
+        break;
+      }
+      std::span ranges(reinterpret_cast<const PakBlobRange*>(
+                           view + pos + sizeof(PakBlobEntry)),
+                       entry->range_count);
+      uint64_t data_size = 0;
+      for (const auto& range : ranges) {
+        valid = valid && static_cast<uint64_t>(range.offset) + range.length <=
+                             slot.size();
+        data_size += range.length;
+      }
+      valid = valid && data_size == entry->data_size;
+      records.push_back({slot, ranges,
+                         reinterpret_cast<const uint8_t*>(ranges.data() +
+                                                          ranges.size())});
+      pos += record_size;
     }
-    if (slot && slot->length == header->length) {
-      memcpy(buffer + slot->offset, view + sizeof(PakBlobHeader), slot->length);
+    if (valid && !records.empty()) {
+      size_t pages = 0;
+      for (const auto& record : records) {
+        const uint8_t* data = record.data;
+        size_t last_page = SIZE_MAX;
+        for (const auto& range : record.ranges) {
+          if (range.length == 0) {
+            continue;
+          }
+          uint8_t* dest = record.slot.data() + range.offset;
+          memcpy(dest, data, range.length);
+          data += range.length;
+          const size_t first = reinterpret_cast<uintptr_t>(dest) / kPageSize;
+          const size_t last =
+              (reinterpret_cast<uintptr_t>(dest) + range.length - 1) /
+              kPageSize;
+          pages += last - first + 1 - (first == last_page ? 1 : 0);
+          last_page = last;
+        }
+      }
       applied = true;
-      DebugLog(L"PakPatch: applied published resource {}", header->resource_id);
+      DebugLog(L"PakPatch: applied {} published resources ({} pages touched)",
+               records.size(), pages);
     }
     UnmapViewOfFile(view);
   }
@@ -170,68 +492,137 @@ bool ApplyPatchedEntry(uint8_t* buffer) {
   return applied;
 }
 
-// The #172 settings-page injection, run on each candidate decompressed pak
-// entry until it finds the one holding the settings-about-page HTML.
-bool PatchSettingsHtml(uint8_t* begin, uint32_t size, size_t& new_len) {
-  BYTE search_start[] = R"(</settings-about-page>)";
-  auto match = SearchMemory(
-      std::span<uint8_t>(begin, size),
-      std::span<const uint8_t>(search_start, sizeof(search_start) - 1));
-  if (match.empty()) {
-    return false;
-  }
+// Threads for the browser's content scan. It runs on Chrome's startup thread
+// right after an update, so it may use the other cores; a renderer falling
+// back to the scan stays single-threaded since many start at once.
+unsigned GetScanWorkerCount() {
+  constexpr unsigned kMaxScanWorkers = 8;
+  return std::clamp(std::thread::hardware_concurrency(), 1u, kMaxScanWorkers);
+}
 
-  // Compress the HTML for writing patch information.
-  std::string html(reinterpret_cast<char*>(begin), size);
-  compression_html(html);
+// Patches every rule the cheapest way available and returns the ids of the
+// entries written back. Entries already known -- the ids inherited from the
+// browser, then the rules' own hints -- are tried first, one inflate each;
+// whatever rules are still unmatched share one multi-needle streaming scan,
+// and each distinct entry it finds is then inflated once more, in full, to be
+// patched. Every attempt applies all still-pending rules, so rules that
+// target the same entry cost a single patch.
+std::vector<uint16_t> PatchPakEntries(const PakIndex& index,
+                                      const PakRuleSet& rule_set,
+                                      unsigned worker_count) {
+  const auto rules = rule_set.rules();
+  uint32_t pending =
+      rules.size() >= 32 ? UINT32_MAX : (1u << rules.size()) - 1;
+  std::vector<uint16_t> tried;
+  std::vector<uint16_t> patched;
+  auto patch = [&](uint16_t resource_id) {
+    if (pending == 0 || std::ranges::contains(tried, resource_id)) {
+      return;
+    }
+    tried.push_back(resource_id);
+    uint32_t matched = 0;
+    auto apply = [&](uint8_t* begin, uint32_t size, size_t& new_len) {
+      matched = rule_set.Apply(pending, begin, size, new_len);
+      return matched != 0;
+    };
+    const uint16_t written = TraversalGZIPFile(index, apply, resource_id);
+    if (matched == 0) {
+      return;
+    }
+    // A rule that matched but could not be written back has no other entry
+    // to go to; it is dropped rather than searched for again.
+    pending &= ~matched;
+    if (written != 0) {
+      patched.push_back(resource_id);
+    } else {
+      DebugLog(L"PakPatch: resource {} no longer fits its slot", resource_id);
+    }
+  };
 
-  // RemoveUpdateError
-  // if (IsNeedPortable())
-  {
-    ReplaceStringInPlace(html, R"(?hidden="${!this.showUpdateStatus_}")",
-                         R"(hidden="true")");
-    ReplaceStringInPlace(html, R"(?hidden="${!this.shouldShowIcons_()}")",
-                         R"(hidden="true")");
+  for (const uint16_t resource_id : GetPakTargetIds()) {
+    patch(resource_id);
+  }
+  for (const auto& rule : rules) {
+    if (rule.resource_id != 0) {
+      patch(rule.resource_id);
+    }
   }
 
-  const char product_title[] =
-      R"({aboutBrowserVersion}</div><div class="secondary">Powered by <a target="_blank" href="https://github.com/Bush2021/chrome_plus">Chrome++ Next</a> )" RELEASE_VER_STR BUILD_ARCH
-      R"(</div>)";
-  ReplaceStringInPlace(html, R"({aboutBrowserVersion}</div>)", product_title);
-
-  if (html.length() > size) {
-    return false;
+  // No inherited ids, or they missed because the pak was replaced (browser
+  // updated between sessions): locate the remaining rules' entries with the
+  // streaming scan, which keeps only one inflate window live per worker.
+  if (pending != 0) {
+    std::vector<std::span<const uint8_t>> needles;
+    std::vector<size_t> needle_rules;
+    for (size_t i = 0; i < rules.size(); ++i) {
+      if (pending & (1u << i)) {
+        needles.push_back(
+            {reinterpret_cast<const uint8_t*>(rules[i].needle.data()),
+             rules[i].needle.size()});
+        needle_rules.push_back(i);
+      }
+    }
+    const auto found = ScanGZIPFile(index, needles, worker_count);
+    bool missed = false;
+    for (size_t i = 0; i < found.size(); ++i) {
+      if (found[i] != 0) {
+        patch(found[i]);
+      } else {
+        missed = true;
+        DebugLog(L"PakPatch: rule {} matched no resource",
+                 rules[needle_rules[i]].name);
+      }
+    }
+    const size_t unsearched = missed ? CountUnsearchedEntries(index) : 0;
+    if (unsearched != 0) {
+      DebugLog(L"PakPatch: needle missed; {} Brotli entries were not searched "
+               L"(built without CHROME_PLUS_BROTLI)",
+               unsearched);
+    }
   }
-  memcpy(begin, html.c_str(), html.length());
-  new_len = html.length();
-  return true;
+  return patched;
 }
 
-// One flow per process kind: the browser locates and patches the entry
-// itself, then publishes the id and the patched bytes for its children; a
-// renderer takes the cheapest tier available -- published bytes (no
-// decompression), targeted decompress (one entry), full content scan. Runs
-// inside `MyMapViewOfFile` after both hooks have detached themselves, so the
-// section create/open/map calls in the publish and apply helpers reach the
-// real APIs, not our hooks.
-void PatchResourcesPak(uint8_t* buffer) {
+// One flow per process kind: the browser restores the entries from the
+// on-disk cache or else locates and patches them itself, then publishes the
+// ids and the patched bytes for its children; a renderer takes the cheapest
+// tier available -- published bytes (no decompression), targeted decompress
+// (one entry per inherited id), full content scan. Runs inside
+// `MyMapViewOfFile` after both hooks have detached themselves, so the section
+// create/open/map calls in the publish and apply helpers reach the real APIs,
+// not our hooks.
+void PatchResourcesPak(std::span<uint8_t> pak, const uint8_t* original) {
+  // Parsed once; every helper below looks entries up through it.
+  const auto index = PakIndex::Parse(pak);
+  if (!index) {
+    return;
+  }
+
   const bool is_browser = IsBrowserProcess();
-  if (!is_browser && ApplyPatchedEntry(buffer)) {
+  if (!is_browser && ApplyPatchedEntries(*index)) {
     return;
   }
 
-  const uint16_t target_id = GetPakTargetId();
-  uint16_t matched_id = TraversalGZIPFile(buffer, PatchSettingsHtml, target_id);
-  if (matched_id == 0 && target_id != 0) {
-    // The inherited id missed, so the pak was replaced (browser updated
-    // between sessions); redo the full content scan.
-    matched_id = TraversalGZIPFile(buffer, PatchSettingsHtml, 0);
+  std::vector<uint16_t> patched_ids;
+  if (is_browser) {
+    patched_ids = LoadCachedPatches(*index);
+  }
+  const bool cache_hit = !patched_ids.empty();
+  if (!cache_hit) {
+    patched_ids = PatchPakEntries(*index, GetPakRules(),
+                                  is_browser ? GetScanWorkerCount() : 1);
   }
 
-  if (is_browser && matched_id != 0) {
-    SetEnvironmentVariableW(kPakTargetIdEnv,
-                            std::to_wstring(matched_id).c_str());
-    PublishPatchedEntry(buffer, matched_id);
+  if (is_browser) {
+    std::wstring blob_name;
+    if (!patched_ids.empty()) {
+      blob_name = PublishPatchedEntries(*index, original, patched_ids);
+      if (!cache_hit) {
+        StoreCachedPatches(*index, patched_ids);
+      }
+    }
+    // Published even with nothing patched, so renderers skip the INI.
+    config.PublishSnapshot(patched_ids, blob_name);
   }
 }
 
@@ -248,17 +639,38 @@ HANDLE WINAPI MyMapViewOfFile(_In_ HANDLE hFileMappingObject,
 
     // No more hook needed.
     resources_pak_map = nullptr;
-    DetourTransactionBegin();
-    DetourUpdateThread(GetCurrentThread());
-    DetourDetach(reinterpret_cast<LPVOID*>(&RawMapViewOfFile),
-                 reinterpret_cast<void*>(MyMapViewOfFile));
-    auto status = DetourTransactionCommit();
-    if (status != NO_ERROR) {
-      DebugLog(L"Unhook RawMapViewOfFile failed {}", status);
-    }
+    HookRegistry::Instance().Detach(
+        reinterpret_cast<void**>(&RawMapViewOfFile));
 
     if (buffer) {
-      PatchResourcesPak(static_cast<uint8_t*>(buffer));
+      // A second, read-only view of the copy-on-write section still shows the
+      // file's bytes; the browser diffs its patch against it so it publishes
+      // only what changed. Renderers have nothing to diff.
+      const auto* original =
+          IsBrowserProcess()
+              ? static_cast<const uint8_t*>(RawMapViewOfFile(
+                    hFileMappingObject, FILE_MAP_READ, dwFileOffsetHigh,
+                    dwFileOffsetLow, dwNumberOfBytesToMap))
+              : nullptr;
+      // The view's extent bounds every read of the pak index: the requested
+      // size, or the rest of the file when the whole file is mapped. Without
+      // a file size from `MyCreateFileMapping` the view's own region stands
+      // in; it is rounded up to whole pages, whose tail past the end of the
+      // file reads as zeros and lies outside any index entry.
+      const uint64_t view_offset =
+          (static_cast<uint64_t>(dwFileOffsetHigh) << 32) | dwFileOffsetLow;
+      size_t view_size = dwNumberOfBytesToMap;
+      if (view_size == 0 && resources_pak_stamp.size > view_offset) {
+        view_size =
+            static_cast<size_t>(resources_pak_stamp.size - view_offset);
+      } else if (MEMORY_BASIC_INFORMATION info{};
+                 view_size == 0 && VirtualQuery(buffer, &info, sizeof(info))) {
+        view_size = info.RegionSize;
+      }
+      PatchResourcesPak({static_cast<uint8_t*>(buffer), view_size}, original);
+      if (original) {
+        UnmapViewOfFile(original);
+      }
     }
 
     return buffer;
@@ -303,29 +715,29 @@ HANDLE WINAPI MyCreateFileMapping(_In_ HANDLE hFile,
                                   _In_ DWORD dwMaximumSizeLow,
                                   _In_opt_ LPCTSTR lpName) {
   if (IsResourcesPak(hFile)) {
+    BY_HANDLE_FILE_INFORMATION info;
+    if (GetFileInformationByHandle(hFile, &info)) {
+      resources_pak_stamp.size =
+          (static_cast<uint64_t>(info.nFileSizeHigh) << 32) |
+          info.nFileSizeLow;
+      resources_pak_stamp.last_write_time =
+          (static_cast<uint64_t>(info.ftLastWriteTime.dwHighDateTime) << 32) |
+          info.ftLastWriteTime.dwLowDateTime;
+    }
+
     // Force copy-on-write so the mapped view can be patched in memory.
     resources_pak_map =
         RawCreateFileMapping(hFile, lpAttributes, PAGE_WRITECOPY,
                              dwMaximumSizeHigh, dwMaximumSizeLow, lpName);
 
     // No more hook needed.
-    DetourTransactionBegin();
-    DetourUpdateThread(GetCurrentThread());
-    DetourDetach(reinterpret_cast<LPVOID*>(&RawCreateFileMapping),
-                 reinterpret_cast<void*>(MyCreateFileMapping));
-    auto status = DetourTransactionCommit();
-    if (status != NO_ERROR) {
-      DebugLog(L"Unhook RawCreateFileMapping failed {}", status);
-    }
-
-    DetourTransactionBegin();
-    DetourUpdateThread(GetCurrentThread());
-    DetourAttach(reinterpret_cast<LPVOID*>(&RawMapViewOfFile),
-                 reinterpret_cast<void*>(MyMapViewOfFile));
-    status = DetourTransactionCommit();
-    if (status != NO_ERROR) {
-      DebugLog(L"Hook RawMapViewOfFile failed {}", status);
-    }
+    auto& registry = HookRegistry::Instance();
+    registry.Detach(reinterpret_cast<void**>(&RawCreateFileMapping));
+    registry.Register(L"PakPatch",
+                      {{L"MapViewOfFile",
+                        reinterpret_cast<void**>(&RawMapViewOfFile),
+                        reinterpret_cast<void*>(MyMapViewOfFile)}});
+    registry.Commit();
 
     return resources_pak_map;
   }
@@ -336,12 +748,8 @@ HANDLE WINAPI MyCreateFileMapping(_In_ HANDLE hFile,
 }  // namespace
 
 void PakPatch() {
-  DetourTransactionBegin();
-  DetourUpdateThread(GetCurrentThread());
-  DetourAttach(reinterpret_cast<LPVOID*>(&RawCreateFileMapping),
-               reinterpret_cast<void*>(MyCreateFileMapping));
-  auto status = DetourTransactionCommit();
-  if (status != NO_ERROR) {
-    DebugLog(L"Hook RawCreateFileMapping failed {}", status);
-  }
+  HookRegistry::Instance().Register(
+      L"PakPatch", {{L"CreateFileMappingW",
+                     reinterpret_cast<void**>(&RawCreateFileMapping),
+                     reinterpret_cast<void*>(MyCreateFileMapping)}});
 }
@@ -0,0 +1,210 @@
+#include "pakrules.h"
+
+#include <cstdint>
+#include <cwchar>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "hash.h"
+#include "version.h"
+
+namespace {
+#if defined(_M_ARM64)
+#define BUILD_ARCH " (ARM64)"
+#elif defined(_M_X64)
+#define BUILD_ARCH " (64-bit)"
+#else
+#define BUILD_ARCH " (32-bit)"
+#endif
+
+constexpr char kProductTitle[] =
+    R"({aboutBrowserVersion}</div><div class="secondary">Powered by <a target="_blank" href="https://github.com/Bush2021/chrome_plus">Chrome++ Next</a> )" RELEASE_VER_STR BUILD_ARCH
+    R"(</div>)";
+
+// The #172 settings-page injection: the entry holding the
+// settings-about-page HTML gets the Chrome++ version line, and its update
+// status and icons are hidden.
+PakRule MakeSettingsRule() {
+  PakRule rule;
+  rule.name = L"settings";
+  rule.needle = "</settings-about-page>";
+  rule.compress_html = true;
+  // RemoveUpdateError
+  // if (IsNeedPortable())
+  {
+    rule.replacements.emplace_back(R"(?hidden="${!this.showUpdateStatus_}")",
+                                   R"(hidden="true")");
+    rule.replacements.emplace_back(R"(?hidden="${!this.shouldShowIcons_()}")",
+                                   R"(hidden="true")");
+  }
+  rule.replacements.emplace_back(R"({aboutBrowserVersion}</div>)",
+                                 kProductTitle);
+  return rule;
+}
+
+// UTF-16 (or, where `wchar_t` is 32 bits, UTF-32) to UTF-8, as the pak
+// resources are stored. Unpaired surrogates become U+FFFD, as
+// `WideCharToMultiByte` makes them.
+std::string ToUtf8(std::wstring_view text) {
+  std::string utf8;
+  utf8.reserve(text.size());
+  for (size_t i = 0; i < text.size(); ++i) {
+    auto c = static_cast<uint32_t>(text[i]);
+    if (c >= 0xD800 && c <= 0xDBFF && i + 1 < text.size() &&
+        static_cast<uint32_t>(text[i + 1]) >= 0xDC00 &&
+        static_cast<uint32_t>(text[i + 1]) <= 0xDFFF) {
+      c = 0x10000 + ((c - 0xD800) << 10) +
+          (static_cast<uint32_t>(text[++i]) - 0xDC00);
+    } else if ((c >= 0xD800 && c <= 0xDFFF) || c > 0x10FFFF) {
+      c = 0xFFFD;
+    }
+    if (c < 0x80) {
+      utf8 += static_cast<char>(c);
+    } else if (c < 0x800) {
+      utf8 += static_cast<char>(0xC0 | c >> 6);
+      utf8 += static_cast<char>(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+      utf8 += static_cast<char>(0xE0 | c >> 12);
+      utf8 += static_cast<char>(0x80 | (c >> 6 & 0x3F));
+      utf8 += static_cast<char>(0x80 | (c & 0x3F));
+    } else {
+      utf8 += static_cast<char>(0xF0 | c >> 18);
+      utf8 += static_cast<char>(0x80 | (c >> 12 & 0x3F));
+      utf8 += static_cast<char>(0x80 | (c >> 6 & 0x3F));
+      utf8 += static_cast<char>(0x80 | (c & 0x3F));
+    }
+  }
+  return utf8;
+}
+
+// Splits a rule value on unescaped `|`; `\|` and `\\` stand for a literal
+// bar and backslash.
+std::vector<std::wstring> SplitRuleValue(std::wstring_view value) {
+  std::vector<std::wstring> fields(1);
+  for (size_t i = 0; i < value.size(); ++i) {
+    if (value[i] == L'\\' && i + 1 < value.size() &&
+        (value[i + 1] == L'|' || value[i + 1] == L'\\')) {
+      fields.back() += value[++i];
+    } else if (value[i] == L'|') {
+      fields.emplace_back();
+    } else {
+      fields.back() += value[i];
+    }
+  }
+  return fields;
+}
+
+}  // namespace
+
+std::optional<PakRule> ParsePakRule(std::wstring_view key,
+                                    std::wstring_view value) {
+  PakRule rule;
+  const auto at_pos = key.find(L'@');
+  rule.name = key.substr(0, at_pos);
+  if (at_pos != std::wstring_view::npos) {
+    const std::wstring id(key.substr(at_pos + 1));
+    wchar_t* end = nullptr;
+    const unsigned long resource_id = wcstoul(id.c_str(), &end, 10);
+    if (end == id.c_str() || *end != L'\0' || resource_id > 0xFFFF) {
+      return std::nullopt;
+    }
+    rule.resource_id = static_cast<uint16_t>(resource_id);
+  }
+
+  const auto fields = SplitRuleValue(value);
+  if (fields.size() < 3 || fields.size() % 2 == 0 || fields[0].empty()) {
+    return std::nullopt;
+  }
+  rule.needle = ToUtf8(fields[0]);
+  for (size_t i = 1; i < fields.size(); i += 2) {
+    if (fields[i].empty()) {
+      return std::nullopt;
+    }
+    rule.replacements.emplace_back(ToUtf8(fields[i]), ToUtf8(fields[i + 1]));
+  }
+  return rule;
+}
+
+PakRuleList ParsePakRules(
+    std::span<const std::pair<std::wstring, std::wstring>> lines) {
+  PakRuleList list;
+  list.rules.push_back(MakeSettingsRule());
+  for (const auto& [key, value] : lines) {
+    if (list.rules.size() == kMaxPakRules) {
+      ++list.ignored;
+    } else if (auto rule = ParsePakRule(key, value)) {
+      list.rules.push_back(std::move(*rule));
+    } else {
+      list.malformed.push_back(key);
+    }
+  }
+  return list;
+}
+
+uint64_t HashPakRules(std::span<const PakRule> rules) {
+  // Fields are NUL-separated so that moving text between them changes the
+  // hash.
+  std::string text;
+  for (const auto& rule : rules) {
+    text += rule.needle;
+    text += '\0';
+    text += std::to_string(rule.resource_id);
+    text += rule.compress_html ? '1' : '0';
+    for (const auto& [find, replace] : rule.replacements) {
+      text += find;
+      text += '\0';
+      text += replace;
+      text += '\0';
+    }
+    text += '\n';
+  }
+  return Fnv1aHash(std::as_bytes(std::span(text)));
+}
+
+PakRuleSet::PakRuleSet(std::vector<PakRule> rules)
+    : rules_(std::move(rules)), rewriter_(MakeRewriter(rules_)) {}
+
+// static
+HtmlRewriter PakRuleSet::MakeRewriter(std::span<const PakRule> rules) {
+  std::vector<HtmlRewriter::Replacement> replacements;
+  std::vector<uint8_t> groups;
+  for (size_t i = 0; i < rules.size(); ++i) {
+    for (const auto& [find, replace] : rules[i].replacements) {
+      replacements.emplace_back(find, replace);
+      groups.push_back(static_cast<uint8_t>(i));
+    }
+  }
+  return HtmlRewriter(replacements, groups);
+}
+
+uint32_t PakRuleSet::Apply(uint32_t mask,
+                           uint8_t* begin,
+                           uint32_t size,
+                           size_t& new_len) const {
+  // Needles are matched against the entry as stored, before any rule has
+  // rewritten it.
+  const std::string_view document(reinterpret_cast<const char*>(begin), size);
+  uint32_t matched = 0;
+  bool compress = false;
+  for (size_t i = 0; i < rules_.size(); ++i) {
+    if ((mask & (1u << i)) && document.contains(rules_[i].needle)) {
+      matched |= 1u << i;
+      compress = compress || rules_[i].compress_html;
+    }
+  }
+  if (matched == 0) {
+    return 0;
+  }
+
+  const auto length =
+      rewriter_.Rewrite(std::span(begin, size), compress, matched);
+  if (!length) {
+    return 0;
+  }
+  new_len = *length;
+  return matched;
+}
@@ -0,0 +1,88 @@
+#ifndef CHROME_PLUS_SRC_PAKRULES_H_
+#define CHROME_PLUS_SRC_PAKRULES_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "htmlrewriter.h"
+
+// One content patch for a decompressed pak resource: the entry holding
+// `needle` is the target, and every occurrence of each find string in it is
+// replaced (the pairs of all rules matching an entry in one `HtmlRewriter`
+// pass). A non-zero `resource_id` is only a hint tried before the content
+// scan; the needle still decides.
+struct PakRule {
+  std::wstring name;
+  std::string needle;
+  std::vector<std::pair<std::string, std::string>> replacements;
+  uint16_t resource_id = 0;
+  // Trim every line of the document before replacing; the built-in settings
+  // rule matches the minified text.
+  bool compress_html = false;
+};
+
+// Rules are tracked in 32-bit masks while one pass patches them all.
+constexpr size_t kMaxPakRules = 32;
+static_assert(kMaxPakRules <= HtmlRewriter::kMaxGroups);
+
+// A fixed list of rules with the `HtmlRewriter` for all their replacements,
+// built once; each rule is one group of it, so patching an entry with any
+// subset of the rules reuses the same automaton.
+class PakRuleSet {
+ public:
+  explicit PakRuleSet(std::vector<PakRule> rules);
+
+  // The rewriter references the rules' strings.
+  PakRuleSet(const PakRuleSet&) = delete;
+  PakRuleSet& operator=(const PakRuleSet&) = delete;
+
+  std::span<const PakRule> rules() const { return rules_; }
+
+  // Applies every rule in `mask` whose needle occurs in the document
+  // [`begin`, `begin + size`) and returns the mask of those rules, with the
+  // patched length in `new_len`. Returns 0 when no rule matched, leaving the
+  // document untouched, or when the patched document would outgrow `size`,
+  // leaving it partly rewritten.
+  uint32_t Apply(uint32_t mask,
+                 uint8_t* begin,
+                 uint32_t size,
+                 size_t& new_len) const;
+
+ private:
+  static HtmlRewriter MakeRewriter(std::span<const PakRule> rules);
+
+  const std::vector<PakRule> rules_;
+  const HtmlRewriter rewriter_;
+};
+
+// Parses one `[pakpatch]` line of chrome++.ini,
+// `name[@resource_id]=needle|find|replace[|find|replace...]`, where `\|` and
+// `\\` stand for a literal bar and backslash. Returns std::nullopt when the
+// id is not a number up to 65535, the needle or a find string is empty, or a
+// find string has no replacement.
+std::optional<PakRule> ParsePakRule(std::wstring_view key,
+                                    std::wstring_view value);
+
+struct PakRuleList {
+  std::vector<PakRule> rules;
+  // Keys of the lines `ParsePakRule` rejected.
+  std::vector<std::wstring> malformed;
+  // Lines left unparsed once `kMaxPakRules` was reached.
+  size_t ignored = 0;
+};
+
+// The built-in settings-page rule followed by the rules of the `[pakpatch]`
+// `lines`, at most `kMaxPakRules` in all.
+PakRuleList ParsePakRules(
+    std::span<const std::pair<std::wstring, std::wstring>> lines);
+
+// Fingerprint of every field of `rules`, for keying cached patch results.
+uint64_t HashPakRules(std::span<const PakRule> rules);
+
+#endif  // CHROME_PLUS_SRC_PAKRULES_H_
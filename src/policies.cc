@@ -4,9 +4,8 @@
 
 #include <shlwapi.h>
 
-#include "detours.h"
-
 #include "config.h"
+#include "hookregistry.h"
 #include "utils.h"
 
 namespace {
@@ -42,18 +41,9 @@ LSTATUS APIENTRY MyRegOpenKeyExW(HKEY hKey,
 }  // namespace
 
 void IgnorePolicies() {
-  if (!config.IsIgnorePolicies()) {
-    return;
-  }
-
-  DetourTransactionBegin();
-  DetourUpdateThread(GetCurrentThread());
-  DetourAttach(reinterpret_cast<LPVOID*>(&RawRegOpenKeyExW),
-               reinterpret_cast<void*>(MyRegOpenKeyExW));
-  auto status = DetourTransactionCommit();
-  if (status != NO_ERROR) {
-    DebugLog(L"IgnorePolicies failed: {}", status);
-  } else {
-    DebugLog(L"IgnorePolicies enabled.");
-  }
+  HookRegistry::Instance().Register(
+      L"IgnorePolicies",
+      {{L"RegOpenKeyExW", reinterpret_cast<void**>(&RawRegOpenKeyExW),
+        reinterpret_cast<void*>(MyRegOpenKeyExW)}},
+      [] { return config.IsIgnorePolicies(); });
 }
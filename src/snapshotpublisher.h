@@ -0,0 +1,56 @@
+#ifndef CHROME_PLUS_SRC_SNAPSHOTPUBLISHER_H_
+#define CHROME_PLUS_SRC_SNAPSHOTPUBLISHER_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+// Hands immutable snapshots from one writer to lock-free readers: a reader
+// takes the current one with a single acquire load, a writer publishes its
+// replacement. Retired snapshots are freed only once `kRetained` newer ones
+// have been published, so a reference a reader took stays valid across that
+// many publications. Snapshots here follow edits to chrome++.ini, which the
+// watcher reloads at most every 200 ms, while a reader holds one for a single
+// input event; the bound keeps an editor saving all day from growing memory
+// without shortening any reader's view. Free of Windows calls so it can be
+// tested on any platform.
+template <typename T, size_t kRetained = 8>
+class SnapshotPublisher {
+ public:
+  static_assert(kRetained > 0);
+
+  // The latest snapshot, or nullptr before the first `Publish`.
+  const T* Current() const { return current_.load(std::memory_order_acquire); }
+
+  // Makes `snapshot` current and returns it; the oldest retained snapshot
+  // is freed once `kRetained` are held.
+  const T& Publish(std::unique_ptr<const T> snapshot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const T* published = snapshot.get();
+    current_.store(published, std::memory_order_release);
+    retained_[next_] = std::move(snapshot);
+    next_ = (next_ + 1) % kRetained;
+    return *published;
+  }
+
+  // Snapshots still alive, the current one included.
+  size_t retained() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const auto& snapshot : retained_) {
+      count += snapshot ? 1 : 0;
+    }
+    return count;
+  }
+
+ private:
+  std::atomic<const T*> current_{nullptr};
+  mutable std::mutex mutex_;
+  std::array<std::unique_ptr<const T>, kRetained> retained_;
+  size_t next_ = 0;
+};
+
+#endif  // CHROME_PLUS_SRC_SNAPSHOTPUBLISHER_H_
@@ -44,7 +44,7 @@ enum class KeepTabTrigger {
 // the window when they click too fast. Also uses pre-computed `tab_count` to
 // avoid redundant `FindPageTabPane` traversal.
 bool IsNeedKeep(int tab_count, KeepTabTrigger trigger) {
-  // `tab_count` will be 0 if `config.IsKeepLastTab()` is false.
+  // `tab_count` will be 0 if `live.keep_last_tab` is false.
   if (tab_count == 0) {
     return false;
   }
@@ -141,8 +141,8 @@ void CALLBACK HoverTabTimerProc(HWND hwnd, UINT, UINT_PTR event_id, DWORD) {
   SelectTab(*hit);
 }
 
-void HandleHoverTab(const MOUSEHOOKSTRUCT* pmouse) {
-  if (!config.IsHoverTab()) {
+void HandleHoverTab(const LiveSettings& live, const MOUSEHOOKSTRUCT* pmouse) {
+  if (!live.hover_tab) {
     return;
   }
 
@@ -194,7 +194,7 @@ void HandleHoverTab(const MOUSEHOOKSTRUCT* pmouse) {
   // Re-issuing SetTimer with the same hwnd/id restarts the countdown, which
   // is exactly the stationary-dwell semantics: any movement resets the
   // clock. A zero delay is clamped by the system to USER_TIMER_MINIMUM.
-  if (SetTimer(root, kHoverTabTimerId, config.GetHoverTabDelay(),
+  if (SetTimer(root, kHoverTabTimerId, live.hover_tab_delay,
                HoverTabTimerProc)) {
     hover_tab_root = root;
   } else {
@@ -203,8 +203,10 @@ void HandleHoverTab(const MOUSEHOOKSTRUCT* pmouse) {
 }
 
 // Use the mouse wheel to switch tabs
-bool HandleMouseWheel(LPARAM lParam, const MOUSEHOOKSTRUCT* pmouse) {
-  if (!config.IsWheelTab() && !config.IsWheelTabWhenPressRightButton()) {
+bool HandleMouseWheel(const LiveSettings& live,
+                      LPARAM lParam,
+                      const MOUSEHOOKSTRUCT* pmouse) {
+  if (!live.wheel_tab && !live.wheel_tab_when_press_rbutton) {
     return false;
   }
 
@@ -223,12 +225,12 @@ bool HandleMouseWheel(LPARAM lParam, const MOUSEHOOKSTRUCT* pmouse) {
   };
 
   // If it is used to switch tabs when the right button is held.
-  if (config.IsWheelTabWhenPressRightButton() && IsKeyPressed(VK_RBUTTON)) {
+  if (live.wheel_tab_when_press_rbutton && IsKeyPressed(VK_RBUTTON)) {
     return switch_tabs();
   }
 
   // If the mouse wheel is used to switch tabs when the mouse is on the tab bar.
-  if (config.IsWheelTab() && IsOnTabBar(pmouse->pt)) {
+  if (live.wheel_tab && IsOnTabBar(pmouse->pt)) {
     return switch_tabs();
   }
 
@@ -236,14 +238,15 @@ bool HandleMouseWheel(LPARAM lParam, const MOUSEHOOKSTRUCT* pmouse) {
 }
 
 // Double-click to close tab.
-bool HandleDoubleClick(const MOUSEHOOKSTRUCT* pmouse) {
-  if (!config.IsDoubleClickClose()) {
+bool HandleDoubleClick(const LiveSettings& live,
+                       const MOUSEHOOKSTRUCT* pmouse) {
+  if (!live.double_click_close) {
     return false;
   }
 
   const POINT pt = pmouse->pt;
   HWND hwnd = WindowFromPoint(pt);
-  const auto hit = FindTabHitResult(pt, config.IsKeepLastTab(), true);
+  const auto hit = FindTabHitResult(pt, live.keep_last_tab, true);
   if (!hit || hit->on_close_button) {
     return false;
   }
@@ -257,14 +260,15 @@ bool HandleDoubleClick(const MOUSEHOOKSTRUCT* pmouse) {
 }
 
 // Right-click to close tab (Hold Shift to show the original menu).
-bool HandleRightClick(const MOUSEHOOKSTRUCT* pmouse) {
-  if (IsKeyPressed(VK_SHIFT) || !config.IsRightClickClose()) {
+bool HandleRightClick(const LiveSettings& live,
+                      const MOUSEHOOKSTRUCT* pmouse) {
+  if (IsKeyPressed(VK_SHIFT) || !live.right_click_close) {
     return false;
   }
 
   const POINT pt = pmouse->pt;
   HWND hwnd = WindowFromPoint(pt);
-  const auto hit = FindTabHitResult(pt, config.IsKeepLastTab(), false);
+  const auto hit = FindTabHitResult(pt, live.keep_last_tab, false);
   if (!hit) {
     return false;
   }
@@ -280,14 +284,15 @@ bool HandleRightClick(const MOUSEHOOKSTRUCT* pmouse) {
 }
 
 // Preserve the last tab when the middle button is clicked on the tab.
-bool HandleMiddleClick(const MOUSEHOOKSTRUCT* pmouse) {
-  if (!config.IsKeepLastTab()) {
+bool HandleMiddleClick(const LiveSettings& live,
+                       const MOUSEHOOKSTRUCT* pmouse) {
+  if (!live.keep_last_tab) {
     return false;
   }
 
   const POINT pt = pmouse->pt;
   HWND hwnd = WindowFromPoint(pt);
-  const auto hit = FindTabHitResult(pt, config.IsKeepLastTab(), false);
+  const auto hit = FindTabHitResult(pt, live.keep_last_tab, false);
   if (!hit) {
     return false;
   }
@@ -300,14 +305,15 @@ bool HandleMiddleClick(const MOUSEHOOKSTRUCT* pmouse) {
   return false;
 }
 
-bool HandleCloseButton(const MOUSEHOOKSTRUCT* pmouse) {
-  if (!config.IsKeepLastTab()) {
+bool HandleCloseButton(const LiveSettings& live,
+                       const MOUSEHOOKSTRUCT* pmouse) {
+  if (!live.keep_last_tab) {
     return false;
   }
 
   const POINT pt = pmouse->pt;
   HWND hwnd = WindowFromPoint(pt);
-  const auto hit = FindTabHitResult(pt, config.IsKeepLastTab(), true);
+  const auto hit = FindTabHitResult(pt, live.keep_last_tab, true);
   if (!hit || !hit->on_close_button) {
     return false;
   }
@@ -340,8 +346,9 @@ bool HandleDrag(const MOUSEHOOKSTRUCT* pmouse) {
 }
 
 // Open bookmarks in a new tab.
-bool HandleBookmark(const MOUSEHOOKSTRUCT* pmouse) {
-  const int mode = config.GetBookmarkNewTabMode();
+bool HandleBookmark(const LiveSettings& live,
+                    const MOUSEHOOKSTRUCT* pmouse) {
+  const int mode = live.bookmark_new_tab;
   if (IsKeyPressed(VK_CONTROL) || IsKeyPressed(VK_SHIFT) || mode == 0) {
     return false;
   }
@@ -351,8 +358,8 @@ bool HandleBookmark(const MOUSEHOOKSTRUCT* pmouse) {
     return false;
   }
 
-  if (!config.IsNewTabDisable() ||
-      !IsOnNewTab(GetForegroundWindow(), config.GetDisableTabNames())) {
+  if (!live.new_tab_disable ||
+      !IsOnNewTab(GetForegroundWindow(), live.disable_tab_names)) {
     // The middle-click below carries no coordinates, so Windows fires it at the
     // live cursor. The cursor can drift off `pt` between the mouse-up and this
     // injection when the hand keeps moving after release, which in a vertical
@@ -370,9 +377,18 @@ bool HandleBookmark(const MOUSEHOOKSTRUCT* pmouse) {
   return false;
 }
 
+// Kept apart from the click handler so that, with hover tab off, mouse moves
+// reach no handler at all.
+bool TabBookmarkMouseMoveHandler(WPARAM wParam, LPARAM lParam) {
+  HandleHoverTab(config.Live(), reinterpret_cast<PMOUSEHOOKSTRUCT>(lParam));
+  return false;
+}
+
 // Mouse handler for tab and bookmark operations
 bool TabBookmarkMouseHandler(WPARAM wParam, LPARAM lParam) {
   PMOUSEHOOKSTRUCT pmouse = reinterpret_cast<PMOUSEHOOKSTRUCT>(lParam);
+  // One snapshot for the whole event, so a reload cannot split it.
+  const LiveSettings& live = config.Live();
 
   static bool wheel_tab_ing_with_rbutton = false;
   // Set when a tab-closing handler succeeds. While active, subsequent messages
@@ -394,9 +410,6 @@ bool TabBookmarkMouseHandler(WPARAM wParam, LPARAM lParam) {
   static bool last_lbutton_down_on_tab = false;
 
   switch (wParam) {
-    case WM_MOUSEMOVE:
-      HandleHoverTab(pmouse);
-      return false;
     case WM_LBUTTONDOWN:
     case WM_NCLBUTTONDOWN:
       CancelHoverTabTimer();
@@ -407,7 +420,7 @@ bool TabBookmarkMouseHandler(WPARAM wParam, LPARAM lParam) {
         lbutton_down_point = pmouse->pt;
         // Gate on the config so clicks pay the UIA hit test only when
         // double-click close can consume the result.
-        if (config.IsDoubleClickClose()) {
+        if (live.double_click_close) {
           const auto hit = FindTabHitResult(pmouse->pt, false, true);
           last_lbutton_down_on_tab = hit && !hit->on_close_button;
         }
@@ -429,9 +442,9 @@ bool TabBookmarkMouseHandler(WPARAM wParam, LPARAM lParam) {
       }
       if (HandleDrag(pmouse)) {
         return false;
-      } else if (HandleBookmark(pmouse)) {
+      } else if (HandleBookmark(live, pmouse)) {
         return true;
-      } else if (HandleCloseButton(pmouse)) {
+      } else if (HandleCloseButton(live, pmouse)) {
         closing_tab_by_dblclk = true;
         return true;
       }
@@ -452,7 +465,7 @@ bool TabBookmarkMouseHandler(WPARAM wParam, LPARAM lParam) {
         // WM_MOUSEWHEEL.
         wheel_tab_ing_with_rbutton = false;
         return true;
-      } else if (HandleRightClick(pmouse)) {
+      } else if (HandleRightClick(live, pmouse)) {
         closing_tab_by_right = true;
         return true;
       }
@@ -461,7 +474,7 @@ bool TabBookmarkMouseHandler(WPARAM wParam, LPARAM lParam) {
       // An explicit wheel switch inside the dwell window must not be
       // overridden by the pending hover activation.
       CancelHoverTabTimer();
-      if (HandleMouseWheel(lParam, pmouse)) {
+      if (HandleMouseWheel(live, lParam, pmouse)) {
         // Suspend hover re-arm until real cursor movement (see
         // `wheel_switch_point`).
         wheel_switch_point = pmouse->pt;
@@ -485,7 +498,7 @@ bool TabBookmarkMouseHandler(WPARAM wParam, LPARAM lParam) {
       if (!last_lbutton_down_on_tab) {
         return false;
       }
-      if (HandleDoubleClick(pmouse)) {
+      if (HandleDoubleClick(live, pmouse)) {
         // Swallow the double-click so Chrome does not process it on the
         // now-destroyed tab (prevents crash on vertical tabs, issue #220).
         // Also keep the flag active to suppress the following WM_LBUTTONUP
@@ -499,7 +512,7 @@ bool TabBookmarkMouseHandler(WPARAM wParam, LPARAM lParam) {
       if (closing_tab_by_middle) {
         return true;
       }
-      if (HandleMiddleClick(pmouse)) {
+      if (HandleMiddleClick(live, pmouse)) {
         closing_tab_by_middle = true;
         return true;
       }
@@ -512,13 +525,15 @@ bool TabBookmarkMouseHandler(WPARAM wParam, LPARAM lParam) {
   return false;
 }
 
-bool HandleKeepTab(WPARAM wParam) {
-  if (!config.IsKeepLastTab()) {
+bool HandleKeepTab(const LiveSettings& live, WPARAM wParam) {
+  if (!live.keep_last_tab) {
     return false;
   }
 
-  if (!(wParam == 'W' && IsKeyPressed(VK_CONTROL) && !IsKeyPressed(VK_SHIFT)) &&
-      !(wParam == VK_F4 && IsKeyPressed(VK_CONTROL))) {
+  const UINT modifiers = GetKeyModifiers();
+  if (!(wParam == 'W' && (modifiers & MOD_CONTROL) &&
+        !(modifiers & MOD_SHIFT)) &&
+      !(wParam == VK_F4 && (modifiers & MOD_CONTROL))) {
     return false;
   }
 
@@ -546,14 +561,14 @@ bool HandleKeepTab(WPARAM wParam) {
   return true;
 }
 
-bool HandleOpenUrlNewTab(WPARAM wParam) {
-  int mode = config.GetOpenUrlNewTabMode();
-  if (mode == 0 || wParam != VK_RETURN || IsKeyPressed(VK_MENU)) {
+bool HandleOpenUrlNewTab(const LiveSettings& live, WPARAM wParam) {
+  int mode = live.open_url_new_tab;
+  if (mode == 0 || wParam != VK_RETURN || (GetKeyModifiers() & MOD_ALT)) {
     return false;
   }
 
-  if (config.IsNewTabDisable() &&
-      IsOnNewTab(GetForegroundWindow(), config.GetDisableTabNames())) {
+  if (live.new_tab_disable &&
+      IsOnNewTab(GetForegroundWindow(), live.disable_tab_names)) {
     return false;
   }
 
@@ -580,11 +595,13 @@ bool TabBookmarkKeyboardHandler(WPARAM wParam, LPARAM lParam) {
   // hover intent.
   CancelHoverTabTimer();
 
-  if (HandleKeepTab(wParam)) {
+  const LiveSettings& live = config.Live();
+
+  if (HandleKeepTab(live, wParam)) {
     return true;
   }
 
-  if (HandleOpenUrlNewTab(wParam)) {
+  if (HandleOpenUrlNewTab(live, wParam)) {
     return true;
   }
 
@@ -594,6 +611,18 @@ bool TabBookmarkKeyboardHandler(WPARAM wParam, LPARAM lParam) {
 }  // namespace
 
 void TabBookmark() {
-  RegisterMouseHandler(TabBookmarkMouseHandler, HandlerPriority::kNormal);
+  // Hot reload can turn hover tab on later, so then moves are always watched.
+  if (config.Live().hover_tab || config.IsHotReload()) {
+    RegisterMouseHandler(TabBookmarkMouseMoveHandler, {MouseEvent::kMove},
+                         HandlerPriority::kNormal);
+  }
+  RegisterMouseHandler(
+      TabBookmarkMouseHandler,
+      {MouseEvent::kLButtonDown, MouseEvent::kLButtonUp,
+       MouseEvent::kLButtonDblClk, MouseEvent::kMButtonDown,
+       MouseEvent::kMButtonUp, MouseEvent::kMButtonDblClk,
+       MouseEvent::kRButtonDown, MouseEvent::kRButtonUp,
+       MouseEvent::kRButtonDblClk, MouseEvent::kWheel},
+      HandlerPriority::kNormal);
   RegisterKeyboardHandler(TabBookmarkKeyboardHandler, HandlerPriority::kNormal);
 }
@@ -0,0 +1,65 @@
+#include "tabgeometry.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+TabGeometry TabGeometry::Build(std::span<const Tab> tabs, bool vertical) {
+  TabGeometry geometry;
+  geometry.tabs_.assign(tabs.begin(), tabs.end());
+  geometry.vertical_ = vertical;
+
+  auto start = [vertical](const TabBounds& bounds) {
+    return vertical ? bounds.top : bounds.left;
+  };
+  auto end = [vertical](const TabBounds& bounds) {
+    return vertical ? bounds.bottom : bounds.right;
+  };
+
+  for (size_t i = 0; i < tabs.size(); ++i) {
+    if (!tabs[i].bounds.empty()) {
+      geometry.order_.push_back(static_cast<uint32_t>(i));
+    }
+  }
+  // Stable, so tabs starting at the same edge keep their tree order.
+  std::ranges::stable_sort(geometry.order_, {}, [&](uint32_t index) {
+    return start(tabs[index].bounds);
+  });
+  geometry.starts_.reserve(geometry.order_.size());
+  for (const uint32_t index : geometry.order_) {
+    const TabBounds& bounds = tabs[index].bounds;
+    geometry.starts_.push_back(start(bounds));
+    const int64_t extent = static_cast<int64_t>(end(bounds)) - start(bounds);
+    geometry.max_extent_ = (std::max)(geometry.max_extent_, extent);
+  }
+  return geometry;
+}
+
+std::optional<size_t> TabGeometry::TabAt(int32_t x, int32_t y) const {
+  const int64_t position = vertical_ ? y : x;
+  // Candidates start at or before `position` and less than `max_extent_`
+  // before it; walk back from the last tab starting at or before it.
+  size_t candidate = static_cast<size_t>(
+      std::ranges::upper_bound(starts_, position) - starts_.begin());
+  std::optional<size_t> hit;
+  while (candidate > 0 && starts_[candidate - 1] + max_extent_ > position) {
+    --candidate;
+    const uint32_t index = order_[candidate];
+    if (tabs_[index].bounds.Contains(x, y) && (!hit || index < *hit)) {
+      hit = index;
+    }
+  }
+  return hit;
+}
+
+std::optional<size_t> TabGeometry::selected() const {
+  const auto it = std::ranges::find_if(
+      tabs_, [](const Tab& tab) { return tab.selected; });
+  if (it == tabs_.end()) {
+    return std::nullopt;
+  }
+  return static_cast<size_t>(it - tabs_.begin());
+}
@@ -0,0 +1,67 @@
+#ifndef CHROME_PLUS_SRC_TABGEOMETRY_H_
+#define CHROME_PLUS_SRC_TABGEOMETRY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+// A screen rectangle with `RECT`'s half-open edges: it contains a point when
+// left <= x < right and top <= y < bottom, as `PtInRect` decides.
+struct TabBounds {
+  int32_t left = 0;
+  int32_t top = 0;
+  int32_t right = 0;
+  int32_t bottom = 0;
+
+  bool empty() const { return right <= left || bottom <= top; }
+  bool Contains(int32_t x, int32_t y) const {
+    return x >= left && x < right && y >= top && y < bottom;
+  }
+};
+
+// The tabs of one strip as read in a single batched UIA pass, indexed for
+// point lookup: tabs are sorted by their start along the strip axis, so a
+// hit test is a binary search plus a check of the few tabs that can overlap
+// it, instead of a rectangle test per tab. Free of Windows calls, so the
+// lookup can be exercised with synthetic strips on any platform.
+class TabGeometry {
+ public:
+  struct Tab {
+    TabBounds bounds;
+    // Empty when the tab shows no close button or it was not read.
+    TabBounds close_button;
+    bool selected = false;
+  };
+
+  // `tabs` in tree order; `vertical` for a strip laid out top to bottom. A
+  // tab with empty bounds (hidden in a collapsed group, say) is counted but
+  // never hit.
+  static TabGeometry Build(std::span<const Tab> tabs, bool vertical);
+
+  // Among the tabs containing (`x`, `y`), the index of the first in tree
+  // order, as a linear scan would find it: neighbouring tabs overlap a little
+  // in the horizontal strip.
+  std::optional<size_t> TabAt(int32_t x, int32_t y) const;
+
+  // The first selected tab, if any.
+  std::optional<size_t> selected() const;
+
+  size_t size() const { return tabs_.size(); }
+  const Tab& tab(size_t index) const { return tabs_[index]; }
+
+ private:
+  // All tabs, in tree order.
+  std::vector<Tab> tabs_;
+  // Indices of the hittable tabs sorted by `starts_`, their leading edge
+  // along the strip axis.
+  std::vector<uint32_t> order_;
+  std::vector<int32_t> starts_;
+  // The longest hittable tab along the axis; no tab starting further back
+  // than this from a point can contain it.
+  int64_t max_extent_ = 0;
+  bool vertical_ = false;
+};
+
+#endif  // CHROME_PLUS_SRC_TABGEOMETRY_H_
@@ -5,13 +5,24 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <format>
 #include <initializer_list>
+#include <iterator>
+#include <mutex>
 #include <optional>
+#include <string>
 #include <string_view>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include "com_initializer.h"
+#include "lrucache.h"
+#include "tabgeometry.h"
+#include "uiatree.h"
 #include "utils.h"
 
 namespace {
@@ -48,20 +59,125 @@ struct CachedClassConditions {
   ComPtr<IUIAutomationCondition> tab_strip_control_button;
 };
 
-enum class TabContainerKind {
-  kHorizontal,
-  kVertical,
-  // Chrome 152 rebuilt the vertical strip on the unified TabCollectionNode
-  // system (chrome/browser/ui/views/tabs/common/tab_strip_view.h): the
-  // container is `UnpinnedTabContainerView` and tabs are `TabView`. The
-  // horizontal strip moves to the same classes once
-  // `tabs::kTabStripUnification` ships enabled.
-  kUnified,
+using TabContainer = BasicTabContainer<ComPtr<IUIAutomationElement>>;
+
+// Receives the UIA events of one window's tab strip and counts them, so
+// `GetValidatedTabUi` can skip its rectangle reads while nothing has changed.
+// `TabStripWatchThread` registers and removes it; the hook thread only
+// compares generations. Until registration succeeds, `registered()` stays
+// false and every check reads the rectangles as before.
+class TabStripWatcher final : public IUIAutomationStructureChangedEventHandler,
+                              public IUIAutomationPropertyChangedEventHandler,
+                              public IUIAutomationEventHandler {
+ public:
+  explicit TabStripWatcher(HWND window) : window_(window) {}
+
+  HWND window() const { return window_; }
+
+  bool registered() const {
+    return registered_.load(std::memory_order_acquire);
+  }
+
+  // Bumped by every event; equal readings mean no event came in between.
+  uint64_t generation() const {
+    return generation_.load(std::memory_order_acquire);
+  }
+
+  // IUnknown. UIA and the watch thread may hold references after the cache
+  // entry that created the watcher is gone.
+  ULONG STDMETHODCALLTYPE AddRef() override {
+    return ref_count_.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+  ULONG STDMETHODCALLTYPE Release() override {
+    const ULONG count = ref_count_.fetch_sub(1, std::memory_order_acq_rel) - 1;
+    if (count == 0) {
+      delete this;
+    }
+    return count;
+  }
+  HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid,
+                                           void** object) override {
+    if (!object) {
+      return E_POINTER;
+    }
+    if (riid == __uuidof(IUnknown) ||
+        riid == __uuidof(IUIAutomationStructureChangedEventHandler)) {
+      *object = static_cast<IUIAutomationStructureChangedEventHandler*>(this);
+    } else if (riid == __uuidof(IUIAutomationPropertyChangedEventHandler)) {
+      *object = static_cast<IUIAutomationPropertyChangedEventHandler*>(this);
+    } else if (riid == __uuidof(IUIAutomationEventHandler)) {
+      *object = static_cast<IUIAutomationEventHandler*>(this);
+    } else {
+      *object = nullptr;
+      return E_NOINTERFACE;
+    }
+    AddRef();
+    return S_OK;
+  }
+
+  HRESULT STDMETHODCALLTYPE
+  HandleStructureChangedEvent(IUIAutomationElement*,
+                              StructureChangeType,
+                              SAFEARRAY*) override {
+    Invalidate();
+    return S_OK;
+  }
+  HRESULT STDMETHODCALLTYPE HandlePropertyChangedEvent(IUIAutomationElement*,
+                                                       PROPERTYID,
+                                                       VARIANT) override {
+    Invalidate();
+    return S_OK;
+  }
+  HRESULT STDMETHODCALLTYPE HandleAutomationEvent(IUIAutomationElement*,
+                                                  EVENTID) override {
+    Invalidate();
+    return S_OK;
+  }
+
+ private:
+  friend class TabStripWatchThread;
+
+  ~TabStripWatcher() = default;
+
+  void Invalidate() { generation_.fetch_add(1, std::memory_order_acq_rel); }
+
+  const HWND window_;
+  std::atomic<ULONG> ref_count_{1};
+  std::atomic<bool> registered_{false};
+  std::atomic<uint64_t> generation_{0};
+  // The tab strip region the handlers are registered on. Only the watch
+  // thread touches it.
+  ComPtr<IUIAutomationElement> region_;
 };
 
-struct TabContainer {
-  ComPtr<IUIAutomationElement> element;
-  TabContainerKind kind = TabContainerKind::kHorizontal;
+// The watcher of one cache entry: asks for its registration when created and
+// for its removal when the entry is evicted, dropped or re-resolved, so every
+// cached window keeps exactly one registration.
+class TabStripWatch {
+ public:
+  TabStripWatch() = default;
+  explicit TabStripWatch(HWND window);
+  ~TabStripWatch() { Reset(); }
+  TabStripWatch(TabStripWatch&&) = default;
+  TabStripWatch& operator=(TabStripWatch&& other) {
+    if (this != &other) {
+      Reset();
+      watcher_ = std::move(other.watcher_);
+    }
+    return *this;
+  }
+
+  explicit operator bool() const { return watcher_ != nullptr; }
+
+  bool registered() const { return watcher_ && watcher_->registered(); }
+  uint64_t generation() const {
+    return watcher_ ? watcher_->generation() : 0;
+  }
+
+ private:
+  void Reset();
+
+  ComPtr<TabStripWatcher> watcher_;
 };
 
 // Tab UI resolved for one top-level window, kept until validation fails or
@@ -79,10 +195,43 @@ struct TabUiCache {
   // control view hides the tab strip region there).
   ComPtr<IUIAutomationElement> region;
   TabContainer container;
+  // Registered once the first rectangle check passes.
+  TabStripWatch watch;
+  // The last rectangle check that passed, reused while `watch` reports no
+  // event since and the window has not moved.
+  bool validated = false;
+  uint64_t validated_generation = 0;
+  RECT validated_window_rect = {};
+  RECT validated_gate_rect = {};
+  // Every tab's geometry from one `tab_geometry_request` scan, reused on the
+  // same terms as the validated rectangles; `geometry_tabs` holds the scanned
+  // elements in the geometry's index order.
+  std::optional<TabGeometry> geometry;
+  ComPtr<IUIAutomationElementArray> geometry_tabs;
+  uint64_t geometry_generation = 0;
+  RECT geometry_window_rect = {};
+};
+
+// Public entry points whose round trips are totalled per session.
+enum class UiaOperation {
+  kFindTabHitResult,
+  kFindTabCount,
+  kIsOnTabBar,
+  kIsOnBookmark,
+  kIsOnNewTab,
+};
+
+constexpr std::array kUiaOperationNames = {
+    L"FindTabHitResult", L"FindTabCount", L"IsOnTabBar",
+    L"IsOnBookmark",     L"IsOnNewTab",
+};
+constexpr size_t kUiaOperationCount = kUiaOperationNames.size();
+
+struct RoundTripTotal {
+  uint64_t calls = 0;
+  uint64_t round_trips = 0;
 };
 
-// TODO: Evaluate `IUIAutomationCacheRequest` and `BuildCache` for tab
-// enumeration if tab scans become a measurable hot path.
 struct UiaSession {
   ComInitializer com_initializer;
   bool init_attempted = false;
@@ -91,9 +240,33 @@ struct UiaSession {
   ComPtr<IUIAutomationTreeWalker> control_view_walker;
   ComPtr<IUIAutomationTreeWalker> raw_view_walker;
   CachedClassConditions class_conditions;
-  TabUiCache tab_ui_cache;
+  // Every tab property a selection scan reads, fetched for all tabs by the
+  // one `FindAllBuildCache` in `FindTabElements`. Each current read is instead
+  // a cross-process call into Chrome's UI thread, the very thread our input
+  // hook is blocking, so a scan of 100 tabs used to cost 100+ round trips.
+  ComPtr<IUIAutomationCacheRequest> tab_cache_request;
+  // What `GetTabGeometry` scans: the raw view, so tabs of collapsed groups
+  // are counted, with each tab's children cached for its close button.
+  ComPtr<IUIAutomationCacheRequest> tab_geometry_request;
+  // By window, so switching between a few browser windows (torn-off tabs,
+  // app windows) keeps each one's resolved tab strip and its failure back-off
+  // instead of re-resolving on every switch.
+  LruCache<HWND, TabUiCache, 8> tab_ui_caches;
+  unsigned tab_ui_cache_hits = 0;
+  unsigned tab_ui_cache_misses = 0;
+  // Calls and cross-process round trips of each public entry point, logged
+  // with the tab UI cache misses so a change to a query can be checked in the
+  // debug log without a line per wheel tick.
+  std::array<RoundTripTotal, kUiaOperationCount> round_trip_totals;
 };
 
+// Cross-process UIA calls made on this thread.
+thread_local unsigned uia_round_trips = 0;
+
+void CountRoundTrips(unsigned calls = 1) {
+  uia_round_trips += calls;
+}
+
 UiaSession& GetThreadLocalUiaSession() {
   // UI Automation proxies can block while being released from Chrome's UI
   // thread during process teardown. Keep the apartment-bound session isolated
@@ -104,6 +277,44 @@ UiaSession& GetThreadLocalUiaSession() {
   return *session;
 }
 
+// Adds the round trips made during its lifetime to the session's total for
+// `operation`.
+class ScopedRoundTripCount {
+ public:
+  explicit ScopedRoundTripCount(UiaOperation operation)
+      : operation_(operation), start_(uia_round_trips) {}
+  ~ScopedRoundTripCount() {
+    auto& totals = GetThreadLocalUiaSession().round_trip_totals;
+    RoundTripTotal& total = totals[static_cast<size_t>(operation_)];
+    ++total.calls;
+    total.round_trips += uia_round_trips - start_;
+  }
+  ScopedRoundTripCount(const ScopedRoundTripCount&) = delete;
+  ScopedRoundTripCount& operator=(const ScopedRoundTripCount&) = delete;
+
+ private:
+  UiaOperation operation_;
+  unsigned start_;
+};
+
+// "IsOnTabBar 12/4, ..." for every operation that made a round trip: its
+// round trips over its calls.
+std::wstring FormatRoundTripTotals(const UiaSession& session) {
+  std::wstring totals;
+  for (size_t i = 0; i < kUiaOperationCount; ++i) {
+    const RoundTripTotal& total = session.round_trip_totals[i];
+    if (total.round_trips == 0) {
+      continue;
+    }
+    if (!totals.empty()) {
+      totals += L", ";
+    }
+    totals += std::format(L"{} {}/{}", kUiaOperationNames[i],
+                          total.round_trips, total.calls);
+  }
+  return totals.empty() ? L"none" : totals;
+}
+
 bool CreateClassCondition(const ComPtr<IUIAutomation>& automation,
                           std::wstring_view class_name,
                           ComPtr<IUIAutomationCondition>* condition) {
@@ -155,6 +366,40 @@ bool InitializeClassConditions(UiaSession* session) {
                               &conditions.tab_strip_control_button);
 }
 
+// Only what the readers of `FindTabElements` use, the selection state and
+// the name; hit tests take rectangles from `tab_geometry_request`. Full
+// element mode, the default, so the cached tabs still answer live calls
+// such as `SelectTab` and the close-button search.
+bool InitializeTabCacheRequest(UiaSession* session) {
+  auto& request = session->tab_cache_request;
+  return SUCCEEDED(session->automation->CreateCacheRequest(
+             request.ReleaseAndGetAddressOf())) &&
+         SUCCEEDED(
+             request->AddProperty(UIA_SelectionItemIsSelectedPropertyId)) &&
+         SUCCEEDED(request->AddProperty(UIA_NamePropertyId));
+}
+
+// The tree filter of a cache request is also the view `FindAllBuildCache`
+// searches, so the raw filter reaches the tabs that collapsed tab groups hide
+// from the control view.
+bool InitializeTabGeometryRequest(UiaSession* session) {
+  ComPtr<IUIAutomationCondition> raw_view;
+  auto& request = session->tab_geometry_request;
+  return SUCCEEDED(session->automation->get_RawViewCondition(
+             raw_view.ReleaseAndGetAddressOf())) &&
+         SUCCEEDED(session->automation->CreateCacheRequest(
+             request.ReleaseAndGetAddressOf())) &&
+         SUCCEEDED(request->put_TreeFilter(raw_view.Get())) &&
+         SUCCEEDED(request->put_TreeScope(static_cast<TreeScope>(
+             TreeScope_Element | TreeScope_Children))) &&
+         SUCCEEDED(request->AddProperty(UIA_ClassNamePropertyId)) &&
+         SUCCEEDED(request->AddProperty(UIA_BoundingRectanglePropertyId)) &&
+         SUCCEEDED(request->AddProperty(UIA_IsOffscreenPropertyId)) &&
+         SUCCEEDED(
+             request->AddProperty(UIA_SelectionItemIsSelectedPropertyId)) &&
+         SUCCEEDED(request->AddPattern(UIA_SelectionItemPatternId));
+}
+
 UiaSession* GetUiaSession() {
   auto& session = GetThreadLocalUiaSession();
   if (session.init_attempted) {
@@ -192,6 +437,12 @@ UiaSession* GetUiaSession() {
     return nullptr;
   }
 
+  if (!InitializeTabCacheRequest(&session) ||
+      !InitializeTabGeometryRequest(&session)) {
+    DebugLog(L"UIA: failed to create the tab cache requests");
+    return nullptr;
+  }
+
   session.init_succeeded = true;
   return &session;
 }
@@ -219,6 +470,7 @@ bool BstrEqualsStringView(BSTR bstr, std::wstring_view expected) {
 
 ComPtr<IUIAutomationElement> GetFocusedElement(const UiaSession& session) {
   ComPtr<IUIAutomationElement> focused;
+  CountRoundTrips();
   if (FAILED(session.automation->GetFocusedElement(
           focused.ReleaseAndGetAddressOf())) ||
       !focused) {
@@ -234,6 +486,7 @@ ComPtr<IUIAutomationElement> GetElementFromWindow(const UiaSession& session,
   }
 
   ComPtr<IUIAutomationElement> element;
+  CountRoundTrips();
   if (FAILED(session.automation->ElementFromHandle(
           hwnd, element.ReleaseAndGetAddressOf())) ||
       !element) {
@@ -250,6 +503,7 @@ std::optional<std::wstring> GetStringProperty(
   }
 
   ScopedVariant property;
+  CountRoundTrips();
   if (FAILED(element->GetCurrentPropertyValue(property_id, property.Ptr())) ||
       property.Ref().vt != VT_BSTR || !property.Ref().bstrVal) {
     return std::nullopt;
@@ -257,6 +511,22 @@ std::optional<std::wstring> GetStringProperty(
   return std::wstring(property.Ref().bstrVal);
 }
 
+// As `GetStringProperty`, from the element's cache; no round trip.
+std::optional<std::wstring> GetCachedStringProperty(
+    const ComPtr<IUIAutomationElement>& element,
+    PROPERTYID property_id) {
+  if (!element) {
+    return std::nullopt;
+  }
+
+  ScopedVariant property;
+  if (FAILED(element->GetCachedPropertyValue(property_id, property.Ptr())) ||
+      property.Ref().vt != VT_BSTR || !property.Ref().bstrVal) {
+    return std::nullopt;
+  }
+  return std::wstring(property.Ref().bstrVal);
+}
+
 bool HasClassName(const ComPtr<IUIAutomationElement>& element,
                   std::wstring_view expected_class_name) {
   if (!element) {
@@ -264,6 +534,7 @@ bool HasClassName(const ComPtr<IUIAutomationElement>& element,
   }
 
   ScopedBstr class_name;
+  CountRoundTrips();
   if (FAILED(element->get_CurrentClassName(class_name.Receive())) ||
       !class_name) {
     return false;
@@ -280,6 +551,7 @@ bool HasAnyClassName(
   }
 
   ScopedBstr class_name;
+  CountRoundTrips();
   if (FAILED(element->get_CurrentClassName(class_name.Receive())) ||
       !class_name) {
     return false;
@@ -314,6 +586,7 @@ ComPtr<IUIAutomationElement> FindBrowserViewFromTopChrome(
   }
 
   ComPtr<IUIAutomationElement> element;
+  CountRoundTrips();
   if (FAILED(session.automation->ElementFromPoint(
           point, element.ReleaseAndGetAddressOf())) ||
       !element) {
@@ -327,6 +600,7 @@ ComPtr<IUIAutomationElement> FindBrowserViewFromTopChrome(
     }
 
     ComPtr<IUIAutomationElement> parent;
+    CountRoundTrips();
     if (FAILED(session.control_view_walker->GetParentElement(
             element.Get(), parent.ReleaseAndGetAddressOf()))) {
       return nullptr;
@@ -350,58 +624,6 @@ bool IsValidBookmark(const ComPtr<IUIAutomationElement>& element) {
          (view.contains(L':') || view.contains(L'.'));
 }
 
-// Walker-based traversal has a blind spot on Chrome 152+'s unified tab strip:
-// Chromium materializes the accessibility subtree below `TabStripView`
-// lazily, and until a scoped FindFirst/FindAll has touched it, walker
-// navigation (raw and control view alike) reports the node as childless --
-// Find queries reach the tabs regardless. Callers must therefore only anchor
-// this traversal on containers that were themselves resolved via a scoped
-// Find (`FindTabContainerInRegion` guarantees that order); anchoring on a
-// walker-discovered node such as `TabStripView` can silently count zero.
-// Observed on Canary 152.0.7956.0 while debugging issue #275.
-template <typename Visitor>
-bool TraverseDescendantsRaw(const UiaSession& session,
-                            const ComPtr<IUIAutomationElement>& root,
-                            Visitor visitor) {
-  if (!root || !session.raw_view_walker) {
-    return false;
-  }
-
-  std::vector<ComPtr<IUIAutomationElement>> stack;
-  auto push_children = [&](const ComPtr<IUIAutomationElement>& parent) {
-    ComPtr<IUIAutomationElement> child;
-    if (FAILED(session.raw_view_walker->GetFirstChildElement(
-            parent.Get(), child.ReleaseAndGetAddressOf()))) {
-      return;
-    }
-    while (child) {
-      stack.emplace_back(child);
-      ComPtr<IUIAutomationElement> next;
-      if (FAILED(session.raw_view_walker->GetNextSiblingElement(
-              child.Get(), next.ReleaseAndGetAddressOf()))) {
-        break;
-      }
-      child = std::move(next);
-    }
-  };
-
-  // Seed the stack with root's direct children, not root itself, so the
-  // visitor is only called on actual descendants.
-  push_children(root);
-
-  while (!stack.empty()) {
-    auto node = std::move(stack.back());
-    stack.pop_back();
-    if (visitor(node)) {
-      return true;
-    }
-
-    push_children(node);
-  }
-
-  return false;
-}
-
 ComPtr<IUIAutomationElement> FindFirstDescendantByClass(
     const ComPtr<IUIAutomationElement>& root,
     const ComPtr<IUIAutomationCondition>& class_condition) {
@@ -410,6 +632,7 @@ ComPtr<IUIAutomationElement> FindFirstDescendantByClass(
   }
 
   ComPtr<IUIAutomationElement> hit;
+  CountRoundTrips();
   if (FAILED(root->FindFirst(TreeScope_Subtree, class_condition.Get(),
                              hit.ReleaseAndGetAddressOf()))) {
     return nullptr;
@@ -417,166 +640,297 @@ ComPtr<IUIAutomationElement> FindFirstDescendantByClass(
   return hit;
 }
 
-std::optional<int> CountDescendantsByClassRaw(
-    const UiaSession& session,
-    const ComPtr<IUIAutomationElement>& root,
-    std::wstring_view class_name) {
-  if (!root || !session.raw_view_walker) {
-    return std::nullopt;
+// True when the element roots a hosted-HWND subtree (its native window
+// handle is set). Views elements are virtual children of the top-level
+// window and report no handle of their own.
+bool HasNativeWindowHandle(const ComPtr<IUIAutomationElement>& element) {
+  if (!element) {
+    return false;
   }
 
-  int count = 0;
-  TraverseDescendantsRaw(session, root, [&](const auto& node) {
-    if (HasClassName(node, class_name)) {
-      ++count;
-    }
+  UIA_HWND native_window = nullptr;
+  CountRoundTrips();
+  if (FAILED(element->get_CurrentNativeWindowHandle(&native_window))) {
     return false;
-  });
-  return count;
+  }
+  return native_window != nullptr;
 }
 
-ComPtr<IUIAutomationElement> FindSiblingByClass(
-    const UiaSession& session,
-    const ComPtr<IUIAutomationElement>& element,
+// The class condition `InitializeClassConditions` cached for `class_name`,
+// or nullptr.
+IUIAutomationCondition* FindClassCondition(
+    const CachedClassConditions& conditions,
     std::wstring_view class_name) {
-  if (!element || !session.control_view_walker) {
-    return nullptr;
+  const std::pair<std::wstring_view, const ComPtr<IUIAutomationCondition>*>
+      known[] = {
+          {L"TabStrip::TabDragContextImpl",
+           &conditions.tab_strip_drag_context},
+          {L"TabContainerImpl", &conditions.tab_container_impl},
+          {L"VerticalUnpinnedTabContainerView",
+           &conditions.vertical_unpinned_tab_container_view},
+          {L"UnpinnedTabContainerView",
+           &conditions.unpinned_tab_container_view},
+          {L"Tab", &conditions.tab},
+          {L"VerticalTabView", &conditions.vertical_tab_view},
+          {L"TabView", &conditions.tab_view},
+          {L"TabCloseButton", &conditions.tab_close_button},
+          {L"BookmarkButton", &conditions.bookmark_button},
+          {L"MenuItemView", &conditions.menu_item_view},
+          {L"TabStripControlButton", &conditions.tab_strip_control_button},
+      };
+  for (const auto& [name, condition] : known) {
+    if (name == class_name) {
+      return condition->Get();
+    }
   }
+  return nullptr;
+}
 
-  for (const bool forward : {true, false}) {
-    ComPtr<IUIAutomationElement> current;
-    HRESULT hr = forward
-                     ? session.control_view_walker->GetNextSiblingElement(
-                           element.Get(), current.ReleaseAndGetAddressOf())
-                     : session.control_view_walker->GetPreviousSiblingElement(
-                           element.Get(), current.ReleaseAndGetAddressOf());
-    while (SUCCEEDED(hr) && current) {
-      if (HasClassName(current, class_name)) {
-        return current;
-      }
+// `UiaTree` over one view of the live UIA tree, for the algorithms in
+// uiatree.h. Every call is a round trip. Without `conditions` (the watcher
+// thread has none of its own), `FindFirst` finds nothing.
+class UiaTreeView {
+ public:
+  using Node = ComPtr<IUIAutomationElement>;
 
-      ComPtr<IUIAutomationElement> next;
-      hr = forward ? session.control_view_walker->GetNextSiblingElement(
-                         current.Get(), next.ReleaseAndGetAddressOf())
-                   : session.control_view_walker->GetPreviousSiblingElement(
-                         current.Get(), next.ReleaseAndGetAddressOf());
-      current = std::move(next);
+  explicit UiaTreeView(IUIAutomationTreeWalker* walker,
+                       const CachedClassConditions* conditions = nullptr)
+      : walker_(walker), conditions_(conditions) {}
+
+  Node FirstChild(const Node& node) const {
+    Node child;
+    CountRoundTrips();
+    if (FAILED(walker_->GetFirstChildElement(
+            node.Get(), child.ReleaseAndGetAddressOf()))) {
+      return nullptr;
     }
+    return child;
   }
 
-  return nullptr;
-}
+  Node NextSibling(const Node& node) const {
+    Node sibling;
+    CountRoundTrips();
+    if (FAILED(walker_->GetNextSiblingElement(
+            node.Get(), sibling.ReleaseAndGetAddressOf()))) {
+      return nullptr;
+    }
+    return sibling;
+  }
 
-// True when the element roots a hosted-HWND subtree (its native window
-// handle is set). Views elements are virtual children of the top-level
-// window and report no handle of their own.
-bool HasNativeWindowHandle(const ComPtr<IUIAutomationElement>& element) {
-  if (!element) {
-    return false;
+  Node PreviousSibling(const Node& node) const {
+    Node sibling;
+    CountRoundTrips();
+    if (FAILED(walker_->GetPreviousSiblingElement(
+            node.Get(), sibling.ReleaseAndGetAddressOf()))) {
+      return nullptr;
+    }
+    return sibling;
   }
 
-  UIA_HWND native_window = nullptr;
-  if (FAILED(element->get_CurrentNativeWindowHandle(&native_window))) {
-    return false;
+  std::optional<std::wstring> ClassName(const Node& node) const {
+    ScopedBstr class_name;
+    CountRoundTrips();
+    if (FAILED(node->get_CurrentClassName(class_name.Receive()))) {
+      return std::nullopt;
+    }
+    return class_name ? std::wstring(class_name.Get(), class_name.Length())
+                      : std::wstring();
   }
-  return native_window != nullptr;
-}
 
-// Breadth-first search for the first descendant whose class name is in
-// `target_class_names`, restricted to the browser chrome.
-
-// `FindFirst(TreeScope_Subtree)` from the window root is pre-order, and the
-// web-content branch precedes the tab strip there (`BrowserView` children in
-// order: `TopContainerView`, the content `View ▸ MultiContentsView ▸
-// Document`, and only then `HorizontalTabStripRegionView`. Every such search
-// walked the entire renderer accessibility tree, and the first touch of web
-// content makes Chromium turn on `AXMode::kWebContents` for the rest of the
-// session, after which the renderer maintains a full accessibility tree for
-// every page (ui/accessibility/platform/ax_platform.h,
-// `OnPropertiesUsedInWebContent`). That combination was the DOM-heavy-page
-// click/resize/scroll lag of issue #270.
-
-// BFS reaches the tab strip region at its shallow depth after a couple dozen
-// class reads without entering sibling subtrees, and web content stays
-// structurally unreachable: the walk never descends into an element hosting
-// its own HWND (`Intermediate D3D Window`, the WebContents host
-// `Chrome_WidgetWin_1`, `Chrome_RenderWidgetHostHWND`) nor into the known
-// content-branch views, and `max_visited`/depth budgets bound the walk even
-// if a future Chrome reshuffles the tree.
-ComPtr<IUIAutomationElement> FindShallowDescendantByClasses(
+  bool HostsWindow(const Node& node) const {
+    return HasNativeWindowHandle(node);
+  }
+
+  Node FindFirst(const Node& root, std::wstring_view class_name) const {
+    IUIAutomationCondition* condition =
+        conditions_ ? FindClassCondition(*conditions_, class_name) : nullptr;
+    if (!root || !condition) {
+      return nullptr;
+    }
+    Node hit;
+    CountRoundTrips();
+    if (FAILED(root->FindFirst(TreeScope_Subtree, condition,
+                               hit.ReleaseAndGetAddressOf()))) {
+      return nullptr;
+    }
+    return hit;
+  }
+
+ private:
+  IUIAutomationTreeWalker* walker_;
+  const CachedClassConditions* conditions_;
+};
+
+static_assert(UiaTree<UiaTreeView>);
+
+// `FindShallowDescendantByClasses` from uiatree.h over `walker`'s view of the
+// live tree.
+ShallowSearchResult<ComPtr<IUIAutomationElement>> FindShallowUiaDescendant(
     IUIAutomationTreeWalker* walker,
     const ComPtr<IUIAutomationElement>& anchor,
     std::initializer_list<std::wstring_view> target_class_names,
     int max_visited) {
-  if (!walker || !anchor) {
-    return nullptr;
+  if (!walker) {
+    return {};
   }
+  auto result = FindShallowDescendantByClasses(
+      UiaTreeView(walker), anchor, target_class_names, max_visited);
+  if (result.budget_exhausted) {
+    DebugLog(L"UIA: chrome-only BFS exhausted its element budget");
+  }
+  return result;
+}
 
-  constexpr int kMaxDepth = 12;
-
-  struct QueuedElement {
-    ComPtr<IUIAutomationElement> element;
-    int depth;
-  };
-  std::vector<QueuedElement> queue;
-  size_t next_index = 0;
-
-  auto enqueue_children = [&](const ComPtr<IUIAutomationElement>& parent,
-                              int depth) {
-    ComPtr<IUIAutomationElement> child;
-    if (FAILED(walker->GetFirstChildElement(parent.Get(),
-                                            child.ReleaseAndGetAddressOf()))) {
+// Registers and removes every `TabStripWatcher`. UIA calls event handlers on
+// its own MTA threads, and a handler registered from the UI thread of the
+// provider's process can deadlock against it, so a dedicated MTA thread with
+// its own `IUIAutomation` does the registering; the hook threads only post
+// requests. When the thread cannot start, no watcher ever registers.
+class TabStripWatchThread {
+ public:
+  static TabStripWatchThread& Instance() {
+    // Never destroyed: UIA may still call the watchers while the process
+    // exits.
+    static TabStripWatchThread* thread = new TabStripWatchThread;
+    return *thread;
+  }
+
+  // Queues the registration (`watch`) or removal of `watcher`; returns at
+  // once. Requests run in order.
+  void Post(ComPtr<TabStripWatcher> watcher, bool watch) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (unavailable_) {
       return;
     }
-    while (child) {
-      queue.push_back({child, depth});
-      ComPtr<IUIAutomationElement> sibling;
-      if (FAILED(walker->GetNextSiblingElement(
-              child.Get(), sibling.ReleaseAndGetAddressOf()))) {
-        break;
-      }
-      child = std::move(sibling);
+    requests_.push_back({std::move(watcher), watch});
+    if (!thread_started_) {
+      thread_started_ = true;
+      std::thread([this] { Run(); }).detach();
     }
+    requests_changed_.notify_one();
+  }
+
+ private:
+  struct Request {
+    ComPtr<TabStripWatcher> watcher;
+    bool watch;
   };
 
-  enqueue_children(anchor, 1);
+  TabStripWatchThread() = default;
+
+  void Run() {
+    ComInitializer com_initializer(COINIT_MULTITHREADED);
+    ComPtr<IUIAutomation> automation;
+    ComPtr<IUIAutomationTreeWalker> walker;
+    if (!com_initializer.IsInitialized() ||
+        FAILED(CoCreateInstance(
+            CLSID_CUIAutomation, nullptr, CLSCTX_INPROC_SERVER,
+            IID_PPV_ARGS(automation.ReleaseAndGetAddressOf()))) ||
+        FAILED(automation->get_ControlViewWalker(&walker)) || !walker) {
+      DebugLog(L"UIA: tab strip watcher unavailable, validating by reads");
+      std::lock_guard<std::mutex> lock(mutex_);
+      unavailable_ = true;
+      requests_.clear();
+      return;
+    }
 
-  int visited = 0;
-  while (next_index < queue.size()) {
-    // Moved (not referenced) out of the queue: enqueue_children() below can
-    // reallocate `queue`, which would invalidate a reference into it.
-    const QueuedElement current = std::move(queue[next_index]);
-    ++next_index;
-    if (++visited > max_visited) {
-      DebugLog(L"UIA: chrome-only BFS exhausted its element budget");
-      return nullptr;
+    std::vector<Request> requests;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        requests_changed_.wait(lock, [&] { return !requests_.empty(); });
+        requests.swap(requests_);
+      }
+      for (const Request& request : requests) {
+        TabStripWatcher* watcher = request.watcher.Get();
+        if (!request.watch) {
+          Unregister(automation.Get(), watcher);
+        } else if (Register(automation.Get(), walker.Get(), watcher)) {
+          // Invalidated before it reports registered, so a check whose
+          // generation reading follows `registered()` can never pass on a
+          // rectangle read before the handlers were in place.
+          watcher->Invalidate();
+          watcher->registered_.store(true, std::memory_order_release);
+        } else {
+          Unregister(automation.Get(), watcher);
+          DebugLog(L"UIA: cannot watch the tab strip of {}",
+                   static_cast<void*>(watcher->window()));
+        }
+      }
+      requests.clear();
     }
+  }
 
-    ScopedBstr class_name;
-    if (FAILED(current.element->get_CurrentClassName(class_name.Receive()))) {
-      continue;
+  // The same region `ResolveTabUi` anchors on, found again with this thread's
+  // own automation objects.
+  bool Register(IUIAutomation* automation,
+                IUIAutomationTreeWalker* walker,
+                TabStripWatcher* watcher) {
+    ComPtr<IUIAutomationElement> window_element;
+    if (FAILED(automation->ElementFromHandle(
+            watcher->window(), window_element.ReleaseAndGetAddressOf())) ||
+        !window_element) {
+      return false;
     }
-    const std::wstring_view class_name_view =
-        class_name ? std::wstring_view(class_name.Get(), class_name.Length())
-                   : std::wstring_view();
-    if (std::ranges::contains(target_class_names, class_name_view)) {
-      return current.element;
+    watcher->region_ =
+        FindShallowUiaDescendant(
+            walker, window_element,
+            {L"HorizontalTabStripRegionView",
+             L"HorizontalTabStripRegionViewOld", L"VerticalTabStripRegionView"},
+            /*max_visited=*/256)
+            .node;
+    IUIAutomationElement* region = watcher->region_.Get();
+    if (!region) {
+      return false;
     }
 
-    if (current.depth >= kMaxDepth) {
-      continue;
-    }
-    if (std::ranges::contains(
-            std::initializer_list<std::wstring_view>{
-                L"MultiContentsView", L"WebView", L"ContentsWebView"},
-            class_name_view) ||
-        HasNativeWindowHandle(current.element)) {
-      continue;
+    // Selection and visibility changes of a tab move no rectangle, yet both
+    // change what the geometry of the strip answers.
+    PROPERTYID properties[] = {UIA_BoundingRectanglePropertyId,
+                               UIA_SelectionItemIsSelectedPropertyId,
+                               UIA_IsOffscreenPropertyId};
+    return SUCCEEDED(automation->AddStructureChangedEventHandler(
+               region, TreeScope_Subtree, nullptr, watcher)) &&
+           SUCCEEDED(automation->AddPropertyChangedEventHandlerNativeArray(
+               region, TreeScope_Subtree, nullptr, watcher, properties,
+               static_cast<int>(std::size(properties)))) &&
+           SUCCEEDED(automation->AddAutomationEventHandler(
+               UIA_SelectionItem_ElementSelectedEventId, region,
+               TreeScope_Subtree, nullptr, watcher));
+  }
+
+  // Removes whichever handlers of `watcher` are registered; the others fail
+  // harmlessly.
+  void Unregister(IUIAutomation* automation, TabStripWatcher* watcher) {
+    watcher->registered_.store(false, std::memory_order_release);
+    IUIAutomationElement* region = watcher->region_.Get();
+    if (!region) {
+      return;
     }
-    enqueue_children(current.element, current.depth + 1);
-  }
+    automation->RemoveStructureChangedEventHandler(region, watcher);
+    automation->RemovePropertyChangedEventHandler(region, watcher);
+    automation->RemoveAutomationEventHandler(
+        UIA_SelectionItem_ElementSelectedEventId, region, watcher);
+    watcher->region_.Reset();
+  }
+
+  std::mutex mutex_;
+  std::condition_variable requests_changed_;
+  std::vector<Request> requests_;
+  bool thread_started_ = false;
+  bool unavailable_ = false;
+};
 
-  return nullptr;
+TabStripWatch::TabStripWatch(HWND window) {
+  watcher_.Attach(new TabStripWatcher(window));
+  TabStripWatchThread::Instance().Post(watcher_, /*watch=*/true);
+}
+
+void TabStripWatch::Reset() {
+  if (watcher_) {
+    TabStripWatchThread::Instance().Post(std::move(watcher_),
+                                         /*watch=*/false);
+  }
 }
 
 TreeScope GetTabElementScope(TabContainerKind kind) {
@@ -587,18 +941,6 @@ TreeScope GetTabElementScope(TabContainerKind kind) {
                                                : TreeScope_Subtree;
 }
 
-std::wstring_view GetTabElementClassName(TabContainerKind kind) {
-  switch (kind) {
-    case TabContainerKind::kHorizontal:
-      return L"Tab";
-    case TabContainerKind::kVertical:
-      return L"VerticalTabView";
-    case TabContainerKind::kUnified:
-      return L"TabView";
-  }
-  return L"Tab";
-}
-
 const ComPtr<IUIAutomationCondition>& GetTabElementCondition(
     const UiaSession& session,
     TabContainerKind kind) {
@@ -635,53 +977,32 @@ bool IsWindowFullScreen(HWND hwnd) {
          window_rect.bottom == monitor_info.rcMonitor.bottom;
 }
 
-// Resolves the tab container inside an already validated tab strip region.
-// The region subtree is content-free, so scoped `FindFirst` is safe here. Trust
-// is anchored on the region itself: popup windows expose no
-// `HorizontalTabStripRegionView`/`VerticalTabStripRegionView`, so tab-like
-// nodes elsewhere can never be misclassified as a tab strip.
-std::optional<TabContainer> FindTabContainerInRegion(
-    const UiaSession& session,
-    const ComPtr<IUIAutomationElement>& region,
-    bool vertical) {
-  if (vertical) {
-    if (const auto container = FindFirstDescendantByClass(
-            region,
-            session.class_conditions.vertical_unpinned_tab_container_view)) {
-      return TabContainer{container, TabContainerKind::kVertical};
-    }
-    // Chrome 152 vertical strip (unified TabCollectionNode system): the
-    // region name is unchanged but the subtree is `TabStripView ▸ ScrollView
-    // ▸ Viewport ▸ UnpinnedTabContainerView ▸ TabView`. Anchoring on the
-    // unpinned container mirrors the pre-152 behavior (pinned tabs live in a
-    // sibling `PinnedTabContainerView` and stay out of hit-testing/counts).
-    // The scoped `FindFirst` also matters functionally: Chromium materializes
-    // this subtree lazily, and tree-walker navigation below `TabStripView`
-    // returns no children until a scoped Find query has touched it.
-    if (const auto container = FindFirstDescendantByClass(
-            region, session.class_conditions.unpinned_tab_container_view)) {
-      return TabContainer{container, TabContainerKind::kUnified};
-    }
-    return std::nullopt;
-  }
+// The cache entry of `hwnd`, made most recent. A miss returns a blank entry
+// (`window` null) in place of the least recently used one. Entries of
+// destroyed windows are dropped first.
+TabUiCache& GetTabUiCache(UiaSession* session, HWND hwnd) {
+  auto& caches = session->tab_ui_caches;
+  caches.EraseIf([](HWND window, const TabUiCache&) {
+    return !IsWindow(window);
+  });
 
-  if (const auto tab_strip = FindFirstDescendantByClass(
-          region, session.class_conditions.tab_strip_drag_context)) {
-    if (const auto container =
-            FindSiblingByClass(session, tab_strip, L"TabContainerImpl")) {
-      return TabContainer{container, TabContainerKind::kHorizontal};
-    }
+  if (TabUiCache* cache = caches.Find(hwnd)) {
+    ++session->tab_ui_cache_hits;
+    return *cache;
   }
 
-  if (const auto container = FindFirstDescendantByClass(
-          region, session.class_conditions.tab_container_impl)) {
-    return TabContainer{container, TabContainerKind::kHorizontal};
-  }
-  return std::nullopt;
+  ++session->tab_ui_cache_misses;
+  TabUiCache& cache = caches.Insert(hwnd);
+  DebugLog(
+      L"UIA: tab UI cache miss ({} hits, {} misses, {} windows; round "
+      L"trips/calls: {})",
+      session->tab_ui_cache_hits, session->tab_ui_cache_misses, caches.size(),
+      FormatRoundTripTotals(*session));
+  return cache;
 }
 
 TabUiCache* ResolveTabUi(UiaSession* session, HWND hwnd) {
-  TabUiCache& cache = session->tab_ui_cache;
+  TabUiCache& cache = GetTabUiCache(session, hwnd);
   const bool fullscreen = IsWindowFullScreen(hwnd);
   if (cache.window == hwnd && cache.fullscreen == fullscreen) {
     if (cache.container.element) {
@@ -709,15 +1030,18 @@ TabUiCache* ResolveTabUi(UiaSession* session, HWND hwnd) {
   // horizontal_tab_strip_region_view.h). Match the pre-152 and `Old` names;
   // the flagged `New` view hosts a different subtree (TabCollectionNode) and
   // needs its own container resolution once it ships enabled.
-  auto region = FindShallowDescendantByClasses(
+  // The search returns the matched class with the region, so telling the
+  // vertical strip apart costs no further read.
+  auto region = FindShallowUiaDescendant(
       session->control_view_walker.Get(), window_element,
       {L"HorizontalTabStripRegionView", L"HorizontalTabStripRegionViewOld",
        L"VerticalTabStripRegionView"},
       /*max_visited=*/256);
-  if (!region && !fullscreen &&
-      FindShallowDescendantByClasses(session->control_view_walker.Get(),
-                                     window_element, {L"FindBarView"},
-                                     /*max_visited=*/32)) {
+  if (!region.node && !fullscreen &&
+      FindShallowUiaDescendant(session->control_view_walker.Get(),
+                               window_element, {L"FindBarView"},
+                               /*max_visited=*/32)
+          .node) {
     // `FindBarHost` owns a separate Widget parented to the browser's native
     // view. While it is visible, `ElementFromHandle` can expose only that
     // widget's UIA fragment instead of `BrowserView`.
@@ -728,20 +1052,23 @@ TabUiCache* ResolveTabUi(UiaSession* session, HWND hwnd) {
       DebugLog(L"UIA: failed to recover BrowserView from browser chrome");
       return nullptr;
     }
-    region = FindShallowDescendantByClasses(
+    region = FindShallowUiaDescendant(
         session->control_view_walker.Get(), browser_view,
         {L"HorizontalTabStripRegionView", L"HorizontalTabStripRegionViewOld",
          L"VerticalTabStripRegionView"},
         /*max_visited=*/256);
-    if (!region) {
+    if (!region.node) {
       DebugLog(L"UIA: recovered BrowserView has no tab strip region");
     }
   }
 
-  if (region) {
-    const bool vertical = HasClassName(region, L"VerticalTabStripRegionView");
-    if (auto container = FindTabContainerInRegion(*session, region, vertical)) {
-      cache.region = region;
+  if (region.node) {
+    const bool vertical = region.class_name == L"VerticalTabStripRegionView";
+    if (auto container = FindTabContainerInRegion(
+            UiaTreeView(session->control_view_walker.Get(),
+                        &session->class_conditions),
+            region.node, vertical)) {
+      cache.region = std::move(region.node);
       cache.container = std::move(*container);
       return &cache;
     }
@@ -754,18 +1081,15 @@ TabUiCache* ResolveTabUi(UiaSession* session, HWND hwnd) {
     // budget because the raw view exposes more nodes per level. Limiting the
     // fallback to fullscreen keeps popups from being misclassified as tabbed
     // browser windows.
-    if (const auto container = FindShallowDescendantByClasses(
-            session->raw_view_walker.Get(), window_element,
-            {L"TabContainerImpl", L"VerticalUnpinnedTabContainerView",
-             L"UnpinnedTabContainerView"},
-            /*max_visited=*/512)) {
-      TabContainerKind kind = TabContainerKind::kHorizontal;
-      if (HasClassName(container, L"VerticalUnpinnedTabContainerView")) {
-        kind = TabContainerKind::kVertical;
-      } else if (HasClassName(container, L"UnpinnedTabContainerView")) {
-        kind = TabContainerKind::kUnified;
-      }
-      cache.container = TabContainer{container, kind};
+    auto container = FindShallowUiaDescendant(
+        session->raw_view_walker.Get(), window_element,
+        {L"TabContainerImpl", L"VerticalUnpinnedTabContainerView",
+         L"UnpinnedTabContainerView"},
+        /*max_visited=*/512);
+    if (container.node) {
+      cache.container = TabContainer{
+          std::move(container.node),
+          GetTabContainerKind(container.class_name)};
       return &cache;
     }
   }
@@ -787,6 +1111,11 @@ TabUiCache* ResolveTabUi(UiaSession* session, HWND hwnd) {
 // with S_OK and an empty rectangle rather than an error. Outside fullscreen a
 // live tab strip always has a non-empty rectangle, so an empty region or
 // container rectangle marks a cache entry orphaned by a layout toggle.
+//
+// With the entry's tab strip watched (`TabStripWatch`), a check that passed
+// stays valid until an event arrives or the window moves, and its rectangle
+// is reused without any read. Generations are read before the rectangles so
+// an event racing the reads forces the next check to read again.
 TabUiCache* GetValidatedTabUi(UiaSession* session, HWND hwnd, RECT* gate_rect) {
   for (int attempt = 0; attempt < 2; ++attempt) {
     TabUiCache* ui = ResolveTabUi(session, hwnd);
@@ -794,8 +1123,19 @@ TabUiCache* GetValidatedTabUi(UiaSession* session, HWND hwnd, RECT* gate_rect) {
       return nullptr;
     }
 
+    RECT window_rect = {};
+    GetWindowRect(hwnd, &window_rect);
+    const bool watched = ui->watch.registered();
+    const uint64_t generation = ui->watch.generation();
+    if (ui->validated && watched && ui->validated_generation == generation &&
+        EqualRect(&ui->validated_window_rect, &window_rect)) {
+      *gate_rect = ui->validated_gate_rect;
+      return ui;
+    }
+
     const ComPtr<IUIAutomationElement>& gate =
         ui->region ? ui->region : ui->container.element;
+    CountRoundTrips();
     if (SUCCEEDED(gate->get_CurrentBoundingRectangle(gate_rect))) {
       if (!ui->region) {
         // Fullscreen raw-view fallback: the auto-hidden strip may
@@ -804,18 +1144,28 @@ TabUiCache* GetValidatedTabUi(UiaSession* session, HWND hwnd, RECT* gate_rect) {
         return ui;
       }
       RECT container_rect;
+      CountRoundTrips();
       if (!IsRectEmpty(gate_rect) &&
           SUCCEEDED(ui->container.element->get_CurrentBoundingRectangle(
               &container_rect)) &&
           !IsRectEmpty(&container_rect)) {
+        ui->validated = true;
+        ui->validated_generation = generation;
+        ui->validated_window_rect = window_rect;
+        ui->validated_gate_rect = *gate_rect;
+        if (!ui->watch) {
+          ui->watch = TabStripWatch(hwnd);
+        }
         return ui;
       }
     }
-    session->tab_ui_cache = TabUiCache();
+    *ui = TabUiCache();
   }
   return nullptr;
 }
 
+// Every tab of the container with the properties of `tab_cache_request`
+// cached, in one round trip; read them with the `Cached` accessors.
 ComPtr<IUIAutomationElementArray> FindTabElements(
     const UiaSession& session,
     const TabContainer& tab_container) {
@@ -824,9 +1174,11 @@ ComPtr<IUIAutomationElementArray> FindTabElements(
   }
 
   ComPtr<IUIAutomationElementArray> tab_elements;
-  if (FAILED(tab_container.element->FindAll(
+  CountRoundTrips();
+  if (FAILED(tab_container.element->FindAllBuildCache(
           GetTabElementScope(tab_container.kind),
           GetTabElementCondition(session, tab_container.kind).Get(),
+          session.tab_cache_request.Get(),
           tab_elements.ReleaseAndGetAddressOf())) ||
       !tab_elements) {
     return nullptr;
@@ -835,36 +1187,102 @@ ComPtr<IUIAutomationElementArray> FindTabElements(
   return tab_elements;
 }
 
-ComPtr<IUIAutomationElement> FindTabElementAtPoint(
-    const ComPtr<IUIAutomationElementArray>& tab_elements,
-    POINT pt) {
-  if (!tab_elements) {
-    return nullptr;
+TabBounds ToTabBounds(const RECT& rect) {
+  return {rect.left, rect.top, rect.right, rect.bottom};
+}
+
+// The cached rectangle of `tab`'s `TabCloseButton` child; empty when the tab
+// shows none or it is nested deeper than the cached children.
+TabBounds GetCachedCloseButtonBounds(
+    const ComPtr<IUIAutomationElement>& tab) {
+  ComPtr<IUIAutomationElementArray> children;
+  int length = 0;
+  if (FAILED(tab->GetCachedChildren(children.ReleaseAndGetAddressOf())) ||
+      !children || FAILED(children->get_Length(&length))) {
+    return {};
   }
+  for (int i = 0; i < length; ++i) {
+    ComPtr<IUIAutomationElement> child;
+    ScopedBstr class_name;
+    RECT rect;
+    if (SUCCEEDED(children->GetElement(i, child.ReleaseAndGetAddressOf())) &&
+        child &&
+        SUCCEEDED(child->get_CachedClassName(class_name.Receive())) &&
+        BstrEqualsStringView(class_name.Get(), L"TabCloseButton") &&
+        SUCCEEDED(child->get_CachedBoundingRectangle(&rect))) {
+      return ToTabBounds(rect);
+    }
+  }
+  return {};
+}
 
-  int count = 0;
-  if (FAILED(tab_elements->get_Length(&count))) {
+// The geometry of every tab in `ui`'s container: one `FindAllBuildCache`
+// brings the rectangles, selection, visibility and close buttons of all tabs,
+// and the result answers hit tests and counts until the entry's
+// `TabStripWatch` reports an event or the window moves. An unwatched strip
+// (the fullscreen fallback, or before the watcher has registered) is scanned
+// on every call, which still costs the single round trip. As in
+// `GetValidatedTabUi`, the generation is read before the scan so an event
+// racing it forces a rescan.
+const TabGeometry* GetTabGeometry(const UiaSession& session, TabUiCache* ui) {
+  RECT window_rect = {};
+  GetWindowRect(ui->window, &window_rect);
+  const bool watched = ui->watch.registered();
+  const uint64_t generation = ui->watch.generation();
+  if (ui->geometry && watched && ui->geometry_generation == generation &&
+      EqualRect(&ui->geometry_window_rect, &window_rect)) {
+    return &*ui->geometry;
+  }
+
+  ui->geometry.reset();
+  ui->geometry_tabs.Reset();
+  ComPtr<IUIAutomationElementArray> tab_elements;
+  int length = 0;
+  CountRoundTrips();
+  if (FAILED(ui->container.element->FindAllBuildCache(
+          GetTabElementScope(ui->container.kind),
+          GetTabElementCondition(session, ui->container.kind).Get(),
+          session.tab_geometry_request.Get(),
+          tab_elements.ReleaseAndGetAddressOf())) ||
+      !tab_elements || FAILED(tab_elements->get_Length(&length))) {
     return nullptr;
   }
 
-  for (int i = 0; i < count; ++i) {
-    ComPtr<IUIAutomationElement> tab_element;
-    if (FAILED(tab_elements->GetElement(
-            i, tab_element.ReleaseAndGetAddressOf())) ||
-        !tab_element) {
+  std::vector<TabGeometry::Tab> tabs(length);
+  for (int i = 0; i < length; ++i) {
+    ComPtr<IUIAutomationElement> tab;
+    if (FAILED(tab_elements->GetElement(i, tab.ReleaseAndGetAddressOf())) ||
+        !tab) {
       continue;
     }
 
+    // Tabs of a collapsed group only count: they keep empty bounds and are
+    // never hit.
+    BOOL offscreen = FALSE;
     RECT rect;
-    if (FAILED(tab_element->get_CurrentBoundingRectangle(&rect))) {
-      continue;
-    }
-    if (PtInRect(&rect, pt)) {
-      return tab_element;
+    if (SUCCEEDED(tab->get_CachedIsOffscreen(&offscreen)) && !offscreen &&
+        SUCCEEDED(tab->get_CachedBoundingRectangle(&rect))) {
+      tabs[i].bounds = ToTabBounds(rect);
+      tabs[i].close_button = GetCachedCloseButtonBounds(tab);
     }
-  }
 
-  return nullptr;
+    ScopedVariant is_selected;
+    tabs[i].selected =
+        SUCCEEDED(tab->GetCachedPropertyValue(
+            UIA_SelectionItemIsSelectedPropertyId, is_selected.Ptr())) &&
+        is_selected.Ref().vt == VT_BOOL &&
+        is_selected.Ref().boolVal == VARIANT_TRUE;
+  }
+
+  // Both vertical kinds stack tabs top to bottom. Should the unified classes
+  // ship horizontally, the lookup stays correct on the wrong axis, only
+  // linear.
+  ui->geometry = TabGeometry::Build(
+      tabs, ui->container.kind != TabContainerKind::kHorizontal);
+  ui->geometry_tabs = std::move(tab_elements);
+  ui->geometry_generation = generation;
+  ui->geometry_window_rect = window_rect;
+  return &*ui->geometry;
 }
 
 bool IsOnTabCloseButton(const UiaSession& session,
@@ -881,6 +1299,7 @@ bool IsOnTabCloseButton(const UiaSession& session,
   }
 
   RECT close_button_rect;
+  CountRoundTrips();
   if (FAILED(close_button->get_CurrentBoundingRectangle(&close_button_rect))) {
     return false;
   }
@@ -908,7 +1327,7 @@ ComPtr<IUIAutomationElement> FindSelectedTabElement(
     }
 
     ScopedVariant is_selected;
-    if (FAILED(tab->GetCurrentPropertyValue(
+    if (FAILED(tab->GetCachedPropertyValue(
             UIA_SelectionItemIsSelectedPropertyId, is_selected.Ptr()))) {
       continue;
     }
@@ -922,36 +1341,36 @@ ComPtr<IUIAutomationElement> FindSelectedTabElement(
 }
 
 std::optional<TabHitResult> BuildTabHitResult(const UiaSession& session,
-                                              const TabContainer& tab_container,
+                                              TabUiCache* ui,
                                               POINT pt,
                                               bool need_count,
                                               bool need_close_button) {
-  const auto tab_elements = FindTabElements(session, tab_container);
-  if (!tab_elements) {
+  const TabGeometry* geometry = GetTabGeometry(session, ui);
+  if (!geometry) {
     return std::nullopt;
   }
 
-  const auto tab_element = FindTabElementAtPoint(tab_elements, pt);
-  if (!tab_element) {
+  const auto index = geometry->TabAt(pt.x, pt.y);
+  ComPtr<IUIAutomationElement> tab_element;
+  if (!index ||
+      FAILED(ui->geometry_tabs->GetElement(
+          static_cast<int>(*index), tab_element.ReleaseAndGetAddressOf())) ||
+      !tab_element) {
     return std::nullopt;
   }
 
-  int tab_count = 0;
-  if (need_count) {
-    const auto raw_count =
-        CountDescendantsByClassRaw(session, tab_container.element,
-                                   GetTabElementClassName(tab_container.kind));
-    if (!raw_count) {
-      return std::nullopt;
-    }
-    tab_count = *raw_count;
-  }
-
+  const TabGeometry::Tab& tab = geometry->tab(*index);
   TabHitResult hit_result;
   hit_result.tab = tab_element;
-  hit_result.tab_count = need_count ? tab_count : 0;
-  hit_result.on_close_button =
-      need_close_button && IsOnTabCloseButton(session, tab_element, pt);
+  hit_result.tab_count = need_count ? static_cast<int>(geometry->size()) : 0;
+  if (need_close_button) {
+    // A close button nested below the tab's children was not cached; look
+    // for it live.
+    hit_result.on_close_button =
+        tab.close_button.empty()
+            ? IsOnTabCloseButton(session, tab_element, pt)
+            : tab.close_button.Contains(pt.x, pt.y);
+  }
   return hit_result;
 }
 
@@ -986,6 +1405,7 @@ ComPtr<IUIAutomationElement> FindBookmarkInAnchor(
     const ComPtr<IUIAutomationCondition>& item_condition,
     POINT pt) {
   ComPtr<IUIAutomationElementArray> elements;
+  CountRoundTrips();
   if (FAILED(anchor->FindAll(TreeScope_Subtree, item_condition.Get(),
                              elements.ReleaseAndGetAddressOf())) ||
       !elements) {
@@ -1002,6 +1422,7 @@ ComPtr<IUIAutomationElement> FindBookmarkInAnchor(
       continue;
     }
     RECT rect;
+    CountRoundTrips();
     if (FAILED(element->get_CurrentBoundingRectangle(&rect))) {
       continue;
     }
@@ -1059,9 +1480,11 @@ FindBookmarkCoveringPoint(const UiaSession& session, HWND window, POINT pt) {
   // `TopContainerView`, e.g. undocked DevTools: pre-order `FindFirst` walks
   // the entire renderer tree before failing and switches web-contents
   // accessibility on, the #270 failure mode.
-  if (const auto top_container = FindShallowDescendantByClasses(
-          session.control_view_walker.Get(), window_element,
-          {L"TopContainerView"}, /*max_visited=*/256)) {
+  if (const auto top_container =
+          FindShallowUiaDescendant(session.control_view_walker.Get(),
+                                   window_element, {L"TopContainerView"},
+                                   /*max_visited=*/256)
+              .node) {
     return FindBookmarkInAnchor(top_container,
                                 session.class_conditions.bookmark_button, pt);
   }
@@ -1075,6 +1498,7 @@ FindBookmarkCoveringPoint(const UiaSession& session, HWND window, POINT pt) {
   const HWND point_window = WindowFromPoint(pt);
   if (point_window && IsChromeWindow(point_window)) {
     ComPtr<IUIAutomationElement> pointed;
+    CountRoundTrips();
     if (SUCCEEDED(session.automation->ElementFromPoint(
             pt, pointed.ReleaseAndGetAddressOf())) &&
         IsValidBookmark(pointed)) {
@@ -1119,11 +1543,12 @@ FindBookmarkCoveringPoint(const UiaSession& session, HWND window, POINT pt) {
 // `IRawElementProviderHwndOverride` upstream to fix this in UIA itself.
 
 // Querying the tab container from the root window via `ElementFromHandle`
-// sidesteps HWND routing; the per-tab `PtInRect` inside `BuildTabHitResult`
+// sidesteps HWND routing; the tab geometry lookup inside `BuildTabHitResult`
 // still rejects clicks that miss every tab.
 std::optional<TabHitResult> FindTabHitResult(POINT pt,
                                              bool need_count,
                                              bool need_close_button) {
+  ScopedRoundTripCount round_trips(UiaOperation::kFindTabHitResult);
   UiaSession* session = GetUiaSession();
   if (!session) {
     return std::nullopt;
@@ -1147,18 +1572,26 @@ std::optional<TabHitResult> FindTabHitResult(POINT pt,
     return std::nullopt;
   }
 
-  return BuildTabHitResult(*session, ui->container, pt, need_count,
-                           need_close_button);
+  return BuildTabHitResult(*session, ui, pt, need_count, need_close_button);
 }
 
+// Selects even a tab the last scan saw selected: the user may have switched
+// tabs since, and selecting the active tab again changes nothing.
 bool SelectTab(const TabHitResult& hit_result) {
   if (!hit_result.tab) {
     return false;
   }
 
+  // The geometry scan caches the pattern with the tab; only a tab from
+  // elsewhere needs the round trip.
   ComPtr<IUnknown> pattern;
-  HRESULT hr = hit_result.tab->GetCurrentPattern(
+  HRESULT hr = hit_result.tab->GetCachedPattern(
       UIA_SelectionItemPatternId, pattern.ReleaseAndGetAddressOf());
+  if (FAILED(hr) || !pattern) {
+    CountRoundTrips();
+    hr = hit_result.tab->GetCurrentPattern(UIA_SelectionItemPatternId,
+                                           pattern.ReleaseAndGetAddressOf());
+  }
   if (FAILED(hr) || !pattern) {
     DebugLog(L"UIA: tab selection item pattern unavailable");
     return false;
@@ -1172,11 +1605,7 @@ bool SelectTab(const TabHitResult& hit_result) {
     return false;
   }
 
-  BOOL selected = FALSE;
-  if (SUCCEEDED(selection_item->get_CurrentIsSelected(&selected)) && selected) {
-    return true;
-  }
-
+  CountRoundTrips();
   hr = selection_item->Select();
   if (FAILED(hr)) {
     DebugLog(L"UIA: tab Select failed");
@@ -1186,13 +1615,14 @@ bool SelectTab(const TabHitResult& hit_result) {
 }
 
 std::optional<int> FindTabCount(HWND hwnd) {
+  ScopedRoundTripCount round_trips(UiaOperation::kFindTabCount);
   UiaSession* session = GetUiaSession();
   if (!session) {
     return std::nullopt;
   }
 
   // The rectangle is unused here; the validated resolve proves the cached
-  // container is still alive so the raw count below cannot silently return 0
+  // container is still alive so the count below cannot silently return 0
   // over a dead element.
   RECT region_rect;
   TabUiCache* ui = GetValidatedTabUi(session, hwnd, &region_rect);
@@ -1200,12 +1630,15 @@ std::optional<int> FindTabCount(HWND hwnd) {
     return std::nullopt;
   }
 
-  // Raw view is required: tabs inside a collapsed tab group are hidden from
-  // control view but still present in the raw tree, and they must be counted so
-  // `keep_tab` does not mistake the last visible tab for the last tab overall.
-  // Scoping the raw traversal to a credible tab container keeps it cheap.
-  return CountDescendantsByClassRaw(*session, ui->container.element,
-                                    GetTabElementClassName(ui->container.kind));
+  // The geometry scans the raw view: tabs inside a collapsed tab group are
+  // hidden from control view but still present in the raw tree, and they must
+  // be counted so `keep_tab` does not mistake the last visible tab for the
+  // last tab overall.
+  const TabGeometry* geometry = GetTabGeometry(*session, ui);
+  if (!geometry) {
+    return std::nullopt;
+  }
+  return static_cast<int>(geometry->size());
 }
 
 // The wheel path used `IUIAutomation::ElementFromPoint`, whose HWND routing
@@ -1217,6 +1650,7 @@ std::optional<int> FindTabCount(HWND hwnd) {
 // covers the same UI (tabs, new-tab button, grab handle, vertical strip) with
 // no per-tick tree access at all.
 bool IsOnTabBar(POINT pt) {
+  ScopedRoundTripCount round_trips(UiaOperation::kIsOnTabBar);
   UiaSession* session = GetUiaSession();
   if (!session) {
     return false;
@@ -1237,6 +1671,7 @@ bool IsOnTabBar(POINT pt) {
 }
 
 bool IsOnBookmark(POINT pt) {
+  ScopedRoundTripCount round_trips(UiaOperation::kIsOnBookmark);
   const UiaSession* session = GetUiaSession();
   if (!session) {
     return false;
@@ -1289,6 +1724,7 @@ bool IsOmniboxFocused() {
 }
 
 bool IsOnNewTab(HWND hwnd, const std::vector<std::wstring>& extra_tab_names) {
+  ScopedRoundTripCount round_trips(UiaOperation::kIsOnNewTab);
   UiaSession* session = GetUiaSession();
   if (!session) {
     return false;
@@ -1306,7 +1742,7 @@ bool IsOnNewTab(HWND hwnd, const std::vector<std::wstring>& extra_tab_names) {
   }
 
   const auto selected_name =
-      GetStringProperty(selected_tab, UIA_NamePropertyId);
+      GetCachedStringProperty(selected_tab, UIA_NamePropertyId);
   if (!selected_name) {
     return false;
   }
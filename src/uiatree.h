@@ -0,0 +1,228 @@
+#ifndef CHROME_PLUS_SRC_UIATREE_H_
+#define CHROME_PLUS_SRC_UIATREE_H_
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// One view (control or raw) of an accessibility tree as the tab strip
+// resolution walks it. `Node` is a cheap handle whose null value means "none";
+// navigation returns null both at the end and on failure, `ClassName` returns
+// std::nullopt on failure and an empty name for a node without one.
+// `HostsWindow` is true for a node rooting a hosted-HWND subtree, and
+// `FindFirst` is a scoped subtree search by class, which unlike walker
+// navigation reaches lazily materialized subtrees. uia.cc implements it over
+// live UIA, where every call is a round trip into Chrome's UI thread; keeping
+// the algorithms below free of Windows calls lets them run against a recorded
+// tree shape to count exactly the nodes they visit.
+template <typename T>
+concept UiaTree = requires(const T& tree,
+                           const typename T::Node& node,
+                           std::wstring_view class_name) {
+  { static_cast<bool>(node) };
+  { tree.FirstChild(node) } -> std::same_as<typename T::Node>;
+  { tree.NextSibling(node) } -> std::same_as<typename T::Node>;
+  { tree.PreviousSibling(node) } -> std::same_as<typename T::Node>;
+  { tree.ClassName(node) } -> std::same_as<std::optional<std::wstring>>;
+  { tree.HostsWindow(node) } -> std::same_as<bool>;
+  { tree.FindFirst(node, class_name) } -> std::same_as<typename T::Node>;
+};
+
+enum class TabContainerKind {
+  kHorizontal,
+  kVertical,
+  // Chrome 152 rebuilt the vertical strip on the unified TabCollectionNode
+  // system (chrome/browser/ui/views/tabs/common/tab_strip_view.h): the
+  // container is `UnpinnedTabContainerView` and tabs are `TabView`. The
+  // horizontal strip moves to the same classes once
+  // `tabs::kTabStripUnification` ships enabled.
+  kUnified,
+};
+
+template <typename Node>
+struct BasicTabContainer {
+  Node element{};
+  TabContainerKind kind = TabContainerKind::kHorizontal;
+};
+
+template <typename Node>
+struct ShallowSearchResult {
+  Node node{};
+  // The class `node` matched, read during the search, so callers need not
+  // read it again.
+  std::wstring class_name;
+  bool budget_exhausted = false;
+};
+
+// The kind of tab container a node of `class_name` is, for the classes
+// `FindTabContainerInRegion` and the fullscreen fallback look for.
+inline TabContainerKind GetTabContainerKind(std::wstring_view class_name) {
+  if (class_name == L"VerticalUnpinnedTabContainerView") {
+    return TabContainerKind::kVertical;
+  }
+  if (class_name == L"UnpinnedTabContainerView") {
+    return TabContainerKind::kUnified;
+  }
+  return TabContainerKind::kHorizontal;
+}
+
+// Breadth-first search for the first descendant whose class name is in
+// `target_class_names`, restricted to the browser chrome.
+
+// `FindFirst(TreeScope_Subtree)` from the window root is pre-order, and the
+// web-content branch precedes the tab strip there (`BrowserView` children in
+// order: `TopContainerView`, the content `View ▸ MultiContentsView ▸
+// Document`, and only then `HorizontalTabStripRegionView`. Every such search
+// walked the entire renderer accessibility tree, and the first touch of web
+// content makes Chromium turn on `AXMode::kWebContents` for the rest of the
+// session, after which the renderer maintains a full accessibility tree for
+// every page (ui/accessibility/platform/ax_platform.h,
+// `OnPropertiesUsedInWebContent`). That combination was the DOM-heavy-page
+// click/resize/scroll lag of issue #270.
+
+// BFS reaches the tab strip region at its shallow depth after a couple dozen
+// class reads without entering sibling subtrees, and web content stays
+// structurally unreachable: the walk never descends into an element hosting
+// its own HWND (`Intermediate D3D Window`, the WebContents host
+// `Chrome_WidgetWin_1`, `Chrome_RenderWidgetHostHWND`) nor into the known
+// content-branch views, and `max_visited`/depth budgets bound the walk even
+// if a future Chrome reshuffles the tree.
+template <UiaTree Tree>
+ShallowSearchResult<typename Tree::Node> FindShallowDescendantByClasses(
+    const Tree& tree,
+    const typename Tree::Node& anchor,
+    std::initializer_list<std::wstring_view> target_class_names,
+    int max_visited) {
+  using Node = typename Tree::Node;
+  if (!anchor) {
+    return {};
+  }
+
+  constexpr int kMaxDepth = 12;
+
+  struct QueuedNode {
+    Node node;
+    int depth;
+  };
+  std::vector<QueuedNode> queue;
+  size_t next_index = 0;
+
+  auto enqueue_children = [&](const Node& parent, int depth) {
+    for (Node child = tree.FirstChild(parent); child;
+         child = tree.NextSibling(child)) {
+      queue.push_back({child, depth});
+    }
+  };
+
+  enqueue_children(anchor, 1);
+
+  int visited = 0;
+  while (next_index < queue.size()) {
+    // Moved (not referenced) out of the queue: enqueue_children() below can
+    // reallocate `queue`, which would invalidate a reference into it.
+    const QueuedNode current = std::move(queue[next_index]);
+    ++next_index;
+    if (++visited > max_visited) {
+      ShallowSearchResult<Node> exhausted;
+      exhausted.budget_exhausted = true;
+      return exhausted;
+    }
+
+    auto class_name = tree.ClassName(current.node);
+    if (!class_name) {
+      continue;
+    }
+    if (std::ranges::contains(target_class_names,
+                              std::wstring_view(*class_name))) {
+      return {current.node, std::move(*class_name)};
+    }
+
+    if (current.depth >= kMaxDepth) {
+      continue;
+    }
+    if (std::ranges::contains(
+            std::initializer_list<std::wstring_view>{
+                L"MultiContentsView", L"WebView", L"ContentsWebView"},
+            std::wstring_view(*class_name)) ||
+        tree.HostsWindow(current.node)) {
+      continue;
+    }
+    enqueue_children(current.node, current.depth + 1);
+  }
+
+  return {};
+}
+
+// The nearest sibling of `node` with `class_name`, looking forward first.
+template <UiaTree Tree>
+typename Tree::Node FindSiblingByClass(const Tree& tree,
+                                       const typename Tree::Node& node,
+                                       std::wstring_view class_name) {
+  using Node = typename Tree::Node;
+  if (!node) {
+    return {};
+  }
+
+  for (const bool forward : {true, false}) {
+    auto step = [&](const Node& from) {
+      return forward ? tree.NextSibling(from) : tree.PreviousSibling(from);
+    };
+    for (Node current = step(node); current; current = step(current)) {
+      if (tree.ClassName(current) == class_name) {
+        return current;
+      }
+    }
+  }
+  return {};
+}
+
+// Resolves the tab container inside an already validated tab strip region.
+// The region subtree is content-free, so scoped `FindFirst` is safe here. Trust
+// is anchored on the region itself: popup windows expose no
+// `HorizontalTabStripRegionView`/`VerticalTabStripRegionView`, so tab-like
+// nodes elsewhere can never be misclassified as a tab strip.
+template <UiaTree Tree>
+std::optional<BasicTabContainer<typename Tree::Node>> FindTabContainerInRegion(
+    const Tree& tree,
+    const typename Tree::Node& region,
+    bool vertical) {
+  if (vertical) {
+    if (auto container =
+            tree.FindFirst(region, L"VerticalUnpinnedTabContainerView")) {
+      return {{std::move(container), TabContainerKind::kVertical}};
+    }
+    // Chrome 152 vertical strip (unified TabCollectionNode system): the
+    // region name is unchanged but the subtree is `TabStripView ▸ ScrollView
+    // ▸ Viewport ▸ UnpinnedTabContainerView ▸ TabView`. Anchoring on the
+    // unpinned container mirrors the pre-152 behavior (pinned tabs live in a
+    // sibling `PinnedTabContainerView` and stay out of hit-testing/counts).
+    // The scoped `FindFirst` also matters functionally: Chromium materializes
+    // this subtree lazily, and tree-walker navigation below `TabStripView`
+    // returns no children until a scoped Find query has touched it.
+    if (auto container = tree.FindFirst(region, L"UnpinnedTabContainerView")) {
+      return {{std::move(container), TabContainerKind::kUnified}};
+    }
+    return std::nullopt;
+  }
+
+  if (const auto tab_strip =
+          tree.FindFirst(region, L"TabStrip::TabDragContextImpl")) {
+    if (auto container =
+            FindSiblingByClass(tree, tab_strip, L"TabContainerImpl")) {
+      return {{std::move(container), TabContainerKind::kHorizontal}};
+    }
+  }
+
+  if (auto container = tree.FindFirst(region, L"TabContainerImpl")) {
+    return {{std::move(container), TabContainerKind::kHorizontal}};
+  }
+  return std::nullopt;
+}
+
+#endif  // CHROME_PLUS_SRC_UIATREE_H_
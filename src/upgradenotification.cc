@@ -8,9 +8,8 @@
 #include <mutex>
 #include <string>
 
-#include "detours.h"
-
 #include "config.h"
+#include "hookregistry.h"
 #include "utils.h"
 
 namespace {
@@ -167,20 +166,11 @@ LSTATUS APIENTRY MyRegOpenKeyExW(HKEY hKey,
 }  // namespace
 
 void SuppressFalseUpgradeNotification() {
-  if (!config.IsSuppressFalseUpgradeNotification()) {
-    return;
-  }
-
-  DetourTransactionBegin();
-  DetourUpdateThread(GetCurrentThread());
-  DetourAttach(reinterpret_cast<LPVOID*>(&RawRegOpenKeyExW),
-               reinterpret_cast<void*>(MyRegOpenKeyExW));
-  DetourAttach(reinterpret_cast<LPVOID*>(&RawRegQueryValueExW),
-               reinterpret_cast<void*>(MyRegQueryValueExW));
-  auto status = DetourTransactionCommit();
-  if (status != NO_ERROR) {
-    DebugLog(L"SuppressFalseUpgradeNotification hooks failed: {}", status);
-  } else {
-    DebugLog(L"SuppressFalseUpgradeNotification: hooks installed");
-  }
+  HookRegistry::Instance().Register(
+      L"SuppressFalseUpgradeNotification",
+      {{L"RegOpenKeyExW", reinterpret_cast<void**>(&RawRegOpenKeyExW),
+        reinterpret_cast<void*>(MyRegOpenKeyExW)},
+       {L"RegQueryValueExW", reinterpret_cast<void**>(&RawRegQueryValueExW),
+        reinterpret_cast<void*>(MyRegQueryValueExW)}},
+      [] { return config.IsSuppressFalseUpgradeNotification(); });
 }
@@ -2,24 +2,31 @@
 
 #include <windows.h>
 
+#include <sddl.h>
 #include <shellapi.h>
 #include <shlwapi.h>
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cctype>
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
 #include <cwctype>
 #include <functional>
+#include <mutex>
 #include <optional>
 #include <ranges>
 #include <span>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#include "inifile.h"
+#include "inputbatch.h"
+
 // Global variable definitions
 HMODULE hInstance = nullptr;
 
@@ -81,35 +88,6 @@ std::vector<std::string> StringSplit(std::string_view str,
   return result;
 }
 
-// Compression html.
-std::string& ltrim(std::string& s) {
-  auto it = std::ranges::find_if_not(
-      s, [](unsigned char c) { return std::isspace(c); });
-  s.erase(s.begin(), it);
-  return s;
-}
-
-std::string& rtrim(std::string& s) {
-  auto reversed_view = s | std::views::reverse;
-  auto it = std::ranges::find_if_not(
-      reversed_view, [](unsigned char c) { return std::isspace(c); });
-  s.erase(it.base(), s.end());
-  return s;
-}
-
-std::string& trim(std::string& s) {
-  return ltrim(rtrim(s));
-}
-
-void compression_html(std::string& html) {
-  auto lines = StringSplit(html, '\n');
-  html.clear();
-  for (auto& line : lines) {
-    html += "\n";
-    html += trim(line);
-  }
-}
-
 bool ReplaceStringInPlace(std::string& subject,
                           std::string_view search,
                           std::string_view replace) {
@@ -161,6 +139,19 @@ std::wstring JoinArgsString(const std::vector<std::wstring>& lines,
          std::views::join_with(delimiter) | std::ranges::to<std::wstring>();
 }
 
+std::string WideToUtf8(std::wstring_view str) {
+  if (str.empty()) {
+    return {};
+  }
+  const int length = static_cast<int>(str.size());
+  const int size = ::WideCharToMultiByte(CP_UTF8, 0, str.data(), length,
+                                         nullptr, 0, nullptr, nullptr);
+  std::string result(size, '\0');
+  ::WideCharToMultiByte(CP_UTF8, 0, str.data(), length, result.data(), size,
+                        nullptr, nullptr);
+  return result;
+}
+
 // Search memory.
 std::span<uint8_t> SearchMemory(std::span<uint8_t> src,
                                 std::span<const uint8_t> sub) {
@@ -175,23 +166,105 @@ std::span<uint8_t> SearchMemory(std::span<uint8_t> src,
   return {};
 }
 
+namespace {
+
+std::atomic<size_t> ini_reads{0};
+
+// chrome++.ini is a few kilobytes; one read into memory is cheaper than a
+// mapping, and keeps clear of the `CreateFileMappingW`/`MapViewOfFile` hooks
+// pakpatch.cc installs.
+constexpr LONGLONG kMaxIniFileSize = 16 * 1024 * 1024;
+
+// std::nullopt when the file cannot be read; a missing file reads as empty.
+std::optional<IniFile> LoadIniFile() {
+  ini_reads.fetch_add(1, std::memory_order_relaxed);
+  HANDLE file = ::CreateFileW(
+      GetIniPath().c_str(), GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    if (::GetLastError() == ERROR_FILE_NOT_FOUND) {
+      return IniFile();
+    }
+    return std::nullopt;
+  }
+
+  std::optional<IniFile> ini;
+  LARGE_INTEGER size;
+  if (::GetFileSizeEx(file, &size) && size.QuadPart >= 0 &&
+      size.QuadPart <= kMaxIniFileSize) {
+    std::vector<uint8_t> bytes(static_cast<size_t>(size.QuadPart));
+    DWORD bytes_read = 0;
+    if (::ReadFile(file, bytes.data(), static_cast<DWORD>(bytes.size()),
+                   &bytes_read, nullptr)) {
+      ini = IniFile::Parse(std::span(bytes).first(bytes_read));
+    }
+  }
+  ::CloseHandle(file);
+  return ini;
+}
+
+// Read and indexed on the first lookup, and again by each `ReloadIniFile`.
+// Lookups copy what they return, so the lock covers only the probe.
+std::mutex ini_file_mutex;
+std::optional<IniFile> ini_file;
+
+template <typename Lookup>
+auto WithIniFile(Lookup lookup) {
+  std::lock_guard<std::mutex> lock(ini_file_mutex);
+  if (!ini_file) {
+    ini_file = LoadIniFile().value_or(IniFile());
+  }
+  return lookup(*ini_file);
+}
+
+}  // namespace
+
 std::wstring GetIniString(std::wstring_view section,
                           std::wstring_view key,
                           std::wstring_view default_value) {
-  std::vector<TCHAR> buffer(100);
-  DWORD bytesread = 0;
-  do {
-    bytesread = ::GetPrivateProfileStringW(
-        section.data(), key.data(), default_value.data(), buffer.data(),
-        static_cast<DWORD>(buffer.size()), GetIniPath().c_str());
-    if (bytesread >= buffer.size() - 1) {
-      buffer.resize(buffer.size() * 2);
-    } else {
-      break;
+  return WithIniFile([&](const IniFile& ini) {
+    return std::wstring(ini.GetString(section, key).value_or(default_value));
+  });
+}
+
+int GetIniInt(std::wstring_view section,
+              std::wstring_view key,
+              int default_value) {
+  return WithIniFile([&](const IniFile& ini) {
+    return ini.GetInt(section, key).value_or(default_value);
+  });
+}
+
+std::vector<std::pair<std::wstring, std::wstring>> GetIniSection(
+    std::wstring_view section) {
+  return WithIniFile([&](const IniFile& ini) {
+    std::vector<std::pair<std::wstring, std::wstring>> pairs;
+    for (const auto& [key, value] : ini.GetSection(section)) {
+      if (!value.empty()) {
+        pairs.emplace_back(key, value);
+      }
     }
-  } while (true);
+    return pairs;
+  });
+}
 
-  return std::wstring(buffer.data());
+void ReadIniFile(const std::function<void(const IniFile&)>& read) {
+  WithIniFile(read);
+}
+
+bool ReloadIniFile() {
+  std::optional<IniFile> ini = LoadIniFile();
+  if (!ini) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(ini_file_mutex);
+  ini_file = std::move(ini);
+  return true;
+}
+
+size_t GetIniReadCount() {
+  return ini_reads.load(std::memory_order_relaxed);
 }
 
 std::wstring CanonicalizePath(const std::wstring& path) {
@@ -218,6 +291,36 @@ std::wstring ExpandEnvironmentPath(const std::wstring& path) {
   return std::wstring(&buffer[0], 0, ExpandedLength);
 }
 
+bool IsBrowserProcess() {
+  return !wcsstr(::GetCommandLineW(), L"-type=");
+}
+
+// Read-only for everyone but the creator is load-bearing: published bytes
+// feed privileged pages such as the settings WebUI in every renderer, so a
+// writable section would be an injection vector into `chrome://settings`.
+// The DACL grants read to Everyone and to RestrictedCode (the renderer's
+// restricting SID), so a renderer's pre-lockdown token can still open the
+// section while it starts up.
+HANDLE CreatePublishedSection(const std::wstring& name, DWORD size) {
+  SECURITY_ATTRIBUTES sa{sizeof(sa), nullptr, FALSE};
+  if (!::ConvertStringSecurityDescriptorToSecurityDescriptorW(
+          L"D:(A;;GR;;;WD)(A;;GR;;;RC)", SDDL_REVISION_1,
+          &sa.lpSecurityDescriptor, nullptr)) {
+    return nullptr;
+  }
+  HANDLE section = ::CreateFileMappingW(INVALID_HANDLE_VALUE, &sa,
+                                        PAGE_READWRITE, 0, size, name.c_str());
+  const DWORD create_error = ::GetLastError();
+  ::LocalFree(sa.lpSecurityDescriptor);
+  // A pre-existing name means another process squatted it; children must
+  // not be pointed at contents we did not write.
+  if (section && create_error == ERROR_ALREADY_EXISTS) {
+    ::CloseHandle(section);
+    return nullptr;
+  }
+  return section;
+}
+
 HWND GetTopWnd(HWND hwnd) {
   while (::GetParent(hwnd) && ::IsWindowVisible(::GetParent(hwnd))) {
     hwnd = ::GetParent(hwnd);
@@ -389,6 +492,51 @@ std::optional<UINT> ParseCharacterKey(std::wstring_view key) {
 
 }  // namespace
 
+UINT SendInputBatch(const InputBatch& batch) {
+  if (batch.overflowed() || batch.empty()) {
+    return 0;
+  }
+  const bool swapped = ::GetSystemMetrics(SM_SWAPBUTTON) == TRUE;
+  std::array<INPUT, InputBatch::kCapacity> inputs = {};
+  const auto events = batch.events();
+  for (size_t i = 0; i < events.size(); ++i) {
+    const InputEvent& event = events[i];
+    INPUT& input = inputs[i];
+    // The primary and secondary buttons follow the user's swap setting.
+    DWORD mouse_down = 0;
+    DWORD mouse_up = 0;
+    switch (event.vk) {
+      case VK_LBUTTON:
+        mouse_down = swapped ? MOUSEEVENTF_RIGHTDOWN : MOUSEEVENTF_LEFTDOWN;
+        mouse_up = swapped ? MOUSEEVENTF_RIGHTUP : MOUSEEVENTF_LEFTUP;
+        break;
+      case VK_RBUTTON:
+        mouse_down = swapped ? MOUSEEVENTF_LEFTDOWN : MOUSEEVENTF_RIGHTDOWN;
+        mouse_up = swapped ? MOUSEEVENTF_LEFTUP : MOUSEEVENTF_RIGHTUP;
+        break;
+      case VK_MBUTTON:
+        mouse_down = MOUSEEVENTF_MIDDLEDOWN;
+        mouse_up = MOUSEEVENTF_MIDDLEUP;
+        break;
+      default:
+        break;
+    }
+    if (mouse_down) {
+      input.type = INPUT_MOUSE;
+      input.mi.dwFlags = event.key_up ? mouse_up : mouse_down;
+      input.mi.dwExtraInfo = GetMagicCode();
+    } else {
+      input.type = INPUT_KEYBOARD;
+      input.ki.wVk = event.vk;
+      input.ki.dwFlags = (event.extended ? KEYEVENTF_EXTENDEDKEY : 0) |
+                         (event.key_up ? KEYEVENTF_KEYUP : 0);
+      input.ki.dwExtraInfo = GetMagicCode();
+    }
+  }
+  return ::SendInput(static_cast<UINT>(events.size()), inputs.data(),
+                     sizeof(INPUT));
+}
+
 UINT ParseHotkeys(std::wstring_view keys, bool no_repeat) {
   UINT modifiers = 0;
   UINT virtual_key = 0;
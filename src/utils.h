@@ -3,12 +3,20 @@
 
 #include <windows.h>
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <span>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#include "hash.h"
+#include "inputbatch.h"
+
+class IniFile;
+
 // Global variable declaration
 extern HMODULE hInstance;
 
@@ -51,9 +59,6 @@ std::vector<std::string> StringSplit(std::string_view str,
                                      const char delim,
                                      std::string_view enclosure = "");
 
-// HTML compression functions
-void compression_html(std::string& html);
-
 bool ReplaceStringInPlace(std::string& subject,
                           std::string_view search,
                           std::string_view replace);
@@ -67,14 +72,35 @@ std::wstring QuoteSpaceIfNeeded(const std::wstring& str);
 std::wstring JoinArgsString(const std::vector<std::wstring>& lines,
                             std::wstring_view delimiter);
 
+// UTF-16 to UTF-8, for comparing INI text against pak resources.
+std::string WideToUtf8(std::wstring_view str);
+
 // Memory and module search functions
 std::span<uint8_t> SearchMemory(std::span<uint8_t> src,
                                 std::span<const uint8_t> sub);
 
-// Parse the INI file
+// Parse the INI file. chrome++.ini is read and indexed once, on the first of
+// these calls (see inifile.h); each lookup after that is a hash probe.
 std::wstring GetIniString(std::wstring_view section,
                           std::wstring_view key,
                           std::wstring_view default_value);
+int GetIniInt(std::wstring_view section,
+              std::wstring_view key,
+              int default_value);
+// Every `key=value` line of `section` with a non-empty value, in file order,
+// both sides trimmed and quotes kept.
+std::vector<std::pair<std::wstring, std::wstring>> GetIniSection(
+    std::wstring_view section);
+// Calls `read` with chrome++.ini as loaded now, holding off `ReloadIniFile`
+// meanwhile, so that several settings come from one version of the file.
+void ReadIniFile(const std::function<void(const IniFile&)>& read);
+
+// Rereads chrome++.ini so later lookups see the new contents; false, keeping
+// the old contents, when the file cannot be read (say, an editor holds it).
+bool ReloadIniFile();
+
+// Times this process has read chrome++.ini from disk.
+size_t GetIniReadCount();
 
 // Canonicalize the path
 std::wstring CanonicalizePath(const std::wstring& path);
@@ -85,6 +111,15 @@ std::wstring GetAbsolutePath(const std::wstring& path);
 // Expand environment variables in the path
 std::wstring ExpandEnvironmentPath(const std::wstring& path);
 
+// Chrome's child processes all carry a `--type=` switch; the browser has none.
+bool IsBrowserProcess();
+
+// Creates the named, pagefile-backed section `name` of `size` bytes for the
+// browser to fill and its child processes to open read-only; see the DACL
+// note in utils.cc. Returns nullptr when creation fails or the name already
+// exists.
+HANDLE CreatePublishedSection(const std::wstring& name, DWORD size);
+
 // Debug log function
 #if defined(_DEBUG)
 #include <filesystem>
@@ -118,79 +153,19 @@ void LaunchCommands(const std::wstring& get_commands);
 [[nodiscard]] bool IsChromeWindow(HWND hwnd);
 
 // Keyboard and mouse input functions
-// Template function for sending combined key operations - kept in header
+// Sends every event of `batch` with one `SendInput`, tagged with
+// `GetMagicCode()`; an overflowed batch is dropped whole. Returns the number
+// of events sent.
+UINT SendInputBatch(const InputBatch& batch);
+
+// Presses `keys` in order, then releases them in the same order, as one
+// batch.
 template <typename... T>
 void SendKey(T&&... keys) {
-  std::vector<typename std::common_type<T...>::type> keys_ = {
-      std::forward<T>(keys)...};
-  std::vector<INPUT> inputs{};
-  inputs.reserve(keys_.size() * 2);
-  for (auto& key : keys_) {
-    INPUT input = {0};
-    // Adjust mouse messages
-    switch (key) {
-      case VK_RBUTTON:
-        input.type = INPUT_MOUSE;
-        input.mi.dwFlags = GetSystemMetrics(SM_SWAPBUTTON) == TRUE
-                               ? MOUSEEVENTF_LEFTDOWN
-                               : MOUSEEVENTF_RIGHTDOWN;
-        input.mi.dwExtraInfo = GetMagicCode();
-        break;
-      case VK_LBUTTON:
-        input.type = INPUT_MOUSE;
-        input.mi.dwFlags = GetSystemMetrics(SM_SWAPBUTTON) == TRUE
-                               ? MOUSEEVENTF_RIGHTDOWN
-                               : MOUSEEVENTF_LEFTDOWN;
-        input.mi.dwExtraInfo = GetMagicCode();
-        break;
-      case VK_MBUTTON:
-        input.type = INPUT_MOUSE;
-        input.mi.dwFlags = MOUSEEVENTF_MIDDLEDOWN;
-        input.mi.dwExtraInfo = GetMagicCode();
-        break;
-      default:
-        input.type = INPUT_KEYBOARD;
-        input.ki.wVk = (WORD)key;
-        input.ki.dwFlags = KEYEVENTF_EXTENDEDKEY;
-        input.ki.dwExtraInfo = GetMagicCode();
-        break;
-    }
-    inputs.emplace_back(std::move(input));
-  }
-  for (auto& key : keys_) {
-    INPUT input = {0};
-    // Adjust mouse messages
-    switch (key) {
-      case VK_RBUTTON:
-        input.type = INPUT_MOUSE;
-        input.mi.dwFlags = GetSystemMetrics(SM_SWAPBUTTON) == TRUE
-                               ? MOUSEEVENTF_LEFTUP
-                               : MOUSEEVENTF_RIGHTUP;
-        input.mi.dwExtraInfo = GetMagicCode();
-        break;
-      case VK_LBUTTON:
-        input.type = INPUT_MOUSE;
-        input.mi.dwFlags = GetSystemMetrics(SM_SWAPBUTTON) == TRUE
-                               ? MOUSEEVENTF_RIGHTUP
-                               : MOUSEEVENTF_LEFTUP;
-        input.mi.dwExtraInfo = GetMagicCode();
-        break;
-      case VK_MBUTTON:
-        input.type = INPUT_MOUSE;
-        input.mi.dwFlags = MOUSEEVENTF_MIDDLEUP;
-        input.mi.dwExtraInfo = GetMagicCode();
-        break;
-      default:
-        input.type = INPUT_KEYBOARD;
-        input.ki.dwFlags = KEYEVENTF_KEYUP;
-        input.ki.wVk = (WORD)key;
-        input.ki.dwFlags = KEYEVENTF_EXTENDEDKEY | KEYEVENTF_KEYUP;
-        input.ki.dwExtraInfo = GetMagicCode();
-        break;
-    }
-    inputs.emplace_back(std::move(input));
-  }
-  SendInput(static_cast<UINT>(inputs.size()), inputs.data(), sizeof(INPUT));
+  InputBatch batch;
+  (batch.AddKey(static_cast<uint16_t>(keys), false), ...);
+  (batch.AddKey(static_cast<uint16_t>(keys), true), ...);
+  SendInputBatch(batch);
 }
 
 // Parse hotkey string like "Ctrl+Shift+A" into MAKELPARAM(modifiers, vk)
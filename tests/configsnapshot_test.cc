@@ -0,0 +1,131 @@
+#include "configsnapshot.h"
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "testing.h"
+
+namespace {
+
+// Offsets into a serialized snapshot: a 16-byte header (magic, version,
+// size, record count), then 16-byte records (tag, offset, size, reserved)
+// in the order `SerializeConfigSnapshot` adds them: target ids, blob name,
+// patch rules.
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kRecordSize = 16;
+constexpr size_t kRulesRecord = 2;
+
+ConfigSnapshotData MakeData() {
+  ConfigSnapshotData data;
+  data.pak_target_ids = {13, 7, 65535};
+  data.pak_blob_name = u"Local\\ChromePlusPak_1234";
+  data.pak_patch_rules = {{u"settings@45", u"</x>|a|b"},
+                          {u"empty", u""},
+                          {u"", u"no key"},
+                          {u"ünïcode", u"✓|\\||x"}};
+  return data;
+}
+
+uint32_t Read32(const std::vector<uint8_t>& bytes, size_t offset) {
+  uint32_t value = 0;
+  memcpy(&value, bytes.data() + offset, sizeof(value));
+  return value;
+}
+
+void Write32(std::vector<uint8_t>& bytes, size_t offset, uint32_t value) {
+  memcpy(bytes.data() + offset, &value, sizeof(value));
+}
+
+size_t RecordField(size_t record, size_t field) {
+  return kHeaderSize + record * kRecordSize + field * sizeof(uint32_t);
+}
+
+}  // namespace
+
+TEST(ConfigSnapshot, RoundTrips) {
+  const ConfigSnapshotData data = MakeData();
+  const auto bytes = SerializeConfigSnapshot(data);
+  const auto snapshot = ConfigSnapshot::Parse(bytes);
+  ASSERT_TRUE(snapshot);
+  EXPECT_TRUE(std::vector<uint16_t>(snapshot->pak_target_ids().begin(),
+                                    snapshot->pak_target_ids().end()) ==
+              data.pak_target_ids);
+  EXPECT_TRUE(snapshot->pak_blob_name() == data.pak_blob_name);
+  ASSERT_EQ(snapshot->pak_patch_rule_count(), data.pak_patch_rules.size());
+  for (size_t i = 0; i < data.pak_patch_rules.size(); ++i) {
+    const auto [key, value] = snapshot->pak_patch_rule(i);
+    EXPECT_TRUE(key == data.pak_patch_rules[i].first);
+    EXPECT_TRUE(value == data.pak_patch_rules[i].second);
+  }
+  // The accessors read straight out of the bytes.
+  EXPECT_TRUE(reinterpret_cast<const uint8_t*>(
+                  snapshot->pak_target_ids().data()) > bytes.data());
+}
+
+TEST(ConfigSnapshot, RoundTripsAnEmptySnapshot) {
+  const auto bytes = SerializeConfigSnapshot({});
+  const auto snapshot = ConfigSnapshot::Parse(bytes);
+  ASSERT_TRUE(snapshot);
+  EXPECT_TRUE(snapshot->pak_target_ids().empty());
+  EXPECT_TRUE(snapshot->pak_blob_name().empty());
+  EXPECT_EQ(snapshot->pak_patch_rule_count(), 0u);
+}
+
+// A record from a newer build is skipped, and bytes past the snapshot's
+// size, such as the rest of a section's page, are ignored.
+TEST(ConfigSnapshot, SkipsUnknownRecordsAndTrailingBytes) {
+  auto bytes = SerializeConfigSnapshot(MakeData());
+  Write32(bytes, RecordField(0, 0), 99);
+  bytes.resize(bytes.size() + 4096, 0xCC);
+  const auto snapshot = ConfigSnapshot::Parse(bytes);
+  ASSERT_TRUE(snapshot);
+  EXPECT_TRUE(snapshot->pak_target_ids().empty());
+  EXPECT_TRUE(snapshot->pak_blob_name() == MakeData().pak_blob_name);
+  EXPECT_EQ(snapshot->pak_patch_rule_count(), 4u);
+}
+
+TEST(ConfigSnapshot, RejectsMalformedSnapshots) {
+  const auto good = SerializeConfigSnapshot(MakeData());
+  ASSERT_TRUE(ConfigSnapshot::Parse(good));
+  auto reject = [&](auto&& corrupt) {
+    auto bytes = good;
+    corrupt(bytes);
+    return !ConfigSnapshot::Parse(bytes);
+  };
+
+  EXPECT_TRUE(reject([](auto& b) { b.resize(kHeaderSize - 1); }));
+  EXPECT_TRUE(reject([](auto& b) { b[0] ^= 1; }));
+  EXPECT_TRUE(reject([](auto& b) { Write32(b, 4, 2); }));
+  // Shorter than its header claims.
+  EXPECT_TRUE(reject([](auto& b) { b.pop_back(); }));
+  // More records than fit.
+  EXPECT_TRUE(reject([](auto& b) { Write32(b, 12, 1000); }));
+  // A payload that is misaligned, starts past the end or runs over it.
+  EXPECT_TRUE(reject([](auto& b) {
+    Write32(b, RecordField(0, 1), Read32(b, RecordField(0, 1)) + 2);
+  }));
+  EXPECT_TRUE(reject([](auto& b) {
+    Write32(b, RecordField(0, 1), static_cast<uint32_t>(b.size() + 8));
+  }));
+  EXPECT_TRUE(reject([](auto& b) {
+    Write32(b, RecordField(1, 2), static_cast<uint32_t>(b.size()));
+  }));
+  // Target ids that are not a whole number of uint16_t.
+  EXPECT_TRUE(reject([](auto& b) {
+    Write32(b, RecordField(0, 2), Read32(b, RecordField(0, 2)) - 1);
+  }));
+  // More rules than the payload holds, and a rule pointing past the text.
+  const size_t rules = Read32(good, RecordField(kRulesRecord, 1));
+  EXPECT_TRUE(reject([&](auto& b) { Write32(b, rules, 100000); }));
+  EXPECT_TRUE(reject([&](auto& b) { Write32(b, rules + 8 + 4, 100000); }));
+  EXPECT_TRUE(reject([&](auto& b) { Write32(b, rules + 8 + 12, 100000); }));
+
+  // The view needs 8-byte alignment to read the records in place.
+  std::vector<uint64_t> storage(good.size() / 8 + 2);
+  auto* shifted = reinterpret_cast<uint8_t*>(storage.data()) + 4;
+  memcpy(shifted, good.data(), good.size());
+  EXPECT_FALSE(ConfigSnapshot::Parse(std::span(shifted, good.size())));
+}
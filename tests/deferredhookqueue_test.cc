@@ -0,0 +1,60 @@
+#include "deferredhookqueue.h"
+
+#include <cstddef>
+#include <vector>
+
+#include "testing.h"
+
+TEST(DeferredHookQueue, ReleasesTheHooksOfALoadedModule) {
+  DeferredHookQueue queue;
+  EXPECT_TRUE(queue.empty());
+  queue.Add(3, L"netapi32.dll");
+  queue.Add(5, L"shlwapi.dll");
+  queue.Add(1, L"netapi32.dll");
+  EXPECT_FALSE(queue.empty());
+
+  // Unrelated modules, including one that only shares a prefix, release
+  // nothing.
+  EXPECT_TRUE(queue.Release(L"kernel32.dll").empty());
+  EXPECT_TRUE(queue.Release(L"netapi32.dll.mui").empty());
+
+  EXPECT_EQ(queue.Release(L"netapi32.dll"), (std::vector<size_t>{3, 1}));
+  // A module loads once; a second event for it finds nothing waiting.
+  EXPECT_TRUE(queue.Release(L"netapi32.dll").empty());
+  EXPECT_FALSE(queue.empty());
+  EXPECT_EQ(queue.Release(L"shlwapi.dll"), (std::vector<size_t>{5}));
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(DeferredHookQueue, MatchesModuleNamesIgnoringAsciiCase) {
+  DeferredHookQueue queue;
+  queue.Add(0, L"NetApi32.DLL");
+  queue.Add(1, L"Äx.dll");
+  EXPECT_EQ(queue.Release(L"NETAPI32.dll"), (std::vector<size_t>{0}));
+  // Only ASCII letters fold.
+  EXPECT_TRUE(queue.Release(L"äx.dll").empty());
+  EXPECT_EQ(queue.Release(L"ÄX.DLL"), (std::vector<size_t>{1}));
+}
+
+// The loader's notifications as a stream of module names, with hooks added
+// between them as `Commit` would.
+TEST(DeferredHookQueue, FollowsAStreamOfModuleLoads) {
+  DeferredHookQueue queue;
+  std::vector<size_t> attached;
+  auto load = [&](const wchar_t* module) {
+    for (const size_t hook : queue.Release(module)) {
+      attached.push_back(hook);
+    }
+  };
+  queue.Add(0, L"userenv.dll");
+  load(L"ntdll.dll");
+  load(L"kernelbase.dll");
+  queue.Add(1, L"wtsapi32.dll");
+  queue.Add(2, L"userenv.dll");
+  load(L"USERENV.DLL");
+  load(L"userenv.dll");
+  EXPECT_EQ(attached, (std::vector<size_t>{0, 2}));
+  load(L"wtsapi32.dll");
+  EXPECT_EQ(attached, (std::vector<size_t>{0, 2, 1}));
+  EXPECT_TRUE(queue.empty());
+}
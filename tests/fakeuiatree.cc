@@ -0,0 +1,189 @@
+#include "fakeuiatree.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+// Strips ` [marker]` from the end of `line`; returns whether it was there.
+bool TakeMarker(std::wstring_view& line, std::wstring_view marker) {
+  if (!line.ends_with(marker)) {
+    return false;
+  }
+  line.remove_suffix(marker.size());
+  while (line.ends_with(L' ')) {
+    line.remove_suffix(1);
+  }
+  return true;
+}
+
+}  // namespace
+
+FakeUiaTree::FakeUiaTree(std::wstring_view outline, View view) : view_(view) {
+  // The parent of the next node at each depth.
+  std::vector<FakeUiaNode*> parents;
+  while (!outline.empty()) {
+    const size_t end = std::min(outline.find(L'\n'), outline.size());
+    std::wstring_view line = outline.substr(0, end);
+    outline.remove_prefix(std::min(end + 1, outline.size()));
+
+    const size_t indent = line.find_first_not_of(L' ');
+    if (indent == std::wstring_view::npos) {
+      continue;
+    }
+    line.remove_prefix(indent);
+    auto node = std::make_unique<FakeUiaNode>();
+    // Markers may come in any order.
+    for (bool found = true; found;) {
+      found = false;
+      if (TakeMarker(line, L"[hwnd]")) {
+        node->hosts_window = found = true;
+      }
+      if (TakeMarker(line, L"[raw]")) {
+        node->raw_only = found = true;
+      }
+      if (TakeMarker(line, L"[lazy]")) {
+        node->lazy = found = true;
+      }
+    }
+    node->class_name = line;
+
+    const size_t depth = indent / 2;
+    parents.resize(std::min(parents.size(), depth));
+    if (!parents.empty()) {
+      node->parent = parents.back();
+      node->parent->children.push_back(node.get());
+    }
+    parents.push_back(node.get());
+    nodes_.push_back(std::move(node));
+  }
+}
+
+FakeUiaTree::Node FakeUiaTree::Lookup(std::wstring_view class_name) const {
+  for (const auto& node : nodes_) {
+    if (node->class_name == class_name) {
+      return node.get();
+    }
+  }
+  return nullptr;
+}
+
+void FakeUiaTree::AddChildren(Node parent,
+                              std::wstring_view class_name,
+                              size_t count) {
+  // `parent` is one of `nodes_`; the const handle is what callers hold.
+  auto* owner = const_cast<FakeUiaNode*>(parent);
+  for (size_t i = 0; i < count; ++i) {
+    auto node = std::make_unique<FakeUiaNode>();
+    node->class_name = class_name;
+    node->parent = owner;
+    owner->children.push_back(node.get());
+    nodes_.push_back(std::move(node));
+  }
+}
+
+const std::vector<FakeUiaNode*>* FakeUiaTree::VisibleChildren(
+    Node node) const {
+  if (node->lazy && !std::ranges::contains(touched_lazy_, node)) {
+    return nullptr;
+  }
+  return &node->children;
+}
+
+FakeUiaTree::Node FakeUiaTree::FirstChild(const Node& node) const {
+  ++round_trips_;
+  if (const auto* children = VisibleChildren(node)) {
+    for (const FakeUiaNode* child : *children) {
+      if (InView(child)) {
+        return child;
+      }
+    }
+  }
+  return nullptr;
+}
+
+FakeUiaTree::Node FakeUiaTree::Sibling(const Node& node, int step) const {
+  ++round_trips_;
+  if (!node->parent) {
+    return nullptr;
+  }
+  const auto& siblings = node->parent->children;
+  const auto it = std::ranges::find(siblings, node);
+  for (ptrdiff_t i = (it - siblings.begin()) + step;
+       i >= 0 && i < static_cast<ptrdiff_t>(siblings.size()); i += step) {
+    if (InView(siblings[i])) {
+      return siblings[i];
+    }
+  }
+  return nullptr;
+}
+
+FakeUiaTree::Node FakeUiaTree::NextSibling(const Node& node) const {
+  return Sibling(node, 1);
+}
+
+FakeUiaTree::Node FakeUiaTree::PreviousSibling(const Node& node) const {
+  return Sibling(node, -1);
+}
+
+std::optional<std::wstring> FakeUiaTree::ClassName(const Node& node) const {
+  ++round_trips_;
+  visited_.push_back(node);
+  return node->class_name;
+}
+
+bool FakeUiaTree::HostsWindow(const Node& node) const {
+  ++round_trips_;
+  return node->hosts_window;
+}
+
+FakeUiaTree::Node FakeUiaTree::FindFirst(const Node& root,
+                                         std::wstring_view class_name) const {
+  ++round_trips_;
+  return root ? Search(root, class_name) : nullptr;
+}
+
+// Pre-order below `node`, as `FindFirst(TreeScope_Subtree)` matches; the
+// provider materializes every lazy node it passes.
+FakeUiaTree::Node FakeUiaTree::Search(Node node,
+                                      std::wstring_view class_name) const {
+  if (node->lazy && !std::ranges::contains(touched_lazy_, node)) {
+    touched_lazy_.push_back(node);
+  }
+  for (const FakeUiaNode* child : node->children) {
+    if (!InView(child)) {
+      continue;
+    }
+    ++searched_nodes_;
+    if (child->class_name == class_name) {
+      return child;
+    }
+    if (Node hit = Search(child, class_name)) {
+      return hit;
+    }
+  }
+  return nullptr;
+}
+
+bool FakeUiaTree::VisitedBelow(Node node) const {
+  return std::ranges::any_of(visited_, [node](Node visited) {
+    for (Node ancestor = visited->parent; ancestor;
+         ancestor = ancestor->parent) {
+      if (ancestor == node) {
+        return true;
+      }
+    }
+    return false;
+  });
+}
+
+void FakeUiaTree::ResetCounts() {
+  round_trips_ = 0;
+  visited_.clear();
+  searched_nodes_ = 0;
+}
@@ -0,0 +1,94 @@
+#ifndef CHROME_PLUS_TESTS_FAKEUIATREE_H_
+#define CHROME_PLUS_TESTS_FAKEUIATREE_H_
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "uiatree.h"
+
+struct FakeUiaNode {
+  std::wstring class_name;
+  // Roots its own HWND, as `Chrome_RenderWidgetHostHWND` does.
+  bool hosts_window = false;
+  // Present in the raw view only; the control view hides its whole subtree.
+  bool raw_only = false;
+  // Walker navigation sees no children until a scoped `FindFirst` has
+  // searched through the node, as with Chrome 152's `TabStripView`.
+  bool lazy = false;
+  FakeUiaNode* parent = nullptr;
+  std::vector<FakeUiaNode*> children;
+};
+
+// An in-memory accessibility tree for the algorithms of uiatree.h, parsed
+// from an outline with one class per line, two spaces per level and optional
+// `[hwnd]`, `[raw]` and `[lazy]` markers:
+//
+//   BrowserView
+//     TopContainerView
+//     ContentsWebView
+//       Chrome_RenderWidgetHostHWND [hwnd]
+//
+// Every call of the `UiaTree` interface counts as one round trip, as each is
+// in uia.cc's live view, and every node whose class is read is recorded as
+// visited, in order. `FindFirst` is one round trip however far the provider
+// searches; the nodes it examined are counted apart, as the work it costs
+// Chrome.
+class FakeUiaTree {
+ public:
+  using Node = const FakeUiaNode*;
+
+  enum class View { kControl, kRaw };
+
+  explicit FakeUiaTree(std::wstring_view outline, View view = View::kControl);
+  FakeUiaTree(const FakeUiaTree&) = delete;
+  FakeUiaTree& operator=(const FakeUiaTree&) = delete;
+
+  Node root() const { return nodes_.front().get(); }
+
+  // The first node of `class_name` in pre-order, in either view, without
+  // counting; for setting up and checking tests.
+  Node Lookup(std::wstring_view class_name) const;
+
+  // Appends `count` leaf children of `class_name` to `parent`, to grow a
+  // shape, say a heavy page under its document.
+  void AddChildren(Node parent, std::wstring_view class_name, size_t count);
+
+  // `UiaTree`.
+  Node FirstChild(const Node& node) const;
+  Node NextSibling(const Node& node) const;
+  Node PreviousSibling(const Node& node) const;
+  std::optional<std::wstring> ClassName(const Node& node) const;
+  bool HostsWindow(const Node& node) const;
+  Node FindFirst(const Node& root, std::wstring_view class_name) const;
+
+  size_t round_trips() const { return round_trips_; }
+  const std::vector<Node>& visited() const { return visited_; }
+  size_t searched_nodes() const { return searched_nodes_; }
+  // Whether any visited node lies in the subtree of `node`.
+  bool VisitedBelow(Node node) const;
+  void ResetCounts();
+
+ private:
+  bool InView(Node node) const {
+    return view_ == View::kRaw || !node->raw_only;
+  }
+  // `node`'s children in this view, empty while it is lazy and untouched.
+  const std::vector<FakeUiaNode*>* VisibleChildren(Node node) const;
+  Node Sibling(const Node& node, int step) const;
+  Node Search(Node node, std::wstring_view class_name) const;
+
+  std::vector<std::unique_ptr<FakeUiaNode>> nodes_;
+  View view_;
+  mutable std::vector<Node> touched_lazy_;
+  mutable size_t round_trips_ = 0;
+  mutable std::vector<Node> visited_;
+  mutable size_t searched_nodes_ = 0;
+};
+
+static_assert(UiaTree<FakeUiaTree>);
+
+#endif  // CHROME_PLUS_TESTS_FAKEUIATREE_H_
@@ -0,0 +1,34 @@
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "fastinflate.h"
+#include "paktestutil.h"
+#include "testing.h"
+
+#define MINIZ_HEADER_FILE_ONLY
+#include "miniz.c"
+
+// Whole-stream inflate throughput of `FastInflate` against miniz's `tinfl`
+// (the default build's decoder) on 4 MB of WebUI-like text at the levels the
+// pak and the write-back use.
+BENCHMARK(FastInflate, ThroughputVsTinfl) {
+  const std::string text = MakeWebUiText(4 * 1024 * 1024, 3);
+  std::vector<uint8_t> out(text.size());
+  for (const int level : {1, 6, 9}) {
+    const auto stream = DeflateRaw(AsBytes(text), level);
+    std::printf("level %d: %zu -> %zu bytes\n", level, text.size(),
+                stream.size());
+    const double megabytes = static_cast<double>(text.size()) / 1e6;
+    const double fast = testing::Measure("FastInflate", 20, [&] {
+      testing::KeepAlive(FastInflate(stream, out));
+    });
+    const double tinfl = testing::Measure("tinfl", 20, [&] {
+      testing::KeepAlive(tinfl_decompress_mem_to_mem(
+          out.data(), out.size(), stream.data(), stream.size(), 0));
+    });
+    std::printf("  %.0f vs %.0f MB/s\n", megabytes / fast * 1e6,
+                megabytes / tinfl * 1e6);
+  }
+}
@@ -0,0 +1,147 @@
+#include "fastinflate.h"
+
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "paktestutil.h"
+#include "testing.h"
+
+namespace {
+
+// Inputs shaped to reach every decoder path: WebUI-like text (the pak's
+// content), incompressible bytes (stored blocks), a skewed small alphabet
+// (short literal codes, so many literal pairs), and short-period repeats
+// (overlapping match copies at distances 1 to 15).
+std::vector<std::vector<uint8_t>> MakeInputs(uint32_t seed) {
+  std::mt19937 random(seed);
+  std::vector<std::vector<uint8_t>> inputs;
+
+  const std::string text = MakeWebUiText(96 * 1024 + seed * 517, seed);
+  inputs.emplace_back(text.begin(), text.end());
+
+  std::vector<uint8_t> noise(20000 + seed * 31);
+  for (auto& byte : noise) {
+    byte = static_cast<uint8_t>(random());
+  }
+  inputs.push_back(std::move(noise));
+
+  std::vector<uint8_t> skewed(60000);
+  for (auto& byte : skewed) {
+    const uint32_t r = random() % 64;
+    byte = static_cast<uint8_t>('a' + (r < 32 ? 0 : r < 48 ? 1 : r % 8));
+  }
+  inputs.push_back(std::move(skewed));
+
+  std::vector<uint8_t> repeats;
+  while (repeats.size() < 50000) {
+    const size_t period = 1 + random() % 15;
+    const size_t count = period + random() % 300;
+    const size_t start = repeats.size();
+    for (size_t i = 0; i < period; ++i) {
+      repeats.push_back(static_cast<uint8_t>(random()));
+    }
+    for (size_t i = period; i < count; ++i) {
+      repeats.push_back(repeats[start + i - period]);
+    }
+  }
+  inputs.push_back(std::move(repeats));
+
+  inputs.emplace_back();  // Empty.
+  return inputs;
+}
+
+std::optional<std::vector<uint8_t>> Inflate(std::span<const uint8_t> stream,
+                                            size_t size) {
+  std::vector<uint8_t> out(size);
+  const auto produced = FastInflate(stream, out);
+  if (!produced) {
+    return std::nullopt;
+  }
+  out.resize(*produced);
+  return out;
+}
+
+}  // namespace
+
+// Every level and strategy miniz offers, on every input shape: the stream
+// decodes to the original, as miniz's own decoder has it.
+TEST(FastInflate, MatchesMinizAcrossLevelsAndStrategies) {
+  for (uint32_t seed = 0; seed < 3; ++seed) {
+    for (const auto& input : MakeInputs(seed)) {
+      for (int level = 0; level <= 9; ++level) {
+        for (int strategy = 0; strategy <= 4; ++strategy) {
+          const auto stream = DeflateRaw(input, level, strategy);
+          ASSERT_FALSE(stream.empty());
+          const auto fast = Inflate(stream, input.size());
+          ASSERT_TRUE(fast);
+          EXPECT_TRUE(*fast == input);
+          EXPECT_TRUE(InflateRaw(stream, input.size()) == fast);
+        }
+      }
+    }
+  }
+}
+
+// A stream cut short, or an output buffer a byte too small, fails instead of
+// returning a partial result.
+TEST(FastInflate, RejectsTruncatedStreamsAndShortOutput) {
+  const auto input = MakeInputs(1)[0];
+  const auto stream = DeflateRaw(input, 6);
+  for (size_t cut = 1; cut < stream.size(); cut += stream.size() / 97 + 1) {
+    const auto truncated = std::span(stream).first(stream.size() - cut);
+    EXPECT_FALSE(Inflate(truncated, input.size()));
+  }
+  EXPECT_FALSE(Inflate(stream, input.size() - 1));
+  EXPECT_TRUE(Inflate(stream, input.size() + 64) == input);
+}
+
+// Damaged streams never decode to something miniz would decode differently.
+TEST(FastInflate, AgreesWithMinizOnCorruptStreams) {
+  std::mt19937 random(11);
+  const auto inputs = MakeInputs(2);
+  for (int trial = 0; trial < 600; ++trial) {
+    const auto& input = inputs[trial % 4];
+    auto stream = DeflateRaw(input, 1 + trial % 9);
+    for (int flips = 1 + trial % 3; flips > 0; --flips) {
+      stream[random() % stream.size()] ^= 1 << (random() % 8);
+    }
+    const auto fast = Inflate(stream, input.size());
+    const auto reference = InflateRaw(stream, input.size());
+    if (fast && reference) {
+      EXPECT_TRUE(*fast == *reference);
+    }
+  }
+}
+
+// The observer sees every block start, the first at the stream's start;
+// returning false stops the decode.
+TEST(FastInflate, ReportsBlockStarts) {
+  const std::string text = MakeWebUiText(400 * 1024, 4);
+  const auto stream = DeflateRaw(AsBytes(text), 9);
+  std::vector<uint8_t> out(text.size());
+
+  std::vector<DeflateBlockStart> blocks;
+  const auto produced = FastInflate(
+      stream, out, {.on_block = [&](const DeflateBlockStart& block) {
+        blocks.push_back(block);
+        return true;
+      }});
+  ASSERT_TRUE(produced == text.size());
+  ASSERT_TRUE(blocks.size() > 1);
+  EXPECT_EQ(blocks[0].bit_offset, 0u);
+  EXPECT_EQ(blocks[0].out_offset, 0u);
+  for (size_t i = 1; i < blocks.size(); ++i) {
+    EXPECT_TRUE(blocks[i].bit_offset > blocks[i - 1].bit_offset);
+    EXPECT_TRUE(blocks[i].out_offset > blocks[i - 1].out_offset);
+  }
+
+  size_t calls = 0;
+  EXPECT_FALSE(FastInflate(stream, out, {.on_block = [&](const auto&) {
+                             ++calls;
+                             return false;
+                           }}));
+  EXPECT_EQ(calls, 1u);
+}
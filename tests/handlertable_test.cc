@@ -0,0 +1,64 @@
+#include "handlertable.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "testing.h"
+
+namespace {
+
+using Handler = bool (*)(int message);
+
+std::vector<int> calls;
+
+template <int kId>
+bool Record(int message) {
+  calls.push_back(kId);
+  return message == kId;
+}
+
+std::vector<int> Dispatch(const HandlerTable<Handler, 3>& table,
+                          size_t event_class,
+                          int message) {
+  calls.clear();
+  for (const Handler handler : table.handlers(event_class)) {
+    if (handler(message)) {
+      break;
+    }
+  }
+  return calls;
+}
+
+}  // namespace
+
+TEST(HandlerTable, OrdersByPriorityThenRegistration) {
+  HandlerTable<Handler, 3> table;
+  EXPECT_TRUE(table.Add(&Record<1>, 200, 0b001));
+  EXPECT_TRUE(table.Add(&Record<2>, 100, 0b011));
+  EXPECT_TRUE(table.Add(&Record<3>, 200, 0b111));
+  EXPECT_TRUE(table.Add(&Record<4>, 0, 0b100));
+  EXPECT_TRUE(table.Add(&Record<5>, 100, 0b001));
+  // Nothing dispatches before the table is frozen.
+  EXPECT_TRUE(table.handlers(0).empty());
+  table.Freeze();
+
+  EXPECT_EQ(Dispatch(table, 0, 0), (std::vector<int>{2, 5, 1, 3}));
+  EXPECT_EQ(Dispatch(table, 1, 0), (std::vector<int>{2, 3}));
+  EXPECT_EQ(Dispatch(table, 2, 0), (std::vector<int>{4, 3}));
+  // A handler that takes the message stops the dispatch.
+  EXPECT_EQ(Dispatch(table, 0, 5), (std::vector<int>{2, 5}));
+}
+
+TEST(HandlerTable, ClosesRegistrationOnFreeze) {
+  HandlerTable<Handler, 3> table;
+  EXPECT_FALSE(table.frozen());
+  EXPECT_TRUE(table.Add(&Record<1>, 0, 0b010));
+  // A handler without classes is kept but never called.
+  EXPECT_TRUE(table.Add(&Record<2>, 0, 0));
+  table.Freeze();
+  EXPECT_TRUE(table.frozen());
+  EXPECT_FALSE(table.Add(&Record<3>, 0, 0b111));
+  EXPECT_TRUE(table.handlers(0).empty());
+  EXPECT_EQ(Dispatch(table, 1, 0), (std::vector<int>{1}));
+  EXPECT_TRUE(table.handlers(2).empty());
+}
@@ -0,0 +1,220 @@
+#include "htmlrewriter.h"
+
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "paktestutil.h"
+#include "testing.h"
+
+namespace {
+
+using Replacement = HtmlRewriter::Replacement;
+
+constexpr bool IsHtmlSpace(char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// The rewrite spelled out: lines trimmed first, then after every byte the
+// longest applied find string the text written since the last replacement
+// ends with, the first of equal ones, is replaced. `peak` is the most the
+// text ever holds, which must fit the document.
+std::string Reference(std::string_view input,
+                      std::span<const Replacement> replacements,
+                      std::span<const uint8_t> groups,
+                      uint32_t group_mask,
+                      bool trim_lines,
+                      size_t& peak) {
+  std::string text;
+  if (trim_lines) {
+    size_t pos = 0;
+    for (;;) {
+      const size_t end = std::min(input.find('\n', pos), input.size());
+      size_t first = pos;
+      size_t last = end;
+      while (first < last && IsHtmlSpace(input[first])) {
+        ++first;
+      }
+      while (last > first && IsHtmlSpace(input[last - 1])) {
+        --last;
+      }
+      text += '\n';
+      text += input.substr(first, last - first);
+      if (end == input.size()) {
+        break;
+      }
+      pos = end + 1;
+    }
+  } else {
+    text = input;
+  }
+
+  std::string out;
+  size_t restart = 0;
+  peak = 0;
+  for (const char c : text) {
+    out += c;
+    peak = std::max(peak, out.size());
+    int best = -1;
+    for (size_t i = 0; i < replacements.size(); ++i) {
+      const std::string_view find = replacements[i].first;
+      const uint32_t group = groups.empty() ? 0 : groups[i];
+      if ((group_mask & (1u << group)) && !find.empty() &&
+          find.size() <= out.size() - restart && out.ends_with(find) &&
+          (best < 0 || find.size() > replacements[best].first.size())) {
+        best = static_cast<int>(i);
+      }
+    }
+    if (best >= 0) {
+      out.resize(out.size() - replacements[best].first.size());
+      out += replacements[best].second;
+      peak = std::max(peak, out.size());
+      restart = out.size();
+    }
+  }
+  return out;
+}
+
+std::optional<std::string> Rewrite(const HtmlRewriter& rewriter,
+                                   std::string_view input,
+                                   bool trim_lines,
+                                   uint32_t group_mask = UINT32_MAX) {
+  std::vector<uint8_t> document(input.begin(), input.end());
+  const auto length = rewriter.Rewrite(document, trim_lines, group_mask);
+  if (!length) {
+    return std::nullopt;
+  }
+  return std::string(document.begin(), document.begin() + *length);
+}
+
+}  // namespace
+
+TEST(HtmlRewriter, TrimsLines) {
+  const HtmlRewriter rewriter({});
+  EXPECT_EQ(Rewrite(rewriter, "  <a>  b \r\n\t\n <c>\t", true),
+            std::optional<std::string>("\n<a>  b\n\n<c>"));
+  EXPECT_EQ(Rewrite(rewriter, " x\n", true),
+            std::optional<std::string>("\nx\n"));
+  EXPECT_EQ(Rewrite(rewriter, "  x y  ", false),
+            std::optional<std::string>("  x y  "));
+  // The leading newline has no room in a document with nothing to trim.
+  EXPECT_FALSE(Rewrite(rewriter, "xy", true));
+  EXPECT_FALSE(Rewrite(rewriter, "", true));
+}
+
+TEST(HtmlRewriter, PrefersTheEarliestThenLongestMatch) {
+  const Replacement replacements[] = {
+      {"bc", "1"}, {"abcd", "2"}, {"c", "3"}, {"xbc", "4"}, {"bc", "5"}};
+  const HtmlRewriter rewriter(replacements);
+  // "bc" ends before "abcd" does; "xbc" and "bc" end together and the longer
+  // wins; of two "bc" the first.
+  EXPECT_EQ(Rewrite(rewriter, "abcd xbc bc", false),
+            std::optional<std::string>("a1d 4 1"));
+  // Replaced text is not searched again.
+  const Replacement echo[] = {{"a", "aa"}, {"aa", "b"}};
+  EXPECT_EQ(Rewrite(HtmlRewriter(echo), "a a    \n", true),
+            std::optional<std::string>("\naa aa\n"));
+}
+
+TEST(HtmlRewriter, AppliesOnlyTheGroupsAsked) {
+  const Replacement replacements[] = {
+      {"abc", "1"}, {"bc", "2"}, {"abc", "3"}, {"c", "4"}};
+  const uint8_t groups[] = {0, 1, 1, 31};
+  const HtmlRewriter rewriter(replacements, groups);
+  EXPECT_EQ(Rewrite(rewriter, "xabc", false, 1u << 0),
+            std::optional<std::string>("x1"));
+  EXPECT_EQ(Rewrite(rewriter, "xabc", false, 1u << 1),
+            std::optional<std::string>("x3"));
+  EXPECT_EQ(Rewrite(rewriter, "xabc", false, 1u << 31),
+            std::optional<std::string>("xab4"));
+  EXPECT_EQ(Rewrite(rewriter, "xabc xbc", false, (1u << 1) | (1u << 31)),
+            std::optional<std::string>("x3 x2"));
+  EXPECT_EQ(Rewrite(rewriter, "xabc", false, 0),
+            std::optional<std::string>("xabc"));
+}
+
+// Replacements longer than their find strings push the output past input
+// not yet read; the text trimmed off elsewhere pays for them.
+TEST(HtmlRewriter, GrowsInPlaceIntoTrimmedSpace) {
+  const Replacement replacements[] = {{"a", "<AAAA>"}};
+  const HtmlRewriter rewriter(replacements);
+  const std::string input = "aaaa ab\n" + std::string(40, ' ') + "b";
+  size_t peak = 0;
+  const auto expected =
+      Reference(input, replacements, {}, UINT32_MAX, true, peak);
+  ASSERT_TRUE(peak <= input.size());
+  EXPECT_EQ(Rewrite(rewriter, input, true), std::optional(expected));
+  // Without the trimming, the result does not fit.
+  EXPECT_FALSE(Rewrite(rewriter, input, false));
+}
+
+// Random documents over a small alphabet, so find strings overlap and
+// repeat: the rewrite agrees with the reference wherever the reference fits
+// the document, and fails where it does not.
+TEST(HtmlRewriter, MatchesTheReference) {
+  std::mt19937 random(7);
+  constexpr std::string_view kAlphabet = "ab \n";
+  auto random_string = [&](size_t max_length, size_t alphabet) {
+    std::string text(random() % (max_length + 1), ' ');
+    for (char& c : text) {
+      c = kAlphabet[random() % alphabet];
+    }
+    return text;
+  };
+  for (int round = 0; round < 300; ++round) {
+    std::vector<std::string> strings;
+    std::vector<uint8_t> groups;
+    const size_t count = 1 + random() % 6;
+    for (size_t i = 0; i < count; ++i) {
+      strings.push_back(random_string(4, 2));
+      strings.push_back(random_string(6, 3));
+      groups.push_back(static_cast<uint8_t>(random() % 4));
+    }
+    std::vector<Replacement> replacements;
+    for (size_t i = 0; i < count; ++i) {
+      replacements.emplace_back(strings[2 * i], strings[2 * i + 1]);
+    }
+    const HtmlRewriter rewriter(replacements, groups);
+    for (int document = 0; document < 20; ++document) {
+      const std::string input = random_string(200, 4);
+      const uint32_t group_mask = random() % 16;
+      const bool trim_lines = random() % 2;
+      size_t peak = 0;
+      const auto expected = Reference(input, replacements, groups,
+                                      group_mask, trim_lines, peak);
+      const auto rewritten = Rewrite(rewriter, input, trim_lines, group_mask);
+      if (peak <= input.size()) {
+        EXPECT_EQ(rewritten, std::optional(expected));
+      } else {
+        EXPECT_FALSE(rewritten);
+      }
+    }
+  }
+}
+
+// The settings-page rule's shape on WebUI-like text.
+TEST(HtmlRewriter, RewritesAWebUiDocument) {
+  std::string input = MakeWebUiText(64 * 1024, 3);
+  input.insert(input.size() / 2,
+               "  <div>{aboutBrowserVersion}</div>\n"
+               "    <span ?hidden=\"${!this.showUpdateStatus_}\">\n");
+  const Replacement replacements[] = {
+      {R"(?hidden="${!this.showUpdateStatus_}")", R"(hidden="true")"},
+      {"{aboutBrowserVersion}</div>",
+       "{aboutBrowserVersion}</div><div class=\"secondary\">Powered by "
+       "Chrome++</div>"}};
+  const HtmlRewriter rewriter(replacements);
+  size_t peak = 0;
+  const auto expected =
+      Reference(input, replacements, {}, UINT32_MAX, true, peak);
+  ASSERT_TRUE(peak <= input.size());
+  const auto rewritten = Rewrite(rewriter, input, true);
+  ASSERT_TRUE(rewritten);
+  EXPECT_TRUE(*rewritten == expected);
+  EXPECT_TRUE(rewritten->contains("Powered by Chrome++"));
+  EXPECT_TRUE(rewritten->contains(R"(<span hidden="true">)"));
+}
@@ -0,0 +1,57 @@
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "inifile.h"
+#include "testing.h"
+
+// A generated chrome++.ini with large sections: one `IniFile::Parse`, then a
+// hash lookup per key, against decoding and scanning the whole file again
+// for every key, as each `GetPrivateProfileStringW` call did.
+BENCHMARK(IniFile, ParseOnceVsParsePerKey) {
+  constexpr int kSections = 20;
+  constexpr int kKeys = 250;
+  std::string text;
+  for (int section = 0; section < kSections; ++section) {
+    text += "[section" + std::to_string(section) + "]\r\n";
+    for (int key = 0; key < kKeys; ++key) {
+      text += "key" + std::to_string(key) + "=Ctrl+Shift+" +
+              std::to_string(key) + "\r\n";
+    }
+  }
+  const std::vector<uint8_t> bytes(text.begin(), text.end());
+  std::vector<std::pair<std::wstring, std::wstring>> lookups;
+  for (int i = 0; i < 100; ++i) {
+    lookups.emplace_back(L"section" + std::to_wstring(i * 7 % kSections),
+                         L"key" + std::to_wstring(i * 13 % kKeys));
+  }
+  std::printf("  %zu KB, %zu lookups\n", bytes.size() / 1024, lookups.size());
+
+  auto look_up = [&](const IniFile& ini, size_t& found) {
+    for (const auto& [section, key] : lookups) {
+      found += ini.GetString(section, key).value_or(L"").size();
+    }
+  };
+  const double per_key = testing::Measure("parse per key", 3, [&] {
+    size_t found = 0;
+    for (const auto& [section, key] : lookups) {
+      found += IniFile::Parse(bytes).GetString(section, key)->size();
+    }
+    testing::KeepAlive(found);
+  });
+  const double once = testing::Measure("parse once, then look up", 20, [&] {
+    size_t found = 0;
+    look_up(IniFile::Parse(bytes), found);
+    testing::KeepAlive(found);
+  });
+  const IniFile ini = IniFile::Parse(bytes);
+  testing::Measure("look up only", 200, [&] {
+    size_t found = 0;
+    look_up(ini, found);
+    testing::KeepAlive(found);
+  });
+  std::printf("  %.0fx faster\n", per_key / once);
+}
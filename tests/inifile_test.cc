@@ -0,0 +1,177 @@
+#include "inifile.h"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "testing.h"
+
+namespace {
+
+std::vector<uint8_t> Utf8(std::string_view text, bool bom = false) {
+  std::vector<uint8_t> bytes;
+  if (bom) {
+    bytes = {0xEF, 0xBB, 0xBF};
+  }
+  bytes.insert(bytes.end(), text.begin(), text.end());
+  return bytes;
+}
+
+// Code units above U+FFFF are not needed; the shipped chrome++.ini is
+// UTF-16LE with a BOM.
+std::vector<uint8_t> Utf16(std::wstring_view text) {
+  std::vector<uint8_t> bytes = {0xFF, 0xFE};
+  for (const wchar_t c : text) {
+    bytes.push_back(static_cast<uint8_t>(c));
+    bytes.push_back(static_cast<uint8_t>(c >> 8));
+  }
+  return bytes;
+}
+
+std::optional<std::wstring> GetString(const IniFile& ini,
+                                      std::wstring_view section,
+                                      std::wstring_view key) {
+  const auto value = ini.GetString(section, key);
+  return value ? std::optional<std::wstring>(*value) : std::nullopt;
+}
+
+}  // namespace
+
+TEST(IniFile, DecodesByByteOrderMark) {
+  const std::wstring text = L"[general]\r\nname=Zoë ✓\r\n";
+  const IniFile utf16 = IniFile::Parse(Utf16(text));
+  EXPECT_EQ(GetString(utf16, L"general", L"name"), L"Zoë ✓");
+
+  const std::string utf8_text = "[general]\nname=Zoë ✓\n";
+  EXPECT_EQ(GetString(IniFile::Parse(Utf8(utf8_text, true)), L"general",
+                      L"name"),
+            L"Zoë ✓");
+  EXPECT_EQ(GetString(IniFile::Parse(Utf8(utf8_text)), L"general", L"name"),
+            L"Zoë ✓");
+
+  // A trailing odd byte of UTF-16 is dropped.
+  auto odd = Utf16(L"[a]\nk=v");
+  odd.push_back('x');
+  EXPECT_EQ(GetString(IniFile::Parse(odd), L"a", L"k"), L"v");
+}
+
+TEST(IniFile, ReplacesInvalidUtf8ByteByByte) {
+  // A lone continuation byte, an overlong '/', a surrogate and a truncated
+  // sequence each become U+FFFD per offending byte.
+  const std::string text =
+      "[a]\nk=x\x80y\xC0\xAFz\xED\xA0\x80w\xE2\x9C\n"
+      "emoji=\xF0\x9F\x98\x80\n";
+  const IniFile ini = IniFile::Parse(Utf8(text));
+  EXPECT_EQ(GetString(ini, L"a", L"k"),
+            L"x\uFFFDy\uFFFD\uFFFDz\uFFFD\uFFFD\uFFFDw\uFFFD\uFFFD");
+  const auto emoji = GetString(ini, L"a", L"emoji");
+  ASSERT_TRUE(emoji);
+  if constexpr (sizeof(wchar_t) == 2) {
+    EXPECT_EQ(*emoji, std::wstring(L"\xD83D\xDE00"));
+  } else {
+    EXPECT_EQ(emoji->size(), 1u);
+    EXPECT_EQ(static_cast<uint32_t>((*emoji)[0]), 0x1F600u);
+  }
+}
+
+TEST(IniFile, LooksUpLikeGetPrivateProfileString) {
+  const IniFile ini = IniFile::Parse(Utf8(
+      "; leading comment\n"
+      "orphan=ignored\n"
+      "[ General ]\n"
+      "  Key = value  \n"
+      "quoted=\"  spaced  \"\n"
+      "single='x'\n"
+      "mismatched=\"x'\n"
+      "lone=\"\n"
+      "empty=\n"
+      "; key=commented\n"
+      "=no key\n"
+      "no equals sign\n"
+      "key=second\n"
+      "[other]\n"
+      "key=other\n"
+      "[GENERAL]\n"
+      "late=dropped\n"));
+  EXPECT_EQ(GetString(ini, L"general", L"key"), L"value");
+  EXPECT_EQ(GetString(ini, L"GENERAL", L"KEY"), L"value");
+  EXPECT_EQ(GetString(ini, L"general", L"quoted"), L"  spaced  ");
+  EXPECT_EQ(GetString(ini, L"general", L"single"), L"x");
+  EXPECT_EQ(GetString(ini, L"general", L"mismatched"), L"\"x'");
+  EXPECT_EQ(GetString(ini, L"general", L"lone"), L"\"");
+  EXPECT_EQ(GetString(ini, L"general", L"empty"), L"");
+  EXPECT_EQ(GetString(ini, L"other", L"key"), L"other");
+  EXPECT_FALSE(GetString(ini, L"general", L"late"));
+  EXPECT_FALSE(GetString(ini, L"general", L"orphan"));
+  EXPECT_FALSE(GetString(ini, L"general", L"missing"));
+  EXPECT_FALSE(GetString(ini, L"missing", L"key"));
+
+  const auto section = ini.GetSection(L"general");
+  ASSERT_EQ(section.size(), 7u);
+  EXPECT_TRUE(section[0].key == L"Key" && section[0].value == L"value");
+  EXPECT_TRUE(section[1].value == L"\"  spaced  \"");
+  EXPECT_TRUE(section[6].key == L"key" && section[6].value == L"second");
+  EXPECT_TRUE(ini.GetSection(L"missing").empty());
+}
+
+TEST(IniFile, ReadsIntegersLikeGetPrivateProfileInt) {
+  const IniFile ini = IniFile::Parse(Utf8(
+      "[n]\n"
+      "dec=42\nneg=-17\nplus=+5\nhex=0x1F\nHEX=0XfF\noct=0o17\nbin=0b101\n"
+      "trailing=12px\ntext=abc\nempty=\nquoted=\"7\"\nspaced=  8\n"
+      "wrap=4294967297\nbare_prefix=0x\n"));
+  EXPECT_EQ(ini.GetInt(L"n", L"dec"), 42);
+  EXPECT_EQ(ini.GetInt(L"n", L"neg"), -17);
+  EXPECT_EQ(ini.GetInt(L"n", L"plus"), 5);
+  EXPECT_EQ(ini.GetInt(L"n", L"hex"), 31);
+  EXPECT_EQ(ini.GetInt(L"n", L"oct"), 15);
+  EXPECT_EQ(ini.GetInt(L"n", L"bin"), 5);
+  EXPECT_EQ(ini.GetInt(L"n", L"trailing"), 12);
+  EXPECT_EQ(ini.GetInt(L"n", L"text"), 0);
+  EXPECT_EQ(ini.GetInt(L"n", L"quoted"), 7);
+  EXPECT_EQ(ini.GetInt(L"n", L"spaced"), 8);
+  EXPECT_EQ(ini.GetInt(L"n", L"wrap"), 1);
+  EXPECT_EQ(ini.GetInt(L"n", L"bare_prefix"), 0);
+  EXPECT_FALSE(ini.GetInt(L"n", L"empty"));
+  EXPECT_FALSE(ini.GetInt(L"n", L"missing"));
+  // Keys are case-insensitive, so `HEX` is a duplicate of `hex`.
+  EXPECT_EQ(ini.GetInt(L"n", L"HEX"), 31);
+}
+
+TEST(IniFile, IndexesALargeFile) {
+  std::string text;
+  for (int section = 0; section < 50; ++section) {
+    text += "[section" + std::to_string(section) + "]\r\n";
+    for (int key = 0; key < 400; ++key) {
+      text += "Key" + std::to_string(key) + " = " +
+              std::to_string(section * 1000 + key) + "\r\n";
+    }
+  }
+  IniFile ini = IniFile::Parse(Utf8(text));
+  for (int section = 0; section < 50; ++section) {
+    const std::wstring name = L"SECTION" + std::to_wstring(section);
+    ASSERT_EQ(ini.GetSection(name).size(), 400u);
+    for (int key = 0; key < 400; ++key) {
+      EXPECT_EQ(ini.GetInt(name, L"key" + std::to_wstring(key)),
+                section * 1000 + key);
+    }
+    EXPECT_FALSE(ini.GetString(name, L"key400"));
+  }
+  // Views survive a move of the parsed file.
+  const IniFile moved = std::move(ini);
+  EXPECT_EQ(GetString(moved, L"section7", L"key9"), L"7009");
+}
+
+TEST(IniFile, ParsesEmptyAndTruncatedInput) {
+  EXPECT_FALSE(IniFile::Parse({}).GetString(L"a", L"b"));
+  EXPECT_TRUE(IniFile::Parse({}).GetSection(L"a").empty());
+  const uint8_t bom_only[] = {0xFF, 0xFE};
+  EXPECT_FALSE(IniFile::Parse(bom_only).GetString(L"a", L"b"));
+  // An unterminated section header still names the section.
+  EXPECT_EQ(GetString(IniFile::Parse(Utf8("[open\nk=v")), L"open", L"k"),
+            L"v");
+}
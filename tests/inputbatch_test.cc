@@ -0,0 +1,98 @@
+#include "inputbatch.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "keytables.h"
+#include "testing.h"
+
+namespace {
+
+// `MOD_*` and `VK_*` values from WinUser.h.
+constexpr uint32_t kAlt = 0x1;
+constexpr uint32_t kControl = 0x2;
+constexpr uint32_t kShift = 0x4;
+constexpr uint32_t kWin = 0x8;
+
+constexpr uint16_t kVkShift = 0x10;
+constexpr uint16_t kVkControl = 0x11;
+constexpr uint16_t kVkMenu = 0x12;
+constexpr uint16_t kVkLWin = 0x5B;
+
+// An event as `vk` with a `+` for a press or `-` for a release; `kVkShift`
+// down is `+16`.
+std::vector<int> Sequence(const InputBatch& batch) {
+  std::vector<int> sequence;
+  for (const InputEvent& event : batch.events()) {
+    sequence.push_back(event.key_up ? -event.vk : event.vk);
+  }
+  return sequence;
+}
+
+}  // namespace
+
+TEST(InputBatch, StrokesKey) {
+  InputBatch batch;
+  EXPECT_TRUE(batch.empty());
+  batch.AddKeyStroke('A');
+  EXPECT_EQ(Sequence(batch), (std::vector<int>{'A', -'A'}));
+  EXPECT_TRUE(batch.events()[0].extended);
+  EXPECT_FALSE(batch.overflowed());
+}
+
+TEST(InputBatch, OrdersModifiers) {
+  InputBatch batch;
+  batch.AddModifiers(kWin | kAlt | kShift | kControl, false);
+  batch.AddModifiers(kShift | kAlt, true);
+  EXPECT_EQ(Sequence(batch),
+            (std::vector<int>{kVkControl, kVkShift, kVkMenu, kVkLWin,
+                              -kVkShift, -kVkMenu}));
+  for (const InputEvent& event : batch.events()) {
+    EXPECT_FALSE(event.extended);
+  }
+}
+
+TEST(InputBatch, MarksOverflow) {
+  InputBatch batch;
+  for (size_t i = 0; i < InputBatch::kCapacity; ++i) {
+    batch.AddKey('A', false);
+  }
+  EXPECT_FALSE(batch.overflowed());
+  batch.AddKey('B', false);
+  EXPECT_TRUE(batch.overflowed());
+  EXPECT_EQ(batch.events().size(), InputBatch::kCapacity);
+  EXPECT_EQ(batch.events().back().vk, uint16_t{'A'});
+}
+
+// Ctrl+Alt+J -> Ctrl+Shift+K with Ctrl and Alt still held: Alt goes up,
+// Shift down, the key, Shift up and Alt back down. Ctrl is shared and never
+// touched.
+TEST(InputBatch, ComposesMappedKey) {
+  const KeyMappingEntry mapping = {'J', kControl | kAlt, 'K',
+                                   kControl | kShift, 0};
+  InputBatch batch;
+  AddMappedKey(mapping, kControl | kAlt, batch);
+  EXPECT_EQ(Sequence(batch),
+            (std::vector<int>{-kVkMenu, kVkShift, 'K', -'K', -kVkShift,
+                              kVkMenu}));
+  EXPECT_FALSE(batch.overflowed());
+}
+
+// A released modifier the user let go of meanwhile is not pressed again.
+TEST(InputBatch, SkipsRestoreOfLiftedModifier) {
+  const KeyMappingEntry mapping = {'J', kAlt, 'K', 0, 0};
+  InputBatch batch;
+  AddMappedKey(mapping, 0, batch);
+  EXPECT_EQ(Sequence(batch), (std::vector<int>{-kVkMenu, 'K', -'K'}));
+}
+
+// A modifier is either released and restored or pressed and released, so no
+// mapping sends more than ten events; well inside the capacity.
+TEST(InputBatch, LongestMappingFits) {
+  const KeyMappingEntry mapping = {'J', kControl | kShift | kAlt | kWin, 'K',
+                                   0, 0};
+  InputBatch batch;
+  AddMappedKey(mapping, kControl | kShift | kAlt | kWin, batch);
+  EXPECT_EQ(batch.events().size(), size_t{10});
+  EXPECT_FALSE(batch.overflowed());
+}
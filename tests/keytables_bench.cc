@@ -0,0 +1,68 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "keytables.h"
+#include "testing.h"
+
+// 500 mappings over random keys and modifier sets, looked up with a stream
+// of key presses of which one in ten is mapped: the per-key table against
+// walking the mapping list, as the hook did before the tables.
+BENCHMARK(KeyTables, LookupVsLinearWalk) {
+  constexpr size_t kMappings = 500;
+  std::mt19937 random(1);
+  KeyTables tables;
+  std::vector<KeyMappingEntry> list;
+  while (list.size() < kMappings) {
+    const KeyMappingEntry mapping = {
+        1 + static_cast<uint32_t>(random() % (KeyTables::kVkCount - 1)),
+        static_cast<uint32_t>(random() & KeyTables::kModifierMask),
+        static_cast<uint32_t>(random() % KeyTables::kVkCount), 0, 0};
+    if (tables.Add(mapping)) {
+      list.push_back(mapping);
+    }
+  }
+
+  struct Press {
+    uint32_t vk;
+    uint32_t modifiers;
+  };
+  std::vector<Press> presses(1 << 20);
+  for (Press& press : presses) {
+    if (random() % 10 == 0) {
+      const KeyMappingEntry& mapping = list[random() % list.size()];
+      press = {mapping.source_vk, mapping.source_modifiers};
+    } else {
+      press = {static_cast<uint32_t>(random() % KeyTables::kVkCount),
+               static_cast<uint32_t>(random() & KeyTables::kModifierMask)};
+    }
+  }
+
+  std::printf("  %zu mappings, %zu presses\n", list.size(), presses.size());
+  uint64_t linear_sum = 0;
+  const double linear = testing::Measure("linear walk", 5, [&] {
+    for (const Press& press : presses) {
+      for (const KeyMappingEntry& mapping : list) {
+        if (mapping.source_vk == press.vk &&
+            mapping.source_modifiers == press.modifiers) {
+          linear_sum += mapping.target_vk;
+          break;
+        }
+      }
+    }
+  });
+  uint64_t table_sum = 0;
+  const double table = testing::Measure("per-key table", 5, [&] {
+    for (const Press& press : presses) {
+      if (const KeyMappingEntry* mapping =
+              tables.Find(press.vk, press.modifiers)) {
+        table_sum += mapping->target_vk;
+      }
+    }
+  });
+  testing::KeepAlive(linear_sum);
+  testing::KeepAlive(table_sum);
+  std::printf("  %.1fx faster\n", linear / table);
+}
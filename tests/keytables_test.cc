@@ -0,0 +1,78 @@
+#include "keytables.h"
+
+#include <cstdint>
+
+#include "testing.h"
+
+namespace {
+
+// `MOD_*` values from WinUser.h.
+constexpr uint32_t kAlt = 0x1;
+constexpr uint32_t kControl = 0x2;
+constexpr uint32_t kShift = 0x4;
+
+KeyMappingEntry Key(uint32_t vk,
+                    uint32_t modifiers,
+                    uint32_t target_vk,
+                    uint32_t target_modifiers = 0) {
+  return {vk, modifiers, target_vk, target_modifiers, 0};
+}
+
+}  // namespace
+
+TEST(KeyTables, FindsExactModifierSet) {
+  KeyTables tables;
+  EXPECT_TRUE(tables.Add(Key('A', kControl, 'B')));
+  EXPECT_TRUE(tables.Add(Key('A', kControl | kShift, 'C')));
+  EXPECT_TRUE(tables.Add({'Q', kAlt, 0, 0, 34014}));
+
+  const KeyMappingEntry* mapping = tables.Find('A', kControl);
+  ASSERT_TRUE(mapping != nullptr);
+  EXPECT_EQ(mapping->target_vk, uint32_t{'B'});
+  mapping = tables.Find('A', kControl | kShift);
+  ASSERT_TRUE(mapping != nullptr);
+  EXPECT_EQ(mapping->target_vk, uint32_t{'C'});
+  mapping = tables.Find('Q', kAlt);
+  ASSERT_TRUE(mapping != nullptr);
+  EXPECT_EQ(mapping->target_command, 34014);
+
+  // Neither fewer nor more modifiers than mapped match.
+  EXPECT_TRUE(tables.Find('A', 0) == nullptr);
+  EXPECT_TRUE(tables.Find('A', kControl | kAlt) == nullptr);
+  EXPECT_TRUE(tables.Find('B', kControl) == nullptr);
+  EXPECT_EQ(tables.mappings().size(), size_t{3});
+}
+
+TEST(KeyTables, KeepsFirstOfDuplicates) {
+  KeyTables tables;
+  EXPECT_TRUE(tables.Add(Key('A', kControl, 'B')));
+  EXPECT_FALSE(tables.Add(Key('A', kControl, 'C')));
+
+  const KeyMappingEntry* mapping = tables.Find('A', kControl);
+  ASSERT_TRUE(mapping != nullptr);
+  EXPECT_EQ(mapping->target_vk, uint32_t{'B'});
+  EXPECT_EQ(tables.mappings().size(), size_t{1});
+}
+
+TEST(KeyTables, RejectsOutOfRangeKeys) {
+  KeyTables tables;
+  EXPECT_FALSE(tables.Add(Key(0, kControl, 'B')));
+  EXPECT_FALSE(tables.Add(Key(KeyTables::kVkCount, 0, 'B')));
+  EXPECT_TRUE(tables.Add(Key(KeyTables::kVkCount - 1, 0, 'B')));
+
+  EXPECT_TRUE(tables.Find(0, kControl) == nullptr);
+  EXPECT_TRUE(tables.Find(KeyTables::kVkCount, 0) == nullptr);
+  EXPECT_TRUE(tables.Find(0xFFFFFFFF, 0) == nullptr);
+  EXPECT_TRUE(tables.Find(KeyTables::kVkCount - 1, 0) != nullptr);
+}
+
+TEST(KeyTables, MatchesTranslateKey) {
+  KeyTables tables;
+  // Unset, no key is the translate key, not even vk 0.
+  EXPECT_FALSE(tables.IsTranslateKey(0, 0));
+
+  tables.set_translate_key({'T', kControl | kShift});
+  EXPECT_TRUE(tables.IsTranslateKey('T', kControl | kShift));
+  EXPECT_FALSE(tables.IsTranslateKey('T', kControl));
+  EXPECT_FALSE(tables.IsTranslateKey('Y', kControl | kShift));
+}
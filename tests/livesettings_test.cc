@@ -0,0 +1,116 @@
+#include "livesettings.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "inifile.h"
+#include "snapshotpublisher.h"
+#include "testing.h"
+
+namespace {
+
+IniFile ParseIni(std::string_view text) {
+  return IniFile::Parse(std::span(
+      reinterpret_cast<const uint8_t*>(text.data()), text.size()));
+}
+
+std::unique_ptr<const LiveSettings> ReadSnapshot(std::string_view text) {
+  return std::make_unique<const LiveSettings>(
+      ReadLiveSettings(ParseIni(text)));
+}
+
+}  // namespace
+
+// An empty INI gives the defaults chrome++.ini documents.
+TEST(ReadLiveSettings, DefaultsForAbsentKeys) {
+  const LiveSettings live = ReadLiveSettings(ParseIni(""));
+  EXPECT_TRUE(live.translate_key.empty());
+  EXPECT_TRUE(live.keep_last_tab);
+  EXPECT_TRUE(live.double_click_close);
+  EXPECT_FALSE(live.right_click_close);
+  EXPECT_TRUE(live.wheel_tab);
+  EXPECT_TRUE(live.wheel_tab_when_press_rbutton);
+  EXPECT_FALSE(live.hover_tab);
+  EXPECT_EQ(live.hover_tab_delay, 400);
+  EXPECT_EQ(live.open_url_new_tab, 0);
+  EXPECT_EQ(live.bookmark_new_tab, 0);
+  EXPECT_TRUE(live.new_tab_disable);
+  EXPECT_TRUE(live.disable_tab_names.empty());
+  EXPECT_TRUE(live.key_mappings.empty());
+}
+
+TEST(ReadLiveSettings, ReadsEveryKey) {
+  const LiveSettings live = ReadLiveSettings(ParseIni(
+      "[general]\ntranslate_key=ctrl+shift+t\n"
+      "[tabs]\nkeep_last_tab=0\ndouble_click_close=0\n"
+      "right_click_close=1\nwheel_tab=0\nwheel_tab_when_press_rbutton=0\n"
+      "hover_tab=1\nhover_tab_delay=150\nopen_url_new_tab=2\n"
+      "open_bookmark_new_tab=1\nnew_tab_disable=0\n"
+      "new_tab_disable_name=\"New Tab\",\"Neuer Tab\",Start\n"
+      "[keymapping]\nctrl+q=alt+f4\nctrl+e=\nctrl+w=command:34014\n"));
+  EXPECT_TRUE(live.translate_key == L"ctrl+shift+t");
+  EXPECT_FALSE(live.keep_last_tab);
+  EXPECT_FALSE(live.double_click_close);
+  EXPECT_TRUE(live.right_click_close);
+  EXPECT_FALSE(live.wheel_tab);
+  EXPECT_FALSE(live.wheel_tab_when_press_rbutton);
+  EXPECT_TRUE(live.hover_tab);
+  EXPECT_EQ(live.hover_tab_delay, 150);
+  EXPECT_EQ(live.open_url_new_tab, 2);
+  EXPECT_EQ(live.bookmark_new_tab, 1);
+  EXPECT_FALSE(live.new_tab_disable);
+  // The quotes do not pair up around the whole value, so the INI keeps them
+  // and the split drops them per name.
+  EXPECT_TRUE(live.disable_tab_name == L"\"New Tab\",\"Neuer Tab\",Start");
+  EXPECT_TRUE(live.disable_tab_names ==
+              std::vector<std::wstring>({L"New Tab", L"Neuer Tab", L"Start"}));
+  // A mapping without a target is skipped.
+  ASSERT_EQ(live.key_mappings.size(), 2u);
+  EXPECT_TRUE(live.key_mappings[0].first == L"ctrl+q");
+  EXPECT_TRUE(live.key_mappings[1].second == L"command:34014");
+}
+
+TEST(ReadLiveSettings, ClampsTheHoverDelay) {
+  for (const char* text : {"[tabs]\nhover_tab_delay=-1\n",
+                           "[tabs]\nhover_tab_delay=5001\n"}) {
+    EXPECT_EQ(ReadLiveSettings(ParseIni(text)).hover_tab_delay, 400);
+  }
+  EXPECT_EQ(
+      ReadLiveSettings(ParseIni("[tabs]\nhover_tab_delay=5000\n"))
+          .hover_tab_delay,
+      5000);
+}
+
+// A reload publishes a new snapshot while a handler still holds the old one:
+// the old reference keeps its values until enough newer snapshots have been
+// published, and only that many are ever kept.
+TEST(SnapshotPublisher, KeepsOldSnapshotsAcrossReloads) {
+  SnapshotPublisher<LiveSettings, 4> live;
+  EXPECT_TRUE(live.Current() == nullptr);
+
+  const LiveSettings& first =
+      live.Publish(ReadSnapshot("[tabs]\nwheel_tab=0\nhover_tab_delay=100\n"));
+  EXPECT_TRUE(live.Current() == &first);
+  const LiveSettings& held = *live.Current();
+
+  const LiveSettings& second =
+      live.Publish(ReadSnapshot("[tabs]\nwheel_tab=1\nhover_tab_delay=200\n"));
+  EXPECT_TRUE(live.Current() == &second);
+  EXPECT_FALSE(held.wheel_tab);
+  EXPECT_EQ(held.hover_tab_delay, 100);
+  EXPECT_TRUE(second.wheel_tab);
+
+  live.Publish(ReadSnapshot(""));
+  live.Publish(ReadSnapshot(""));
+  EXPECT_EQ(live.retained(), 4u);
+  EXPECT_EQ(held.hover_tab_delay, 100);
+
+  for (int i = 0; i < 20; ++i) {
+    live.Publish(ReadSnapshot("[tabs]\nhover_tab_delay=300\n"));
+    EXPECT_EQ(live.retained(), 4u);
+  }
+  EXPECT_EQ(live.Current()->hover_tab_delay, 300);
+}
@@ -0,0 +1,95 @@
+#include "lrucache.h"
+
+#include <vector>
+
+#include "testing.h"
+
+namespace {
+
+std::vector<int> destroyed;
+
+// Records its id when destroyed with one, as a tab UI entry releases its
+// watcher.
+class Tracked {
+ public:
+  Tracked() = default;
+  Tracked(Tracked&& other) : id(other.id) { other.id = 0; }
+  Tracked& operator=(Tracked&& other) {
+    Release();
+    id = other.id;
+    other.id = 0;
+    return *this;
+  }
+  ~Tracked() { Release(); }
+
+  int id = 0;
+
+ private:
+  void Release() {
+    if (id != 0) {
+      destroyed.push_back(id);
+    }
+  }
+};
+
+}  // namespace
+
+TEST(LruCache, FindsInsertedValues) {
+  LruCache<int, int, 4> cache;
+  EXPECT_TRUE(cache.Find(1) == nullptr);
+  cache.Insert(1) = 10;
+  cache.Insert(2) = 20;
+
+  ASSERT_TRUE(cache.Find(1) != nullptr);
+  EXPECT_EQ(*cache.Find(1), 10);
+  ASSERT_TRUE(cache.Find(2) != nullptr);
+  EXPECT_EQ(*cache.Find(2), 20);
+  EXPECT_TRUE(cache.Find(3) == nullptr);
+  EXPECT_EQ(cache.size(), size_t{2});
+  // A new entry starts from a default value.
+  EXPECT_EQ(cache.Insert(3), 0);
+}
+
+TEST(LruCache, EvictsLeastRecentlyUsed) {
+  destroyed.clear();
+  LruCache<int, Tracked, 3> cache;
+  cache.Insert(1).id = 1;
+  cache.Insert(2).id = 2;
+  cache.Insert(3).id = 3;
+  // Using 1 makes 2 the oldest.
+  EXPECT_TRUE(cache.Find(1) != nullptr);
+  EXPECT_TRUE(destroyed.empty());
+
+  cache.Insert(4).id = 4;
+  EXPECT_EQ(destroyed, (std::vector<int>{2}));
+  EXPECT_TRUE(cache.Find(2) == nullptr);
+  EXPECT_EQ(cache.size(), size_t{3});
+
+  cache.Insert(5).id = 5;
+  EXPECT_EQ(destroyed, (std::vector<int>{2, 3}));
+  EXPECT_TRUE(cache.Find(1) != nullptr);
+  EXPECT_TRUE(cache.Find(4) != nullptr);
+  EXPECT_TRUE(cache.Find(5) != nullptr);
+}
+
+TEST(LruCache, ErasesMatchingEntries) {
+  destroyed.clear();
+  LruCache<int, Tracked, 4> cache;
+  for (int key = 1; key <= 4; ++key) {
+    cache.Insert(key).id = key * 10;
+  }
+  cache.EraseIf([](int key, const Tracked&) { return key % 2 == 0; });
+  EXPECT_EQ(cache.size(), size_t{2});
+  EXPECT_EQ(destroyed.size(), size_t{2});
+  EXPECT_TRUE(cache.Find(2) == nullptr);
+  EXPECT_TRUE(cache.Find(4) == nullptr);
+  ASSERT_TRUE(cache.Find(3) != nullptr);
+  EXPECT_EQ(cache.Find(3)->id, 30);
+
+  // The freed room is used before anything else is evicted.
+  destroyed.clear();
+  cache.Insert(5);
+  cache.Insert(6);
+  EXPECT_TRUE(destroyed.empty());
+  EXPECT_TRUE(cache.Find(1) != nullptr);
+}
@@ -0,0 +1,333 @@
+#include "pakfile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "paktestutil.h"
+#include "testing.h"
+
+namespace {
+
+std::vector<PakTestResource> MakeResources() {
+  std::vector<PakTestResource> resources;
+  for (uint16_t id = 100; id < 110; ++id) {
+    resources.push_back({id, std::vector<uint8_t>(64 + id, uint8_t(id))});
+  }
+  return resources;
+}
+
+}  // namespace
+
+// The patch cache (pakpatch.cc) is keyed by the index hash: rewriting a
+// resource in place keeps it, anything that moves an offset changes it.
+TEST(PakIndexHash, CoversTheIndexOnly) {
+  auto resources = MakeResources();
+  auto pak = BuildPak(5, resources);
+  const auto index = PakIndex::Parse(pak);
+  ASSERT_TRUE(index);
+  const uint64_t hash = index->Hash();
+
+  auto patched = pak;
+  const auto entry = index->Find(105);
+  ASSERT_TRUE(entry);
+  patched[index->slot(*entry).offset] ^= 0xFF;
+  const auto patched_index = PakIndex::Parse(patched);
+  ASSERT_TRUE(patched_index);
+  EXPECT_EQ(patched_index->Hash(), hash);
+
+  resources[3].data.push_back(0);
+  auto rebuilt = BuildPak(5, resources);
+  const auto rebuilt_index = PakIndex::Parse(rebuilt);
+  ASSERT_TRUE(rebuilt_index);
+  EXPECT_NE(rebuilt_index->Hash(), hash);
+}
+
+TEST(PakIndexHash, CoversTheAliasTable) {
+  const auto resources = MakeResources();
+  const std::pair<uint16_t, uint16_t> aliases[] = {{200, 1}};
+  const std::pair<uint16_t, uint16_t> moved_aliases[] = {{200, 2}};
+  auto pak = BuildPak(5, resources, aliases);
+  auto moved = BuildPak(5, resources, moved_aliases);
+  const auto index = PakIndex::Parse(pak);
+  const auto moved_index = PakIndex::Parse(moved);
+  ASSERT_TRUE(index && moved_index);
+  EXPECT_NE(index->Hash(), moved_index->Hash());
+}
+
+namespace {
+
+constexpr std::string_view kNeedle = "</settings-about-page>";
+
+// A v5 pak of gzip entries with ids 1000, 1001, ...; texts of 64 KB and more
+// compress to scan candidates (10 KB).
+struct ScanPak {
+  explicit ScanPak(std::span<const std::string> texts, int level = 9)
+      : texts(texts) {
+    std::vector<PakTestResource> resources;
+    for (size_t i = 0; i < texts.size(); ++i) {
+      resources.push_back({static_cast<uint16_t>(1000 + i),
+                           GzipMember(AsBytes(texts[i]), level)});
+    }
+    bytes = BuildPak(5, resources);
+  }
+
+  std::optional<PakIndex> index() { return PakIndex::Parse(bytes); }
+
+  std::string Entry(uint16_t resource_id) {
+    const auto parsed = index();
+    const auto entry = parsed->Find(resource_id);
+    return entry ? GunzipMember(parsed->data(*entry)) : std::string();
+  }
+
+  std::span<const std::string> texts;
+  std::vector<uint8_t> bytes;
+};
+
+std::vector<std::string> MakeTexts(size_t count, size_t size) {
+  std::vector<std::string> texts;
+  for (size_t i = 0; i < count; ++i) {
+    texts.push_back(MakeWebUiText(size, static_cast<uint32_t>(i)));
+  }
+  return texts;
+}
+
+}  // namespace
+
+// The needle straddles the scan's 32 KB window.
+TEST(ScanGZIPFile, FindsNeedleAcrossWindows) {
+  auto texts = MakeTexts(4, 100 * 1024);
+  texts[2].replace(32 * 1024 - 7, kNeedle.size(), kNeedle);
+  ScanPak pak(texts);
+  const auto index = pak.index();
+  ASSERT_TRUE(index);
+
+  const std::span<const uint8_t> needles[] = {AsBytes(kNeedle)};
+  const auto result = ScanGZIPFile(*index, needles);
+  EXPECT_TRUE(result == std::vector<uint16_t>({1002}));
+}
+
+TEST(ScanGZIPFile, ReportsMissingNeedle) {
+  const auto texts = MakeTexts(3, 80 * 1024);
+  ScanPak pak(texts);
+  const auto index = pak.index();
+  ASSERT_TRUE(index);
+
+  const std::span<const uint8_t> needles[] = {AsBytes(kNeedle)};
+  const auto result = ScanGZIPFile(*index, needles);
+  EXPECT_TRUE(result == std::vector<uint16_t>({0}));
+}
+
+// One needle per entry, plus one found in the same entry as another, before
+// it: the entry stops decoding only once both are found.
+TEST(ScanGZIPFile, MatchesSeveralNeedlesPerEntry) {
+  auto texts = MakeTexts(5, 80 * 1024);
+  texts[1].replace(100, 6, "needle");
+  texts[3].replace(79 * 1024, 5, "other");
+  texts[3].replace(5, 5, "third");
+  ScanPak pak(texts);
+  const auto index = pak.index();
+  ASSERT_TRUE(index);
+
+  const std::span<const uint8_t> needles[] = {
+      AsBytes("needle"), AsBytes("other"), AsBytes("third")};
+  const auto result = ScanGZIPFile(*index, needles);
+  EXPECT_TRUE(result == std::vector<uint16_t>({1001, 1003, 1003}));
+}
+
+// The scan only locates the entry; a targeted `TraversalGZIPFile` inflates it
+// again to patch it, and it then decodes to the patched text.
+TEST(ScanGZIPFile, MatchIsPatchedByResourceId) {
+  auto texts = MakeTexts(3, 80 * 1024);
+  texts[1].replace(70 * 1024, kNeedle.size(), kNeedle);
+  ScanPak pak(texts);
+  const auto index = pak.index();
+  ASSERT_TRUE(index);
+
+  const std::span<const uint8_t> needles[] = {AsBytes(kNeedle)};
+  const auto result = ScanGZIPFile(*index, needles);
+  ASSERT_TRUE(result == std::vector<uint16_t>({1001}));
+  std::string expected = texts[1];
+  expected.resize(expected.size() / 2);
+  const uint16_t patched = TraversalGZIPFile(
+      *index,
+      [&](uint8_t* begin, uint32_t size, size_t& new_len) {
+        new_len = size / 2;
+        return std::string_view(reinterpret_cast<const char*>(begin), size)
+            .contains(kNeedle);
+      },
+      result[0]);
+  EXPECT_EQ(patched, 1001);
+  EXPECT_TRUE(pak.Entry(1001) == expected);
+  EXPECT_TRUE(pak.Entry(1000) == texts[0]);
+}
+
+// Whatever worker finds a needle first, each needle resolves to its
+// lowest-index match, as a single-threaded scan does.
+TEST(ScanGZIPFile, WorkersReturnTheSequentialResult) {
+  auto texts = MakeTexts(12, 70 * 1024);
+  for (const size_t i : {3u, 7u, 11u}) {
+    texts[i].replace(60 * 1024, kNeedle.size(), kNeedle);
+  }
+  texts[9].replace(10, 5, "other");
+  ScanPak pak(texts);
+  const auto index = pak.index();
+  ASSERT_TRUE(index);
+
+  const std::span<const uint8_t> needles[] = {AsBytes(kNeedle),
+                                              AsBytes("other")};
+  const auto sequential = ScanGZIPFile(*index, needles, 1);
+  EXPECT_TRUE(sequential == std::vector<uint16_t>({1003, 1009}));
+  for (const unsigned workers : {2u, 3u, 8u, 32u}) {
+    const auto parallel = ScanGZIPFile(*index, needles, workers);
+    EXPECT_TRUE(parallel == sequential);
+  }
+}
+
+namespace {
+
+// The deflate stream of a gzip member as `GzipMember` or the write-back lays
+// it out: no optional fields but FEXTRA.
+std::span<const uint8_t> DeflateStreamOf(std::span<const uint8_t> member) {
+  size_t offset = 10;
+  if (member[3] & 0x04) {
+    offset += 2 + (member[10] | member[11] << 8);
+  }
+  return member.subspan(offset, member.size() - offset - 8);
+}
+
+// Patches entry 1000 of `pak` by removing `length` bytes at `position` of its
+// content; returns what `TraversalGZIPFile` returned.
+uint16_t CutEntry(ScanPak& pak, size_t position, size_t length) {
+  const auto index = pak.index();
+  return TraversalGZIPFile(
+      *index,
+      [&](uint8_t* begin, uint32_t size, size_t& new_len) {
+        std::copy(begin + position + length, begin + size, begin + position);
+        new_len = size - length;
+        return true;
+      },
+      1000);
+}
+
+}  // namespace
+
+// An edit near the end keeps the original stream up to the block holding it;
+// the spliced stream still decodes to the edited text.
+TEST(TraversalGZIPFile, KeepsBlocksBeforeTheEdit) {
+  const auto texts = MakeTexts(1, 400 * 1024);
+  ScanPak pak(texts);
+  const auto index = pak.index();
+  ASSERT_TRUE(index);
+  const auto slot = index->data(*index->Find(1000));
+  const std::vector<uint8_t> original(DeflateStreamOf(slot).begin(),
+                                      DeflateStreamOf(slot).end());
+
+  const size_t position = texts[0].size() - 5000;
+  EXPECT_EQ(CutEntry(pak, position, 40), 1000);
+  std::string expected = texts[0];
+  expected.erase(position, 40);
+  EXPECT_TRUE(pak.Entry(1000) == expected);
+
+  const auto spliced = DeflateStreamOf(index->data(*index->Find(1000)));
+  const size_t kept = original.size() / 2;
+  ASSERT_TRUE(spliced.size() > kept);
+  EXPECT_TRUE(std::equal(original.begin(), original.begin() + kept,
+                         spliced.begin()));
+}
+
+// Edits across entries compressed at different levels, so the kept blocks
+// end at many bit alignments, all decode; an edit in the first block
+// recompresses the whole entry.
+TEST(TraversalGZIPFile, SplicesAtAnyPosition) {
+  for (const int level : {1, 6, 9}) {
+    for (uint32_t seed = 0; seed < 3; ++seed) {
+      const std::string texts[] = {MakeWebUiText(300 * 1024, seed)};
+      for (size_t position = 0; position < texts[0].size() - 1024;
+           position += texts[0].size() / 11) {
+        ScanPak pak(texts, level);
+        const size_t length = 200 + position % 13;
+        EXPECT_EQ(CutEntry(pak, position, length), 1000);
+        std::string expected = texts[0];
+        expected.erase(position, length);
+        EXPECT_TRUE(pak.Entry(1000) == expected);
+      }
+    }
+  }
+}
+
+// Content that no longer fits the slot is not written back, and the entry is
+// not reported as patched.
+TEST(TraversalGZIPFile, LeavesAnEntryThatNoLongerFits) {
+  const auto texts = MakeTexts(1, 100 * 1024);
+  ScanPak pak(texts);
+  const auto index = pak.index();
+  ASSERT_TRUE(index);
+  const auto before = pak.bytes;
+
+  uint32_t state = 1;
+  const uint16_t patched = TraversalGZIPFile(
+      *index,
+      [&](uint8_t* begin, uint32_t size, size_t& new_len) {
+        for (uint32_t i = 0; i < size; ++i) {
+          state = state * 1664525 + 1013904223;
+          begin[i] = static_cast<uint8_t>(state >> 24);
+        }
+        new_len = size;
+        return true;
+      },
+      1000);
+  EXPECT_EQ(patched, 0);
+  EXPECT_TRUE(pak.bytes == before);
+}
+
+#if defined(CHROME_PLUS_BROTLI)
+// A Brotli entry among gzip ones is searched, then patched and written back
+// as Brotli.
+TEST(ScanGZIPFile, FindsAndPatchesBrotliEntries) {
+  auto texts = MakeTexts(3, 80 * 1024);
+  texts[2].replace(50 * 1024, kNeedle.size(), kNeedle);
+  const PakTestResource resources[] = {
+      {1000, GzipMember(AsBytes(texts[0]))},
+      {1001, BrotliEntry(AsBytes(texts[1]))},
+      {1002, BrotliEntry(AsBytes(texts[2]))}};
+  auto pak = BuildPak(5, resources);
+  const auto index = PakIndex::Parse(pak);
+  ASSERT_TRUE(index);
+  EXPECT_EQ(CountUnsearchedEntries(*index), 0u);
+
+  const std::span<const uint8_t> needles[] = {AsBytes(kNeedle)};
+  const auto result = ScanGZIPFile(*index, needles);
+  ASSERT_TRUE(result == std::vector<uint16_t>({1002}));
+  const uint16_t patched = TraversalGZIPFile(
+      *index,
+      [](uint8_t*, uint32_t size, size_t& new_len) {
+        new_len = size - 1000;
+        return true;
+      },
+      result[0]);
+  EXPECT_EQ(patched, 1002);
+  EXPECT_TRUE(UnbrotliEntry(index->data(2)) ==
+              texts[2].substr(0, texts[2].size() - 1000));
+  EXPECT_TRUE(UnbrotliEntry(index->data(1)) == texts[1]);
+}
+#else
+// Without Brotli support the scan cannot search Brotli entries; the caller
+// is told how many there were.
+TEST(CountUnsearchedEntries, CountsBrotliEntries) {
+  std::vector<uint8_t> brotli = {0x1E, 0x9B, 0x10, 0, 0, 0, 0, 0};
+  brotli.resize(12 * 1024, 0x55);
+  const PakTestResource resources[] = {
+      {1000, GzipMember(AsBytes(MakeWebUiText(70 * 1024, 1)))},
+      {1001, brotli},
+      {1002, brotli}};
+  auto pak = BuildPak(5, resources);
+  const auto index = PakIndex::Parse(pak);
+  ASSERT_TRUE(index);
+  EXPECT_EQ(CountUnsearchedEntries(*index), 2u);
+}
+#endif
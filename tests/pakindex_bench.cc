@@ -0,0 +1,45 @@
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "pakfile.h"
+#include "paktestutil.h"
+#include "testing.h"
+
+// Resource lookups on a 10,000-entry pak: `PakIndex::Find`'s binary search
+// against the linear walk over the entry table it replaced.
+BENCHMARK(PakIndex, FindVsLinearWalk) {
+  std::vector<PakTestResource> resources;
+  for (uint16_t i = 0; i < 10000; ++i) {
+    resources.push_back({static_cast<uint16_t>(1 + i * 6), {0}});
+  }
+  auto pak = BuildPak(5, resources);
+  const auto index = PakIndex::Parse(pak);
+  if (!index) {
+    return;
+  }
+
+  constexpr size_t kLookups = 1000;
+  const double linear = testing::Measure("linear walk, 1000 lookups", 20, [&] {
+    size_t found = 0;
+    for (size_t i = 0; i < kLookups; ++i) {
+      const auto target = resources[(i * 7919) % resources.size()].resource_id;
+      for (size_t entry = 0; entry < index->size(); ++entry) {
+        if (index->resource_id(entry) == target) {
+          found += entry;
+          break;
+        }
+      }
+    }
+    testing::KeepAlive(found);
+  });
+  const double binary = testing::Measure("Find, 1000 lookups", 20, [&] {
+    size_t found = 0;
+    for (size_t i = 0; i < kLookups; ++i) {
+      const auto target = resources[(i * 7919) % resources.size()].resource_id;
+      found += index->Find(target).value_or(0);
+    }
+    testing::KeepAlive(found);
+  });
+  std::printf("  %.0fx faster\n", linear / binary);
+}
@@ -0,0 +1,143 @@
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "pakfile.h"
+#include "paktestutil.h"
+#include "testing.h"
+
+namespace {
+
+// Offsets into a `BuildPak` v5 file: 12 header bytes, then 6-byte entries
+// (id, offset) and 4-byte aliases (id, entry index).
+constexpr size_t kV5EntriesOffset = 12;
+constexpr size_t kEntrySize = 6;
+
+std::vector<PakTestResource> MakeResources(size_t count) {
+  std::vector<PakTestResource> resources;
+  for (size_t i = 0; i < count; ++i) {
+    const auto resource_id = static_cast<uint16_t>(10 + 3 * i);
+    resources.push_back(
+        {resource_id,
+         std::vector<uint8_t>(1 + i % 7, static_cast<uint8_t>(i))});
+  }
+  return resources;
+}
+
+void PutLe(std::vector<uint8_t>& pak, size_t offset, uint32_t value,
+           size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    pak.at(offset + i) = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+}  // namespace
+
+TEST(PakIndex, ParsesVersion4And5) {
+  const auto resources = MakeResources(5);
+  for (const int version : {4, 5}) {
+    auto pak = BuildPak(version, resources);
+    const auto index = PakIndex::Parse(pak);
+    ASSERT_TRUE(index);
+    ASSERT_EQ(index->size(), resources.size());
+    for (size_t i = 0; i < resources.size(); ++i) {
+      EXPECT_EQ(index->resource_id(i), resources[i].resource_id);
+      EXPECT_EQ(index->slot(i).length, resources[i].data.size());
+      const auto data = index->data(i);
+      EXPECT_TRUE(std::vector<uint8_t>(data.begin(), data.end()) ==
+                  resources[i].data);
+    }
+  }
+}
+
+TEST(PakIndex, FindsEveryEntryOfALargePak) {
+  const auto resources = MakeResources(10000);
+  auto pak = BuildPak(5, resources);
+  const auto index = PakIndex::Parse(pak);
+  ASSERT_TRUE(index);
+  for (size_t i = 0; i < resources.size(); ++i) {
+    EXPECT_TRUE(index->Find(resources[i].resource_id) == i);
+    EXPECT_FALSE(index->Find(resources[i].resource_id + 1));
+  }
+  EXPECT_FALSE(index->Find(0));
+  EXPECT_FALSE(index->Find(1));
+}
+
+// v5 aliases resolve to the entry they name; one naming an entry past the
+// table resolves to nothing.
+TEST(PakIndex, ResolvesAliases) {
+  const auto resources = MakeResources(4);
+  const std::pair<uint16_t, uint16_t> aliases[] = {
+      {11, 2}, {100, 0}, {101, 3}, {102, 4}};
+  auto pak = BuildPak(5, resources, aliases);
+  const auto index = PakIndex::Parse(pak);
+  ASSERT_TRUE(index);
+  EXPECT_TRUE(index->Find(11) == 2u);
+  EXPECT_TRUE(index->Find(100) == 0u);
+  EXPECT_TRUE(index->Find(101) == 3u);
+  EXPECT_FALSE(index->Find(102));
+  EXPECT_TRUE(index->Find(10) == 0u);
+}
+
+TEST(PakIndex, RejectsMalformedIndexes) {
+  const auto resources = MakeResources(4);
+  const std::pair<uint16_t, uint16_t> aliases[] = {{100, 1}, {101, 2}};
+  const auto valid = BuildPak(5, resources, aliases);
+  {
+    auto pak = valid;
+    ASSERT_TRUE(PakIndex::Parse(pak));
+  }
+  const auto entry = [](size_t i) { return kV5EntriesOffset + i * kEntrySize; };
+  const size_t sentinel = entry(resources.size());
+  const size_t alias_table = entry(resources.size() + 1);
+
+  std::vector<std::vector<uint8_t>> broken;
+  auto mutate = [&](auto change) {
+    auto pak = valid;
+    change(pak);
+    broken.push_back(std::move(pak));
+  };
+  mutate([](auto& pak) { PutLe(pak, 0, 6, 4); });  // Unknown version.
+  mutate([](auto& pak) { PutLe(pak, 4, 2, 4); });  // Not UTF-8.
+  mutate([](auto& pak) { pak.resize(10); });       // Header cut short.
+  mutate([&](auto& pak) { pak.resize(sentinel + 2); });  // Table cut short.
+  mutate([](auto& pak) { PutLe(pak, 8, 0xFFFF, 2); });   // Entry count.
+  mutate([](auto& pak) { PutLe(pak, 10, 0xFFFF, 2); });  // Alias count.
+  mutate([&](auto& pak) { PutLe(pak, entry(2), 10, 2); });  // Id order.
+  mutate([&](auto& pak) { PutLe(pak, entry(1) + 2, 0xFFFF, 4); });  // Offset.
+  mutate([&](auto& pak) { PutLe(pak, sentinel, 7, 2); });  // Sentinel id.
+  mutate([&](auto& pak) {  // Sentinel offset past the end of the file.
+    PutLe(pak, sentinel + 2, static_cast<uint32_t>(pak.size() + 1), 4);
+  });
+  mutate([&](auto& pak) { PutLe(pak, alias_table + 4, 99, 2); });  // Order.
+
+  for (auto& pak : broken) {
+    EXPECT_FALSE(PakIndex::Parse(pak));
+  }
+  std::vector<uint8_t> empty;
+  EXPECT_FALSE(PakIndex::Parse(empty));
+}
+
+// Patching by an aliased id rewrites the entry it names.
+TEST(TraversalGZIPFile, PatchesAnAliasedResource) {
+  const std::string text = MakeWebUiText(64 * 1024, 5);
+  std::vector<PakTestResource> resources = {
+      {10, {1, 2, 3}}, {20, GzipMember(AsBytes(text))}, {30, {4}}};
+  const std::pair<uint16_t, uint16_t> aliases[] = {{25, 1}};
+  auto pak = BuildPak(5, resources, aliases);
+  const auto index = PakIndex::Parse(pak);
+  ASSERT_TRUE(index);
+
+  const uint16_t patched = TraversalGZIPFile(
+      *index,
+      [](uint8_t*, uint32_t size, size_t& new_len) {
+        new_len = size / 2;
+        return true;
+      },
+      25);
+  EXPECT_EQ(patched, 25);
+  EXPECT_TRUE(GunzipMember(index->data(1)) == text.substr(0, text.size() / 2));
+}
@@ -0,0 +1,190 @@
+#include "pakrules.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "testing.h"
+
+namespace {
+
+using RuleLines = std::vector<std::pair<std::wstring, std::wstring>>;
+
+// Runs `Apply` on a copy of `text`; the patched text, or std::nullopt when
+// no rule in `mask` matched.
+std::optional<std::string> ApplyRules(const PakRuleSet& rule_set,
+                                      uint32_t mask,
+                                      std::string text,
+                                      uint32_t* matched = nullptr) {
+  size_t new_len = 0;
+  const uint32_t applied =
+      rule_set.Apply(mask, reinterpret_cast<uint8_t*>(text.data()),
+                     static_cast<uint32_t>(text.size()), new_len);
+  if (matched) {
+    *matched = applied;
+  }
+  if (applied == 0) {
+    return std::nullopt;
+  }
+  text.resize(new_len);
+  return text;
+}
+
+std::vector<PakRule> ParseAll(const RuleLines& lines) {
+  std::vector<PakRule> rules;
+  for (const auto& [key, value] : lines) {
+    rules.push_back(*ParsePakRule(key, value));
+  }
+  return rules;
+}
+
+}  // namespace
+
+TEST(ParsePakRule, SplitsNeedleAndPairs) {
+  const auto rule = ParsePakRule(L"title@1234", L"<title>|Chrome|Chrome++|a|");
+  ASSERT_TRUE(rule);
+  EXPECT_TRUE(rule->name == L"title");
+  EXPECT_EQ(rule->resource_id, 1234);
+  EXPECT_TRUE(rule->needle == "<title>");
+  ASSERT_EQ(rule->replacements.size(), 2u);
+  EXPECT_TRUE(rule->replacements[0].first == "Chrome");
+  EXPECT_TRUE(rule->replacements[0].second == "Chrome++");
+  EXPECT_TRUE(rule->replacements[1].first == "a");
+  EXPECT_TRUE(rule->replacements[1].second.empty());
+  EXPECT_FALSE(rule->compress_html);
+}
+
+// `\|` and `\\` are a literal bar and backslash; any other backslash is
+// kept as is.
+TEST(ParsePakRule, UnescapesBarsAndBackslashes) {
+  const auto rule =
+      ParsePakRule(L"escapes", L"a\\|b|c\\\\|d\\n\\\\\\||x|\\\\");
+  ASSERT_TRUE(rule);
+  EXPECT_TRUE(rule->needle == "a|b");
+  ASSERT_EQ(rule->replacements.size(), 2u);
+  EXPECT_TRUE(rule->replacements[0].first == "c\\");
+  EXPECT_TRUE(rule->replacements[0].second == "d\\n\\|");
+  EXPECT_TRUE(rule->replacements[1].first == "x");
+  EXPECT_TRUE(rule->replacements[1].second == "\\");
+}
+
+// Text is converted to UTF-8, as pak resources are stored; a surrogate pair
+// is one code point and an unpaired surrogate becomes U+FFFD.
+TEST(ParsePakRule, ConvertsToUtf8) {
+  std::wstring value = L"\u00e9|\u4e2d|";
+  value += static_cast<wchar_t>(0xD83D);
+  value += static_cast<wchar_t>(0xDE00);
+  value += static_cast<wchar_t>(0xDC00);
+  const auto rule = ParsePakRule(L"utf8", value);
+  ASSERT_TRUE(rule);
+  EXPECT_TRUE(rule->needle == "\xC3\xA9");
+  EXPECT_TRUE(rule->replacements[0].first == "\xE4\xB8\xAD");
+  EXPECT_TRUE(rule->replacements[0].second ==
+              "\xF0\x9F\x98\x80\xEF\xBF\xBD");
+}
+
+TEST(ParsePakRule, RejectsMalformedRules) {
+  // Resource ids outside 0-65535, or not a number.
+  EXPECT_FALSE(ParsePakRule(L"r@65536", L"n|f|r"));
+  EXPECT_FALSE(ParsePakRule(L"r@4294967296", L"n|f|r"));
+  EXPECT_FALSE(ParsePakRule(L"r@", L"n|f|r"));
+  EXPECT_FALSE(ParsePakRule(L"r@12x", L"n|f|r"));
+  EXPECT_TRUE(ParsePakRule(L"r@65535", L"n|f|r"));
+  EXPECT_TRUE(ParsePakRule(L"r@0", L"n|f|r"));
+  // A needle alone, or a find string without its replacement.
+  EXPECT_FALSE(ParsePakRule(L"r", L"n"));
+  EXPECT_FALSE(ParsePakRule(L"r", L"n|f"));
+  EXPECT_FALSE(ParsePakRule(L"r", L"n|f|r|g"));
+  // Empty needle or find string; an escaped bar is not a separator.
+  EXPECT_FALSE(ParsePakRule(L"r", L"|f|r"));
+  EXPECT_FALSE(ParsePakRule(L"r", L"n||r"));
+  EXPECT_FALSE(ParsePakRule(L"r", L"n|f|r||r"));
+  EXPECT_FALSE(ParsePakRule(L"r", L"n\\|f|r"));
+}
+
+TEST(ParsePakRules, StartsWithTheSettingsRule) {
+  const RuleLines lines = {{L"bad", L"n|f"}, {L"good", L"n|f|r"}};
+  const auto list = ParsePakRules(lines);
+  ASSERT_EQ(list.rules.size(), 2u);
+  EXPECT_TRUE(list.rules[0].name == L"settings");
+  EXPECT_TRUE(list.rules[0].needle == "</settings-about-page>");
+  EXPECT_TRUE(list.rules[0].compress_html);
+  EXPECT_TRUE(list.rules[1].name == L"good");
+  EXPECT_TRUE(list.malformed == std::vector<std::wstring>({L"bad"}));
+  EXPECT_EQ(list.ignored, 0u);
+}
+
+// Rules are tracked in 32-bit masks: lines past the cap are counted, not
+// parsed, even when malformed.
+TEST(ParsePakRules, CapsTheRuleCount) {
+  RuleLines lines;
+  for (int i = 0; i < 40; ++i) {
+    lines.emplace_back(L"r" + std::to_wstring(i), L"n|f|r");
+  }
+  lines[3].second = L"n|f";
+  lines.emplace_back(L"late", L"malformed");
+  const auto list = ParsePakRules(lines);
+  EXPECT_EQ(list.rules.size(), kMaxPakRules);
+  EXPECT_TRUE(list.rules.back().name ==
+              L"r" + std::to_wstring(kMaxPakRules - 1));
+  EXPECT_TRUE(list.malformed == std::vector<std::wstring>({L"r3"}));
+  EXPECT_EQ(list.ignored, lines.size() - kMaxPakRules);
+}
+
+TEST(PakRuleSet, MatchesNeedlesAgainstTheOriginalDocument) {
+  // `second`'s needle only appears once `first` has run, and `third` still
+  // applies though `first` replaces its needle: needles are decided up front.
+  const PakRuleSet rule_set(ParseAll({{L"first", L"alpha|alpha|beta"},
+                                      {L"second", L"beta|x|y"},
+                                      {L"third", L"alpha|gamma|delta"}}));
+  uint32_t matched = 0;
+  const auto patched =
+      ApplyRules(rule_set, 0b111, "alpha gamma x", &matched);
+  ASSERT_TRUE(patched);
+  EXPECT_EQ(matched, 0b101u);
+  EXPECT_TRUE(*patched == "beta delta x");
+}
+
+TEST(PakRuleSet, AppliesOnlyTheRulesInTheMask) {
+  const PakRuleSet rule_set(ParseAll({{L"a", L"doc|one|1"},
+                                      {L"b", L"doc|two|2"},
+                                      {L"c", L"missing|three|3"}}));
+  uint32_t matched = 0;
+  auto patched = ApplyRules(rule_set, 0b110, "doc one two three", &matched);
+  ASSERT_TRUE(patched);
+  EXPECT_EQ(matched, 0b010u);
+  EXPECT_TRUE(*patched == "doc one 2 three");
+
+  // Nothing in the mask matches: the document is left alone.
+  EXPECT_FALSE(ApplyRules(rule_set, 0b100, "doc one two three", &matched));
+  EXPECT_EQ(matched, 0u);
+  EXPECT_FALSE(ApplyRules(rule_set, 0, "doc one two three"));
+}
+
+// A patched document that would outgrow the entry is not applied.
+TEST(PakRuleSet, RejectsGrowth) {
+  const PakRuleSet rule_set(ParseAll({{L"grow", L"doc|doc|document"}}));
+  uint32_t matched = 1;
+  EXPECT_FALSE(ApplyRules(rule_set, 1, "doc doc", &matched));
+  EXPECT_EQ(matched, 0u);
+}
+
+// Every field that changes what gets patched changes the hash; the name only
+// labels log lines.
+TEST(HashPakRules, CoversWhatIsPatched) {
+  const auto base = ParseAll({{L"r@1", L"n|f|r"}});
+  const uint64_t hash = HashPakRules(base);
+  EXPECT_EQ(HashPakRules(ParseAll({{L"renamed@1", L"n|f|r"}})), hash);
+  for (const auto& [key, value] : RuleLines{{L"r@2", L"n|f|r"},
+                                            {L"r@1", L"nf|r|"},
+                                            {L"r@1", L"n|fr|"},
+                                            {L"r@1", L"n|f|r|g|h"}}) {
+    EXPECT_NE(HashPakRules(ParseAll({{key, value}})), hash);
+  }
+  auto compressed = base;
+  compressed[0].compress_html = true;
+  EXPECT_NE(HashPakRules(compressed), hash);
+}
@@ -0,0 +1,105 @@
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "pakfile.h"
+#include "paktestutil.h"
+#include "testing.h"
+
+namespace {
+
+constexpr std::string_view kNeedle = "</settings-about-page>";
+
+// A resources.pak-shaped file: 240 WebUI-like gzip entries of 16 KB to
+// 512 KB among small uncompressed ones, with the needle in the last large
+// entry, so every scan decodes every candidate.
+std::vector<uint8_t> MakeSyntheticPak() {
+  std::mt19937 random(7);
+  std::vector<PakTestResource> resources;
+  uint16_t resource_id = 100;
+  for (int i = 0; i < 240; ++i) {
+    const size_t size = 16 * 1024 + random() % (496 * 1024);
+    std::string text = MakeWebUiText(size, static_cast<uint32_t>(i));
+    if (i == 239) {
+      text.replace(text.size() - 4096, kNeedle.size(), kNeedle);
+    }
+    resources.push_back({resource_id++, GzipMember(AsBytes(text))});
+    resources.push_back(
+        {resource_id++, std::vector<uint8_t>(512 + random() % 2048, 'x')});
+  }
+  return BuildPak(5, resources);
+}
+
+}  // namespace
+
+// The content scan's two strategies on the same pak: the full-inflate walk
+// (`TraversalGZIPFile` decompressing every candidate into its own buffer
+// before the callback searches it) against the streaming scan, single- and
+// multi-threaded.
+BENCHMARK(PakScan, FullInflateVsStreaming) {
+  auto pak = MakeSyntheticPak();
+  const auto index = PakIndex::Parse(pak);
+  if (!index) {
+    return;
+  }
+  std::printf("synthetic pak: %zu entries, %zu bytes\n", index->size(),
+              pak.size());
+
+  testing::Measure("full inflate, then search", 5, [&] {
+    bool found = false;
+    TraversalGZIPFile(*index, [&](uint8_t* begin, uint32_t size, size_t&) {
+      found = found || std::string_view(reinterpret_cast<char*>(begin), size)
+                           .contains(kNeedle);
+      return false;
+    });
+    testing::KeepAlive(found);
+  });
+
+  const std::span<const uint8_t> needles[] = {AsBytes(kNeedle)};
+  for (const unsigned workers : {1u, 4u}) {
+    const std::string label =
+        "streaming scan, " + std::to_string(workers) + " worker(s)";
+    testing::Measure(label, 5, [&] {
+      const auto result = ScanGZIPFile(*index, needles, workers);
+      testing::KeepAlive(result[0]);
+    });
+  }
+}
+
+#if defined(CHROME_PLUS_BROTLI)
+// The content scan over the same WebUI texts shipped as gzip and as Brotli
+// entries: the stream decode is the scan's cost, so this is the price of
+// searching Brotli-compressed paks (Chrome's default since 2024).
+BENCHMARK(PakScan, BrotliVsGzip) {
+  std::vector<PakTestResource> gzip_resources;
+  std::vector<PakTestResource> brotli_resources;
+  for (uint16_t i = 0; i < 60; ++i) {
+    const std::string text = MakeWebUiText(64 * 1024 + i * 4096, i);
+    gzip_resources.push_back({static_cast<uint16_t>(100 + i),
+                              GzipMember(AsBytes(text))});
+    brotli_resources.push_back({static_cast<uint16_t>(100 + i),
+                                BrotliEntry(AsBytes(text))});
+  }
+  auto gzip_pak = BuildPak(5, gzip_resources);
+  auto brotli_pak = BuildPak(5, brotli_resources);
+  std::printf("60 entries: gzip pak %zu bytes, Brotli pak %zu bytes\n",
+              gzip_pak.size(), brotli_pak.size());
+
+  const std::span<const uint8_t> needles[] = {AsBytes(kNeedle)};
+  for (auto* pak : {&gzip_pak, &brotli_pak}) {
+    const auto index = PakIndex::Parse(*pak);
+    if (!index) {
+      return;
+    }
+    const char* label = pak == &gzip_pak ? "gzip" : "Brotli";
+    testing::Measure(std::string("streaming scan, ") + label, 10, [&] {
+      const auto result = ScanGZIPFile(*index, needles);
+      testing::KeepAlive(result[0]);
+    });
+  }
+}
+#endif
@@ -0,0 +1,226 @@
+#include "paktestutil.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string_view>
+
+#if defined(CHROME_PLUS_BROTLI)
+#include <brotli/decode.h>
+#include <brotli/encode.h>
+#endif
+
+#define MINIZ_HEADER_FILE_ONLY
+#include "miniz.c"
+
+namespace {
+
+void AppendLe(std::vector<uint8_t>& out, uint64_t value, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+}  // namespace
+
+std::vector<uint8_t> BuildPak(
+    int version,
+    std::span<const PakTestResource> resources,
+    std::span<const std::pair<uint16_t, uint16_t>> aliases) {
+  std::vector<uint8_t> pak;
+  AppendLe(pak, version, 4);
+  size_t header_size = 0;
+  if (version == 4) {
+    AppendLe(pak, resources.size(), 4);
+    AppendLe(pak, 1, 1);  // UTF-8.
+    header_size = pak.size() + (resources.size() + 1) * 6;
+  } else {
+    AppendLe(pak, 1, 4);
+    AppendLe(pak, resources.size(), 2);
+    AppendLe(pak, aliases.size(), 2);
+    header_size = pak.size() + (resources.size() + 1) * 6 + aliases.size() * 4;
+  }
+
+  size_t offset = header_size;
+  for (const auto& resource : resources) {
+    AppendLe(pak, resource.resource_id, 2);
+    AppendLe(pak, offset, 4);
+    offset += resource.data.size();
+  }
+  AppendLe(pak, 0, 2);
+  AppendLe(pak, offset, 4);
+  if (version != 4) {
+    for (const auto& [resource_id, entry_index] : aliases) {
+      AppendLe(pak, resource_id, 2);
+      AppendLe(pak, entry_index, 2);
+    }
+  }
+  for (const auto& resource : resources) {
+    pak.insert(pak.end(), resource.data.begin(), resource.data.end());
+  }
+  return pak;
+}
+
+std::vector<uint8_t> DeflateRaw(std::span<const uint8_t> content,
+                                int level,
+                                int strategy) {
+  size_t deflate_size = 0;
+  std::unique_ptr<void, decltype(&std::free)> deflate(
+      tdefl_compress_mem_to_heap(
+          content.data(), content.size(), &deflate_size,
+          tdefl_create_comp_flags_from_zip_params(
+              level, -MZ_DEFAULT_WINDOW_BITS, strategy)),
+      std::free);
+  const auto* bytes = static_cast<const uint8_t*>(deflate.get());
+  return bytes ? std::vector<uint8_t>(bytes, bytes + deflate_size)
+               : std::vector<uint8_t>();
+}
+
+std::optional<std::vector<uint8_t>> InflateRaw(std::span<const uint8_t> stream,
+                                               size_t size) {
+  std::vector<uint8_t> out(size);
+  const size_t produced = tinfl_decompress_mem_to_mem(
+      out.data(), out.size(), stream.data(), stream.size(), 0);
+  if (produced == TINFL_DECOMPRESS_MEM_TO_MEM_FAILED) {
+    return std::nullopt;
+  }
+  out.resize(produced);
+  return out;
+}
+
+std::vector<uint8_t> GzipMember(std::span<const uint8_t> content, int level) {
+  std::vector<uint8_t> member = {0x1F, 0x8B, 0x08, 0, 0, 0, 0, 0, 2, 0xFF};
+  const auto deflate = DeflateRaw(content, level);
+  member.insert(member.end(), deflate.begin(), deflate.end());
+  AppendLe(member, mz_crc32(MZ_CRC32_INIT, content.data(), content.size()), 4);
+  AppendLe(member, content.size(), 4);
+  return member;
+}
+
+std::string GunzipMember(std::span<const uint8_t> member) {
+  constexpr uint8_t kFlagExtra = 0x04;
+  constexpr uint8_t kFlagName = 0x08;
+  if (member.size() < 18) {
+    return {};
+  }
+  size_t pos = 10;
+  if (member[3] & kFlagExtra) {
+    pos += 2 + (member[10] | (member[11] << 8));
+  }
+  if (member[3] & kFlagName) {
+    while (pos < member.size() && member[pos] != 0) {
+      ++pos;
+    }
+    ++pos;
+  }
+  const size_t end = member.size() - 8;
+  if (pos >= end) {
+    return {};
+  }
+  const size_t size = member[end + 4] | (member[end + 5] << 8) |
+                      (member[end + 6] << 16) |
+                      (size_t{member[end + 7]} << 24);
+  std::string content(size, '\0');
+  const size_t decoded = tinfl_decompress_mem_to_mem(
+      content.data(), content.size(), member.data() + pos, end - pos, 0);
+  if (decoded != size) {
+    return {};
+  }
+  const uint32_t crc = member[end] | (member[end + 1] << 8) |
+                       (member[end + 2] << 16) |
+                       (uint32_t{member[end + 3]} << 24);
+  if (mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const uint8_t*>(content.data()),
+               content.size()) != crc) {
+    return {};
+  }
+  return content;
+}
+
+#if defined(CHROME_PLUS_BROTLI)
+std::vector<uint8_t> BrotliEntry(std::span<const uint8_t> content,
+                                 int quality) {
+  std::vector<uint8_t> entry = {0x1E, 0x9B};
+  AppendLe(entry, content.size(), 6);
+  const size_t header_size = entry.size();
+  size_t encoded_size = BrotliEncoderMaxCompressedSize(content.size());
+  entry.resize(header_size + encoded_size);
+  if (!BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW,
+                             BROTLI_MODE_TEXT, content.size(),
+                             content.data(), &encoded_size,
+                             entry.data() + header_size)) {
+    return {};
+  }
+  entry.resize(header_size + encoded_size);
+  return entry;
+}
+
+std::string UnbrotliEntry(std::span<const uint8_t> entry) {
+  if (entry.size() < 8 || entry[0] != 0x1E || entry[1] != 0x9B) {
+    return {};
+  }
+  uint64_t size = 0;
+  for (size_t i = 8; i > 2; --i) {
+    size = (size << 8) | entry[i - 1];
+  }
+  std::string content(size, '\0');
+  size_t decoded_size = content.size();
+  if (BrotliDecoderDecompress(entry.size() - 8, entry.data() + 8,
+                              &decoded_size,
+                              reinterpret_cast<uint8_t*>(content.data())) !=
+          BROTLI_DECODER_RESULT_SUCCESS ||
+      decoded_size != size) {
+    return {};
+  }
+  return content;
+}
+#endif
+
+std::string MakeWebUiText(size_t size, uint32_t seed) {
+  static constexpr std::string_view kFragments[] = {
+      "<div class=\"cr-row first\">",
+      "</div>",
+      "<cr-button id=\"resetButton\" on-click=\"onResetClick_\">",
+      "</cr-button>",
+      "<template is=\"dom-if\" if=\"[[showUpdateStatus_]]\" restamp>",
+      "</template>",
+      "$i18n{aboutProductTitle}",
+      "import {PolymerElement, html} from '//resources/polymer/v3_0/"
+      "polymer/polymer_bundled.min.js';",
+      "static get properties() { return { currentUpdateStatusEvent_: "
+      "Object, }; }",
+      "this.addWebUiListener('update-status-changed', this.onUpdate_.bind("
+      "this));",
+      ":host { display: block; padding: var(--cr-section-padding); }",
+      "if (!this.isBlocked_) { return; }",
+      "<span class=\"secondary\">",
+      "</span>",
+  };
+  static constexpr std::string_view kSyllables[] = {
+      "set", "tab", "row", "list", "item", "page", "on", "click", "menu",
+      "bar", "icon", "is", "has", "show", "update", "status", "browser",
+      "profile", "search", "engine", "cookie", "site", "dialog", "handler"};
+  std::mt19937 random(seed);
+  std::string text;
+  text.reserve(size + 256);
+  while (text.size() < size) {
+    text.append(random() % 8, ' ');
+    text += kFragments[random() % std::size(kFragments)];
+    // Identifiers, numbers and strings the fragments alone would not repeat.
+    const size_t words = 1 + random() % 4;
+    for (size_t i = 0; i < words; ++i) {
+      text += kSyllables[random() % std::size(kSyllables)];
+    }
+    text += std::to_string(random() % 100000);
+    if (random() % 3 == 0) {
+      text += " = '";
+      for (size_t i = random() % 12; i > 0; --i) {
+        text += static_cast<char>('a' + random() % 26);
+      }
+      text += "';";
+    }
+    text += '\n';
+  }
+  text.resize(size);
+  return text;
+}
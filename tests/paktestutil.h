@@ -0,0 +1,65 @@
+#ifndef CHROME_PLUS_TESTS_PAKTESTUTIL_H_
+#define CHROME_PLUS_TESTS_PAKTESTUTIL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Builders for synthetic paks shaped like Chrome's resources.pak, shared by
+// the pak tests and benchmarks.
+
+struct PakTestResource {
+  uint16_t resource_id;
+  std::vector<uint8_t> data;
+};
+
+// A pak file of `version` 4 or 5 holding `resources` (sorted by id) and, in
+// v5, `aliases` of (alias id, entry index) sorted by alias id.
+std::vector<uint8_t> BuildPak(
+    int version,
+    std::span<const PakTestResource> resources,
+    std::span<const std::pair<uint16_t, uint16_t>> aliases = {});
+
+// A raw deflate stream (RFC 1951) of `content` from miniz at `level` with
+// `strategy` (an `MZ_*` strategy constant).
+std::vector<uint8_t> DeflateRaw(std::span<const uint8_t> content,
+                                int level,
+                                int strategy = 0);
+
+// `stream` inflated by miniz's `tinfl` into at most `size` bytes, or
+// std::nullopt when it does not decode.
+std::optional<std::vector<uint8_t>> InflateRaw(std::span<const uint8_t> stream,
+                                               size_t size);
+
+// A gzip member (RFC 1952) holding `content`, deflated by miniz at `level`.
+std::vector<uint8_t> GzipMember(std::span<const uint8_t> content,
+                                int level = 9);
+
+// The content of a gzip member, or an empty string when it does not decode.
+std::string GunzipMember(std::span<const uint8_t> member);
+
+#if defined(CHROME_PLUS_BROTLI)
+// A Brotli pak entry as Chrome ships it: the 2-byte magic and 6-byte
+// decompressed size, then the stream at `quality`.
+std::vector<uint8_t> BrotliEntry(std::span<const uint8_t> content,
+                                 int quality = 11);
+
+// The content of a Brotli pak entry, or an empty string when it does not
+// decode.
+std::string UnbrotliEntry(std::span<const uint8_t> entry);
+#endif
+
+// `size` bytes of indented HTML/JS/CSS-like text from `seed`, compressing
+// about as well as the WebUI resources do.
+std::string MakeWebUiText(size_t size, uint32_t seed);
+
+inline std::span<const uint8_t> AsBytes(std::string_view text) {
+  return {reinterpret_cast<const uint8_t*>(text.data()), text.size()};
+}
+
+#endif  // CHROME_PLUS_TESTS_PAKTESTUTIL_H_
@@ -0,0 +1,45 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "pakfile.h"
+#include "paktestutil.h"
+#include "testing.h"
+
+// The gzip write-back of one large WebUI entry after a 4 KB cut: near the
+// end of the document, where the original stream's blocks before it are
+// kept and only the tail is compressed, against the start, where the whole
+// entry is recompressed. Each run patches a fresh copy of the pak.
+BENCHMARK(PakWriteBack, SpliceVsFullRecompression) {
+  const std::string text = MakeWebUiText(512 * 1024, 1);
+  const PakTestResource resources[] = {{1000, GzipMember(AsBytes(text))}};
+  const auto pak = BuildPak(5, resources);
+  std::printf("entry: %zu bytes, %zu compressed\n", text.size(),
+              resources[0].data.size());
+
+  constexpr size_t kCut = 4096;
+  for (const size_t position : {text.size() - 2 * kCut, size_t{64}}) {
+    const std::string label =
+        position == 64 ? "edit at the start (full recompression)"
+                       : "edit near the end (splice)";
+    testing::Measure(label, 10, [&] {
+      auto copy = pak;
+      const auto index = PakIndex::Parse(copy);
+      const uint16_t patched = TraversalGZIPFile(
+          *index,
+          [&](uint8_t* begin, uint32_t size, size_t& new_len) {
+            std::copy(begin + position + kCut, begin + size,
+                      begin + position);
+            new_len = size - kCut;
+            return true;
+          },
+          1000);
+      if (patched == 0) {
+        std::printf("write-back did not fit\n");
+      }
+      testing::KeepAlive(patched);
+    });
+  }
+}
@@ -0,0 +1,53 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <vector>
+
+#include "tabgeometry.h"
+#include "testing.h"
+
+// A horizontal strip of 1,000 tabs, 40 pixels wide and overlapping by 4,
+// hit at points spread over its whole length: the sorted lookup against a
+// rectangle test per tab, as the hit test did before the geometry.
+BENCHMARK(TabGeometry, TabAtVsLinearScan) {
+  constexpr int32_t kTabs = 1000;
+  constexpr int32_t kWidth = 40;
+  constexpr int32_t kOverlap = 4;
+  std::vector<TabGeometry::Tab> tabs;
+  for (int32_t i = 0; i < kTabs; ++i) {
+    const int32_t left = i * (kWidth - kOverlap);
+    tabs.push_back({{left, 0, left + kWidth, 30}, {}, i == kTabs / 2});
+  }
+  const TabGeometry geometry = TabGeometry::Build(tabs, /*vertical=*/false);
+
+  std::vector<int32_t> points(1 << 16);
+  const int32_t strip_length = kTabs * (kWidth - kOverlap) + kOverlap;
+  for (size_t i = 0; i < points.size(); ++i) {
+    points[i] = static_cast<int32_t>((i * 7919) % (strip_length + 200)) - 100;
+  }
+
+  std::printf("  %d tabs, %zu points\n", kTabs, points.size());
+  size_t linear_sum = 0;
+  const double linear = testing::Measure("rectangle per tab", 5, [&] {
+    for (const int32_t x : points) {
+      for (size_t i = 0; i < tabs.size(); ++i) {
+        if (tabs[i].bounds.Contains(x, 10)) {
+          linear_sum += i;
+          break;
+        }
+      }
+    }
+  });
+  size_t lookup_sum = 0;
+  const double lookup = testing::Measure("TabAt", 5, [&] {
+    for (const int32_t x : points) {
+      if (const std::optional<size_t> index = geometry.TabAt(x, 10)) {
+        lookup_sum += *index;
+      }
+    }
+  });
+  testing::KeepAlive(linear_sum);
+  testing::KeepAlive(lookup_sum);
+  std::printf("  %.1fx faster\n", linear / lookup);
+}
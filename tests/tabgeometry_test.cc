@@ -0,0 +1,121 @@
+#include "tabgeometry.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "testing.h"
+
+namespace {
+
+using Tab = TabGeometry::Tab;
+
+// The per-tab rectangle test the geometry replaces.
+std::optional<size_t> LinearTabAt(const std::vector<Tab>& tabs,
+                                  int32_t x,
+                                  int32_t y) {
+  for (size_t i = 0; i < tabs.size(); ++i) {
+    if (tabs[i].bounds.Contains(x, y)) {
+      return i;
+    }
+  }
+  return std::nullopt;
+}
+
+}  // namespace
+
+TEST(TabGeometry, HitsHorizontalTabs) {
+  // Neighbouring tabs overlap by 4 pixels, as in the horizontal strip.
+  const std::vector<Tab> tabs = {{{0, 0, 100, 30}, {}, false},
+                                 {{96, 0, 196, 30}, {}, true},
+                                 {{192, 0, 292, 30}, {}, false}};
+  const TabGeometry geometry = TabGeometry::Build(tabs, /*vertical=*/false);
+
+  EXPECT_EQ(geometry.size(), size_t{3});
+  EXPECT_EQ(geometry.TabAt(50, 10), std::optional<size_t>(0));
+  // The overlap goes to the first tab in tree order.
+  EXPECT_EQ(geometry.TabAt(97, 10), std::optional<size_t>(0));
+  EXPECT_EQ(geometry.TabAt(100, 10), std::optional<size_t>(1));
+  EXPECT_EQ(geometry.TabAt(291, 29), std::optional<size_t>(2));
+  // Right and bottom edges are outside, as with `PtInRect`.
+  EXPECT_EQ(geometry.TabAt(292, 10), std::nullopt);
+  EXPECT_EQ(geometry.TabAt(50, 30), std::nullopt);
+  EXPECT_EQ(geometry.TabAt(-1, 10), std::nullopt);
+  EXPECT_EQ(geometry.selected(), std::optional<size_t>(1));
+}
+
+TEST(TabGeometry, HitsVerticalTabs) {
+  const std::vector<Tab> tabs = {{{0, 100, 240, 140}, {}, false},
+                                 {{0, 140, 240, 180}, {}, false},
+                                 {{0, 180, 240, 220}, {}, false}};
+  const TabGeometry geometry = TabGeometry::Build(tabs, /*vertical=*/true);
+
+  EXPECT_EQ(geometry.TabAt(10, 100), std::optional<size_t>(0));
+  EXPECT_EQ(geometry.TabAt(239, 179), std::optional<size_t>(1));
+  EXPECT_EQ(geometry.TabAt(10, 219), std::optional<size_t>(2));
+  EXPECT_EQ(geometry.TabAt(240, 150), std::nullopt);
+  EXPECT_EQ(geometry.TabAt(10, 99), std::nullopt);
+  EXPECT_EQ(geometry.selected(), std::nullopt);
+}
+
+// Tabs of a collapsed group keep empty bounds: they count, but a point on
+// the group header hits nothing.
+TEST(TabGeometry, CountsButNeverHitsEmptyTabs) {
+  const std::vector<Tab> tabs = {{{0, 0, 100, 30}, {}, false},
+                                 {{}, {}, false},
+                                 {{100, 0, 100, 30}, {}, false},
+                                 {{100, 0, 200, 30}, {}, false}};
+  const TabGeometry geometry = TabGeometry::Build(tabs, /*vertical=*/false);
+
+  EXPECT_EQ(geometry.size(), size_t{4});
+  EXPECT_EQ(geometry.TabAt(0, 0), std::optional<size_t>(0));
+  EXPECT_EQ(geometry.TabAt(100, 10), std::optional<size_t>(3));
+}
+
+TEST(TabGeometry, KeepsCloseButtons) {
+  const std::vector<Tab> tabs = {
+      {{0, 0, 100, 30}, {80, 8, 96, 24}, false},
+      {{96, 0, 196, 30}, {}, false}};
+  const TabGeometry geometry = TabGeometry::Build(tabs, /*vertical=*/false);
+
+  EXPECT_TRUE(geometry.tab(0).close_button.Contains(88, 16));
+  EXPECT_TRUE(geometry.tab(1).close_button.empty());
+}
+
+// Random strips, with overlaps, gaps, out-of-order tabs and hidden ones,
+// answer every point as the linear scan does.
+TEST(TabGeometry, MatchesLinearScan) {
+  std::mt19937 random(1);
+  for (int strip = 0; strip < 2000; ++strip) {
+    const bool vertical = strip % 2 == 1;
+    const int count = static_cast<int>(random() % 60);
+    std::vector<Tab> tabs;
+    int32_t position = static_cast<int32_t>(random() % 50) - 25;
+    for (int i = 0; i < count; ++i) {
+      const int32_t length = static_cast<int32_t>(random() % 40);
+      const int32_t overlap = static_cast<int32_t>(random() % 10);
+      Tab tab;
+      if (random() % 10 != 0) {
+        tab.bounds = vertical
+                         ? TabBounds{0, position, 200, position + length}
+                         : TabBounds{position, 0, position + length, 30};
+      }
+      tabs.push_back(tab);
+      position += length - overlap;
+      if (random() % 7 == 0) {
+        position -= static_cast<int32_t>(random() % 30);
+      }
+    }
+
+    const TabGeometry geometry = TabGeometry::Build(tabs, vertical);
+    for (int point = 0; point < 300; ++point) {
+      const int32_t along = static_cast<int32_t>(random() % 2400) - 100;
+      const int32_t across = static_cast<int32_t>(random() % 40) - 5;
+      const int32_t x = vertical ? across * 6 : along;
+      const int32_t y = vertical ? along : across;
+      ASSERT_EQ(geometry.TabAt(x, y), LinearTabAt(tabs, x, y));
+    }
+  }
+}
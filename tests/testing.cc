@@ -0,0 +1,63 @@
+#include "testing.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace testing {
+namespace {
+
+struct Case {
+  const char* suite;
+  const char* name;
+  CaseBody body;
+};
+
+std::vector<Case>& Cases() {
+  static std::vector<Case> cases;
+  return cases;
+}
+
+size_t failures = 0;
+
+}  // namespace
+
+bool RegisterCase(const char* suite, const char* name, CaseBody body) {
+  Cases().push_back({suite, name, body});
+  return true;
+}
+
+void AddFailure(const char* file, int line, std::string_view expression) {
+  ++failures;
+  std::printf("%s:%d: failed: %.*s\n", file, line,
+              static_cast<int>(expression.size()), expression.data());
+}
+
+}  // namespace testing
+
+// Runs every registered case, or those whose "Suite.Name" contains the first
+// argument.
+int main(int argc, char** argv) {
+  const std::string_view filter = argc > 1 ? argv[1] : "";
+  size_t run = 0;
+  size_t failed = 0;
+  for (const auto& test_case : testing::Cases()) {
+    char full_name[256];
+    std::snprintf(full_name, sizeof(full_name), "%s.%s", test_case.suite,
+                  test_case.name);
+    if (!std::string_view(full_name).contains(filter)) {
+      continue;
+    }
+    std::printf("[ RUN  ] %s\n", full_name);
+    std::fflush(stdout);
+    const size_t before = testing::failures;
+    test_case.body();
+    const bool ok = testing::failures == before;
+    std::printf("[ %s ] %s\n", ok ? " OK " : "FAIL", full_name);
+    ++run;
+    failed += ok ? 0 : 1;
+  }
+  std::printf("%zu cases, %zu failed\n", run, failed);
+  return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+#ifndef CHROME_PLUS_TESTS_TESTING_H_
+#define CHROME_PLUS_TESTS_TESTING_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string_view>
+
+// A deliberately small gtest-style harness: the modules under test are the
+// ones free of Windows calls, and the harness needs nothing beyond the
+// standard library, so tests/ builds with any C++23 host compiler and no
+// network. `TEST` registers a case; `EXPECT_*` records a failure and carries
+// on, `ASSERT_*` records one and returns from the case. `BENCHMARK` cases are
+// built into the separate benchmark binary, which is not run by ctest.
+namespace testing {
+
+using CaseBody = void (*)();
+
+bool RegisterCase(const char* suite, const char* name, CaseBody body);
+
+void AddFailure(const char* file, int line, std::string_view expression);
+
+// Keeps the compiler from discarding a benchmark's result.
+template <typename T>
+void KeepAlive(const T& value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "g"(&value) : "memory");
+#else
+  static volatile const void* sink;
+  sink = &value;
+#endif
+}
+
+// Runs `body` `iterations` times and prints the mean wall time per run.
+template <typename Body>
+double Measure(std::string_view label, size_t iterations, Body&& body) {
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    body();
+  }
+  const std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+  const double per_run = elapsed.count() / static_cast<double>(iterations);
+  std::printf("  %-48.*s %12.2f us/run\n", static_cast<int>(label.size()),
+              label.data(), per_run);
+  return per_run;
+}
+
+}  // namespace testing
+
+#define CHROME_PLUS_CASE(suite, name)                                    \
+  static void suite##_##name##_Body();                                   \
+  [[maybe_unused]] static const bool suite##_##name##_registered =       \
+      ::testing::RegisterCase(#suite, #name, &suite##_##name##_Body);    \
+  static void suite##_##name##_Body()
+
+#define TEST(suite, name) CHROME_PLUS_CASE(suite, name)
+#define BENCHMARK(suite, name) CHROME_PLUS_CASE(suite, name)
+
+#define EXPECT_TRUE(condition)                                      \
+  do {                                                              \
+    if (!(condition)) {                                             \
+      ::testing::AddFailure(__FILE__, __LINE__, #condition);        \
+    }                                                               \
+  } while (false)
+#define EXPECT_FALSE(condition) EXPECT_TRUE(!(condition))
+#define EXPECT_EQ(a, b) EXPECT_TRUE((a) == (b))
+#define EXPECT_NE(a, b) EXPECT_TRUE((a) != (b))
+
+#define ASSERT_TRUE(condition)                                      \
+  do {                                                              \
+    if (!(condition)) {                                             \
+      ::testing::AddFailure(__FILE__, __LINE__, #condition);        \
+      return;                                                       \
+    }                                                               \
+  } while (false)
+#define ASSERT_FALSE(condition) ASSERT_TRUE(!(condition))
+#define ASSERT_EQ(a, b) ASSERT_TRUE((a) == (b))
+
+#endif  // CHROME_PLUS_TESTS_TESTING_H_
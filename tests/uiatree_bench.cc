@@ -0,0 +1,53 @@
+#include <cstddef>
+#include <cstdio>
+#include <string_view>
+
+#include "fakeuiatree.h"
+#include "testing.h"
+#include "uiatree.h"
+#include "uiatreeshapes.h"
+
+// The region search of each shape with a 20,000-node page: the chrome-only
+// breadth-first walk against the window-wide `FindFirst` it replaced, whose
+// pre-order reaches the page before the tab strip. A round trip is one call
+// into Chrome's UI thread; searched nodes are the provider's work inside
+// one `FindFirst`.
+BENCHMARK(UiaTree, RegionSearchVsFindFirst) {
+  struct Shape {
+    const char* name;
+    std::wstring_view outline;
+    const wchar_t* region;
+  };
+  const Shape shapes[] = {
+      {"horizontal", kHorizontalShape, L"HorizontalTabStripRegionView"},
+      {"horizontal old", kHorizontalOldShape,
+       L"HorizontalTabStripRegionViewOld"},
+      {"vertical", kVerticalShape, L"VerticalTabStripRegionView"},
+      {"unified", kUnifiedShape, L"VerticalTabStripRegionView"},
+  };
+  for (const Shape& shape : shapes) {
+    FakeUiaTree tree(shape.outline);
+    tree.AddChildren(tree.Lookup(L"Document"), L"Group", 20000);
+
+    std::printf("  %s\n", shape.name);
+    const double walk = testing::Measure("breadth-first walk", 200, [&] {
+      tree.ResetCounts();
+      testing::KeepAlive(FindShallowDescendantByClasses(
+          tree, tree.root(),
+          {L"HorizontalTabStripRegionView", L"HorizontalTabStripRegionViewOld",
+           L"VerticalTabStripRegionView"},
+          /*max_visited=*/256));
+    });
+    const size_t walk_round_trips = tree.round_trips();
+    const size_t walk_visits = tree.visited().size();
+    const double find_first = testing::Measure("window FindFirst", 200, [&] {
+      tree.ResetCounts();
+      testing::KeepAlive(tree.FindFirst(tree.root(), shape.region));
+    });
+    std::printf(
+        "    walk: %zu round trips, %zu nodes read; FindFirst: 1 round trip, "
+        "%zu nodes searched (%.1fx the walk's time)\n",
+        walk_round_trips, walk_visits, tree.searched_nodes(),
+        find_first / walk);
+  }
+}
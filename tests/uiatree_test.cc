@@ -0,0 +1,174 @@
+#include "uiatree.h"
+
+#include <initializer_list>
+#include <optional>
+#include <string_view>
+
+#include "fakeuiatree.h"
+#include "testing.h"
+#include "uiatreeshapes.h"
+
+namespace {
+
+using Node = FakeUiaTree::Node;
+using TabContainer = BasicTabContainer<Node>;
+
+// The searches `ResolveTabUi` runs, with its budgets.
+ShallowSearchResult<Node> FindRegion(const FakeUiaTree& tree, Node anchor) {
+  return FindShallowDescendantByClasses(
+      tree, anchor,
+      {L"HorizontalTabStripRegionView", L"HorizontalTabStripRegionViewOld",
+       L"VerticalTabStripRegionView"},
+      /*max_visited=*/256);
+}
+
+ShallowSearchResult<Node> FindFullscreenContainer(const FakeUiaTree& tree) {
+  return FindShallowDescendantByClasses(
+      tree, tree.root(),
+      {L"TabContainerImpl", L"VerticalUnpinnedTabContainerView",
+       L"UnpinnedTabContainerView"},
+      /*max_visited=*/512);
+}
+
+std::optional<TabContainer> FindContainer(const FakeUiaTree& tree,
+                                          const ShallowSearchResult<Node>& r) {
+  return FindTabContainerInRegion(
+      tree, r.node, r.class_name == L"VerticalTabStripRegionView");
+}
+
+// The walk never reads a node of the page: not below the content view, and
+// not below a node hosting its own window.
+bool StayedOffContent(const FakeUiaTree& tree) {
+  return !tree.VisitedBelow(tree.Lookup(L"ContentsWebView")) &&
+         !tree.VisitedBelow(tree.Lookup(L"Chrome_RenderWidgetHostHWND")) &&
+         !tree.VisitedBelow(tree.Lookup(L"Intermediate D3D Window"));
+}
+
+}  // namespace
+
+// The round trips below are what each shape costs today; a change to the
+// searches that moves them should do so on purpose.
+TEST(UiaTree, ResolvesHorizontalStrip) {
+  for (const std::wstring_view shape :
+       {kHorizontalShape, kHorizontalOldShape}) {
+    FakeUiaTree tree(shape);
+    const auto region = FindRegion(tree, tree.root());
+    ASSERT_TRUE(region.node != nullptr);
+    EXPECT_EQ(region.node->class_name, region.class_name);
+    EXPECT_EQ(tree.round_trips(), size_t{33});
+    EXPECT_EQ(tree.visited().size(), size_t{8});
+    EXPECT_TRUE(StayedOffContent(tree));
+
+    tree.ResetCounts();
+    const auto container = FindContainer(tree, region);
+    ASSERT_TRUE(container.has_value());
+    EXPECT_TRUE(container->element == tree.Lookup(L"TabContainerImpl"));
+    EXPECT_TRUE(container->kind == TabContainerKind::kHorizontal);
+    EXPECT_EQ(tree.round_trips(), size_t{3});
+  }
+}
+
+TEST(UiaTree, ResolvesVerticalStrip) {
+  FakeUiaTree tree(kVerticalShape);
+  const auto region = FindRegion(tree, tree.root());
+  ASSERT_TRUE(region.node != nullptr);
+  EXPECT_EQ(region.class_name, std::wstring(L"VerticalTabStripRegionView"));
+  EXPECT_EQ(tree.round_trips(), size_t{32});
+  EXPECT_TRUE(StayedOffContent(tree));
+
+  tree.ResetCounts();
+  const auto container = FindContainer(tree, region);
+  ASSERT_TRUE(container.has_value());
+  EXPECT_TRUE(container->element ==
+              tree.Lookup(L"VerticalUnpinnedTabContainerView"));
+  EXPECT_TRUE(container->kind == TabContainerKind::kVertical);
+  EXPECT_EQ(tree.round_trips(), size_t{1});
+}
+
+// The unified strip hides below `TabStripView` from walker navigation until
+// a scoped search has touched it, so only `FindFirst` can reach it.
+TEST(UiaTree, ResolvesUnifiedStrip) {
+  FakeUiaTree tree(kUnifiedShape);
+  const Node tab_strip_view = tree.Lookup(L"TabStripView");
+  EXPECT_TRUE(tree.FirstChild(tab_strip_view) == nullptr);
+
+  const auto region = FindRegion(tree, tree.root());
+  ASSERT_TRUE(region.node != nullptr);
+  EXPECT_EQ(region.class_name, std::wstring(L"VerticalTabStripRegionView"));
+
+  tree.ResetCounts();
+  const auto container = FindContainer(tree, region);
+  ASSERT_TRUE(container.has_value());
+  EXPECT_TRUE(container->element == tree.Lookup(L"UnpinnedTabContainerView"));
+  EXPECT_TRUE(container->kind == TabContainerKind::kUnified);
+  EXPECT_EQ(tree.round_trips(), size_t{2});
+  EXPECT_TRUE(tree.FirstChild(tab_strip_view) != nullptr);
+}
+
+// Fullscreen hides the strip from the control view; the raw-view fallback
+// finds the container itself.
+TEST(UiaTree, FallsBackToRawViewInFullscreen) {
+  FakeUiaTree control(kFullscreenShape);
+  const auto region = FindRegion(control, control.root());
+  EXPECT_TRUE(region.node == nullptr);
+  EXPECT_FALSE(region.budget_exhausted);
+  EXPECT_TRUE(StayedOffContent(control));
+
+  FakeUiaTree raw(kFullscreenShape, FakeUiaTree::View::kRaw);
+  const auto container = FindFullscreenContainer(raw);
+  ASSERT_TRUE(container.node != nullptr);
+  EXPECT_TRUE(container.node == raw.Lookup(L"TabContainerImpl"));
+  EXPECT_TRUE(GetTabContainerKind(container.class_name) ==
+              TabContainerKind::kHorizontal);
+  EXPECT_EQ(raw.round_trips(), size_t{64});
+  EXPECT_TRUE(StayedOffContent(raw));
+}
+
+// With the find bar open the window answers with the find bar's fragment:
+// no region, but the find bar is found within its small budget, and the
+// region search restarts from the recovered browser view.
+TEST(UiaTree, RecoversFromFindBar) {
+  FakeUiaTree find_bar(kFindBarShape);
+  EXPECT_TRUE(FindRegion(find_bar, find_bar.root()).node == nullptr);
+  EXPECT_TRUE(FindShallowDescendantByClasses(find_bar, find_bar.root(),
+                                             {L"FindBarView"},
+                                             /*max_visited=*/32)
+                  .node != nullptr);
+
+  FakeUiaTree browser(kHorizontalShape);
+  const auto region = FindRegion(browser, browser.Lookup(L"BrowserView"));
+  ASSERT_TRUE(region.node != nullptr);
+  EXPECT_EQ(browser.round_trips(), size_t{14});
+}
+
+// A page of any size costs the region search nothing.
+TEST(UiaTree, IgnoresPageSize) {
+  FakeUiaTree tree(kHorizontalShape);
+  tree.AddChildren(tree.Lookup(L"Document"), L"Group", 10000);
+  tree.AddChildren(tree.Lookup(L"Intermediate D3D Window"), L"Pane", 10);
+  EXPECT_TRUE(FindRegion(tree, tree.root()).node != nullptr);
+  EXPECT_EQ(tree.round_trips(), size_t{33});
+  EXPECT_TRUE(StayedOffContent(tree));
+}
+
+TEST(UiaTree, ReportsExhaustedBudget) {
+  FakeUiaTree tree(kHorizontalShape);
+  const auto result = FindShallowDescendantByClasses(
+      tree, tree.root(), {L"HorizontalTabStripRegionView"},
+      /*max_visited=*/5);
+  EXPECT_TRUE(result.node == nullptr);
+  EXPECT_TRUE(result.budget_exhausted);
+  EXPECT_EQ(tree.visited().size(), size_t{5});
+}
+
+TEST(UiaTree, FindsSiblingsBothWays) {
+  FakeUiaTree tree(kHorizontalShape);
+  const Node drag_context = tree.Lookup(L"TabStrip::TabDragContextImpl");
+  const Node container = tree.Lookup(L"TabContainerImpl");
+  EXPECT_TRUE(FindSiblingByClass(tree, drag_context, L"TabContainerImpl") ==
+              container);
+  EXPECT_TRUE(FindSiblingByClass(tree, container,
+                                 L"TabStrip::TabDragContextImpl") ==
+              drag_context);
+  EXPECT_TRUE(FindSiblingByClass(tree, container, L"Tab") == nullptr);
+}
@@ -0,0 +1,186 @@
+#include "uiatreeshapes.h"
+
+#include <string_view>
+
+const std::wstring_view kHorizontalShape = LR"(
+Chrome_WidgetWin_1
+  Intermediate D3D Window [hwnd]
+  BrowserRootView
+    NonClientView
+      GlassBrowserFrameView
+        BrowserView
+          TopContainerView
+            ToolbarView
+              BackForwardButton
+              ReloadButton
+              LocationBarView
+                OmniboxViewViews
+              ExtensionsToolbarContainer
+              BrowserAppMenuButton
+            BookmarkBarView
+              BookmarkButton
+              BookmarkButton
+          View
+            ContentsWebView
+              Chrome_RenderWidgetHostHWND [hwnd]
+                Document
+                  Group
+                  Link
+          HorizontalTabStripRegionView
+            TabStripScrollContainer
+              TabStrip
+                TabStrip::TabDragContextImpl
+                TabContainerImpl
+                  Tab
+                    TabIcon
+                    TabCloseButton
+                  Tab
+                    TabIcon
+                    TabCloseButton
+                  Tab
+                    TabIcon
+                    TabCloseButton
+            TabStripControlButton
+            TabSearchButton
+)";
+
+const std::wstring_view kHorizontalOldShape = LR"(
+Chrome_WidgetWin_1
+  Intermediate D3D Window [hwnd]
+  BrowserRootView
+    NonClientView
+      BrowserFrameViewWin
+        BrowserView
+          TopContainerView
+            ToolbarView
+              BackForwardButton
+              ReloadButton
+              LocationBarView
+                OmniboxViewViews
+              ExtensionsToolbarContainer
+              BrowserAppMenuButton
+            BookmarkBarView
+              BookmarkButton
+              BookmarkButton
+          View
+            MultiContentsView
+              ContentsContainerView
+                ContentsWebView
+                  Chrome_RenderWidgetHostHWND [hwnd]
+                    Document
+                      Group
+                      Link
+          HorizontalTabStripRegionViewOld
+            TabStripScrollContainer
+              TabStrip
+                TabStrip::TabDragContextImpl
+                TabContainerImpl
+                  Tab
+                    TabIcon
+                    TabCloseButton
+                  Tab
+                    TabIcon
+                    TabCloseButton
+            TabStripControlButton
+)";
+
+const std::wstring_view kVerticalShape = LR"(
+Chrome_WidgetWin_1
+  Intermediate D3D Window [hwnd]
+  BrowserRootView
+    NonClientView
+      GlassBrowserFrameView
+        BrowserView
+          TopContainerView
+            ToolbarView
+              BackForwardButton
+              LocationBarView
+                OmniboxViewViews
+              BrowserAppMenuButton
+          View
+            MultiContentsView
+              ContentsWebView
+                Chrome_RenderWidgetHostHWND [hwnd]
+                  Document
+          VerticalTabStripRegionView
+            VerticalTabStripHeader
+            ScrollView
+              Viewport
+                VerticalPinnedTabContainerView
+                  VerticalTabView
+                VerticalUnpinnedTabContainerView
+                  VerticalTabView
+                  VerticalTabView
+                  VerticalTabView
+            TabStripControlButton
+)";
+
+const std::wstring_view kUnifiedShape = LR"(
+Chrome_WidgetWin_1
+  Intermediate D3D Window [hwnd]
+  BrowserRootView
+    NonClientView
+      BrowserFrameViewWin
+        BrowserView
+          TopContainerView
+            ToolbarView
+              BackForwardButton
+              LocationBarView
+                OmniboxViewViews
+              BrowserAppMenuButton
+          View
+            MultiContentsView
+              ContentsContainerView
+                ContentsWebView
+                  Chrome_RenderWidgetHostHWND [hwnd]
+                    Document
+          VerticalTabStripRegionView
+            TabStripView [lazy]
+              ScrollView
+                Viewport
+                  PinnedTabContainerView
+                    TabView
+                  UnpinnedTabContainerView
+                    TabView
+                    TabView
+                    TabView
+            TabStripControlButton
+)";
+
+const std::wstring_view kFullscreenShape = LR"(
+Chrome_WidgetWin_1
+  Intermediate D3D Window [hwnd]
+  BrowserRootView
+    NonClientView
+      GlassBrowserFrameView
+        BrowserView
+          TopContainerView [raw]
+            ToolbarView
+              LocationBarView
+                OmniboxViewViews
+          View
+            MultiContentsView
+              ContentsWebView
+                Chrome_RenderWidgetHostHWND [hwnd]
+                  Document
+          HorizontalTabStripRegionView [raw]
+            TabStripScrollContainer
+              TabStrip
+                TabStrip::TabDragContextImpl
+                TabContainerImpl
+                  Tab
+                  Tab
+          FullscreenControlHost
+)";
+
+const std::wstring_view kFindBarShape = LR"(
+Chrome_WidgetWin_1
+  RootView
+    FindBarView
+      Textfield
+      Label
+      View
+      ImageButton
+      ImageButton
+      ImageButton
+)";
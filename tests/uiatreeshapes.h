@@ -0,0 +1,29 @@
+#ifndef CHROME_PLUS_TESTS_UIATREESHAPES_H_
+#define CHROME_PLUS_TESTS_UIATREESHAPES_H_
+
+#include <string_view>
+
+// Control-view shapes of a browser window as `ElementFromHandle` exposes
+// them, in `FakeUiaTree`'s outline format, trimmed to a few nodes per
+// toolbar, bookmark bar and page. The sibling order is what the searches
+// depend on: the content branch precedes the tab strip region.
+
+// Chrome 120 to 151, horizontal tabs.
+extern const std::wstring_view kHorizontalShape;
+// Chrome 152, horizontal tabs: the region is `HorizontalTabStripRegionViewOld`.
+extern const std::wstring_view kHorizontalOldShape;
+// Chrome 120 to 151, vertical tabs.
+extern const std::wstring_view kVerticalShape;
+// Chrome 152, vertical tabs on the unified TabCollectionNode system: the
+// strip below `TabStripView` materializes only once a scoped search has
+// touched it.
+extern const std::wstring_view kUnifiedShape;
+// A fullscreen window: the top container and the tab strip region are in
+// the raw view only.
+extern const std::wstring_view kFullscreenShape;
+// A window with the find bar open: `ElementFromHandle` answers with the find
+// bar widget's fragment, and the browser view must be recovered from a point
+// on the browser chrome.
+extern const std::wstring_view kFindBarShape;
+
+#endif  // CHROME_PLUS_TESTS_UIATREESHAPES_H_